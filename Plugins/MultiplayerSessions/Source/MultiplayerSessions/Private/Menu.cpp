@@ -95,38 +95,24 @@ void UMenu::OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResu
 {
   if (!MultiplayerSessionsSubsystem) return;
 
-  for (const FOnlineSessionSearchResult& sessionResult : SessionResults)
+  // Results are already filtered to our match type and build and sorted best first
+  if (SessionResults.Num() > 0)
   {
-    FString settingsValue;
-    sessionResult.Session.SessionSettings.Get(FName("MatchType"), settingsValue);
-    if (settingsValue == MatchType)
-    {
-      MultiplayerSessionsSubsystem->JoinSession(sessionResult);
-      return;
-    }
-  }
-  if (!bWasSuccessful || SessionResults.Num() <= 0)
-  {
-    JoinButton->SetIsEnabled(true);
+    MultiplayerSessionsSubsystem->JoinSession(SessionResults[0]);
+    return;
   }
+  JoinButton->SetIsEnabled(true);
 }
 
 void UMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
 {
-  IOnlineSubsystem* subsystem = IOnlineSubsystem::Get();
-  if (subsystem)
+  FString address;
+  if (MultiplayerSessionsSubsystem && MultiplayerSessionsSubsystem->GetResolvedConnectString(address))
   {
-    IOnlineSessionPtr sessionInterface = subsystem->GetSessionInterface();
-    if (sessionInterface.IsValid())
+    APlayerController* playerController = GetGameInstance()->GetFirstLocalPlayerController();
+    if (playerController)
     {
-      FString address;
-      sessionInterface->GetResolvedConnectString(NAME_GameSession, address);
-
-      APlayerController* playerController = GetGameInstance()->GetFirstLocalPlayerController();
-      if (playerController)
-      {
-        playerController->ClientTravel(address, ETravelType::TRAVEL_Absolute);
-      }
+      playerController->ClientTravel(address, ETravelType::TRAVEL_Absolute);
     }
   }
   if (Result != EOnJoinSessionCompleteResult::Success)
@@ -157,7 +143,7 @@ void UMenu::JoinButtonClicked()
   JoinButton->SetIsEnabled(false);
   if (MultiplayerSessionsSubsystem)
   {
-    MultiplayerSessionsSubsystem->FindSessions(10000);
+    MultiplayerSessionsSubsystem->FindSessions(100, MatchType);
   }
 }
 
@@ -0,0 +1,369 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionBackend.h"
+#include "OnlineSubsystemTypes.h"
+#include "Online/OnlineSessionNames.h"
+
+FDelegateHandle FMultiplayerSessionBackend::AddOnCreateSessionCompleteDelegate_Handle(const FOnCreateSessionCompleteDelegate& delegate)
+{
+  ++NumBoundDelegates;
+  return OnCreateSessionComplete.Add(delegate);
+}
+
+void FMultiplayerSessionBackend::ClearOnCreateSessionCompleteDelegate_Handle(FDelegateHandle& handle)
+{
+  NumBoundDelegates -= OnCreateSessionComplete.Remove(handle) ? 1 : 0;
+  handle.Reset();
+}
+
+FDelegateHandle FMultiplayerSessionBackend::AddOnFindSessionsCompleteDelegate_Handle(const FOnFindSessionsCompleteDelegate& delegate)
+{
+  ++NumBoundDelegates;
+  return OnFindSessionsComplete.Add(delegate);
+}
+
+void FMultiplayerSessionBackend::ClearOnFindSessionsCompleteDelegate_Handle(FDelegateHandle& handle)
+{
+  NumBoundDelegates -= OnFindSessionsComplete.Remove(handle) ? 1 : 0;
+  handle.Reset();
+}
+
+FDelegateHandle FMultiplayerSessionBackend::AddOnJoinSessionCompleteDelegate_Handle(const FOnJoinSessionCompleteDelegate& delegate)
+{
+  ++NumBoundDelegates;
+  return OnJoinSessionComplete.Add(delegate);
+}
+
+void FMultiplayerSessionBackend::ClearOnJoinSessionCompleteDelegate_Handle(FDelegateHandle& handle)
+{
+  NumBoundDelegates -= OnJoinSessionComplete.Remove(handle) ? 1 : 0;
+  handle.Reset();
+}
+
+FDelegateHandle FMultiplayerSessionBackend::AddOnDestroySessionCompleteDelegate_Handle(const FOnDestroySessionCompleteDelegate& delegate)
+{
+  ++NumBoundDelegates;
+  return OnDestroySessionComplete.Add(delegate);
+}
+
+void FMultiplayerSessionBackend::ClearOnDestroySessionCompleteDelegate_Handle(FDelegateHandle& handle)
+{
+  NumBoundDelegates -= OnDestroySessionComplete.Remove(handle) ? 1 : 0;
+  handle.Reset();
+}
+
+FDelegateHandle FMultiplayerSessionBackend::AddOnStartSessionCompleteDelegate_Handle(const FOnStartSessionCompleteDelegate& delegate)
+{
+  ++NumBoundDelegates;
+  return OnStartSessionComplete.Add(delegate);
+}
+
+void FMultiplayerSessionBackend::ClearOnStartSessionCompleteDelegate_Handle(FDelegateHandle& handle)
+{
+  NumBoundDelegates -= OnStartSessionComplete.Remove(handle) ? 1 : 0;
+  handle.Reset();
+}
+
+/**
+ * Online subsystem
+ */
+
+FOnlineSubsystemSessionBackend::FOnlineSubsystemSessionBackend(IOnlineSessionPtr inSessionInterface) :
+  SessionInterface(inSessionInterface)
+{
+  if (!SessionInterface.IsValid()) return;
+
+  // The subsystem's delegates are rebroadcast, the subsystem only ever binds to this backend
+  CreateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(FOnCreateSessionCompleteDelegate::CreateLambda([this](FName sessionName, bool bWasSuccessful)
+  {
+    OnCreateSessionComplete.Broadcast(sessionName, bWasSuccessful);
+  }));
+  FindHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda([this](bool bWasSuccessful)
+  {
+    OnFindSessionsComplete.Broadcast(bWasSuccessful);
+  }));
+  JoinHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(FOnJoinSessionCompleteDelegate::CreateLambda([this](FName sessionName, EOnJoinSessionCompleteResult::Type result)
+  {
+    OnJoinSessionComplete.Broadcast(sessionName, result);
+  }));
+  DestroyHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(FOnDestroySessionCompleteDelegate::CreateLambda([this](FName sessionName, bool bWasSuccessful)
+  {
+    OnDestroySessionComplete.Broadcast(sessionName, bWasSuccessful);
+  }));
+  StartHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(FOnStartSessionCompleteDelegate::CreateLambda([this](FName sessionName, bool bWasSuccessful)
+  {
+    OnStartSessionComplete.Broadcast(sessionName, bWasSuccessful);
+  }));
+}
+
+FOnlineSubsystemSessionBackend::~FOnlineSubsystemSessionBackend()
+{
+  if (!SessionInterface.IsValid()) return;
+
+  SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateHandle);
+  SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindHandle);
+  SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinHandle);
+  SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroyHandle);
+  SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartHandle);
+}
+
+bool FOnlineSubsystemSessionBackend::CreateSession(const FUniqueNetIdPtr& hostingPlayerId, FName sessionName, const FOnlineSessionSettings& newSessionSettings)
+{
+  return SessionInterface.IsValid() && hostingPlayerId.IsValid() && SessionInterface->CreateSession(*hostingPlayerId, sessionName, newSessionSettings);
+}
+
+bool FOnlineSubsystemSessionBackend::FindSessions(const FUniqueNetIdPtr& searchingPlayerId, const TSharedRef<FOnlineSessionSearch>& searchSettings)
+{
+  return SessionInterface.IsValid() && searchingPlayerId.IsValid() && SessionInterface->FindSessions(*searchingPlayerId, searchSettings);
+}
+
+bool FOnlineSubsystemSessionBackend::JoinSession(const FUniqueNetIdPtr& playerId, FName sessionName, const FOnlineSessionSearchResult& desiredSession)
+{
+  return SessionInterface.IsValid() && playerId.IsValid() && SessionInterface->JoinSession(*playerId, sessionName, desiredSession);
+}
+
+bool FOnlineSubsystemSessionBackend::DestroySession(FName sessionName)
+{
+  return SessionInterface.IsValid() && SessionInterface->DestroySession(sessionName);
+}
+
+bool FOnlineSubsystemSessionBackend::StartSession(FName sessionName)
+{
+  return SessionInterface.IsValid() && SessionInterface->StartSession(sessionName);
+}
+
+FNamedOnlineSession* FOnlineSubsystemSessionBackend::GetNamedSession(FName sessionName)
+{
+  return SessionInterface.IsValid() ? SessionInterface->GetNamedSession(sessionName) : nullptr;
+}
+
+bool FOnlineSubsystemSessionBackend::GetResolvedConnectString(FName sessionName, FString& connectInfo)
+{
+  return SessionInterface.IsValid() && SessionInterface->GetResolvedConnectString(sessionName, connectInfo);
+}
+
+/**
+ * Loopback
+ */
+
+namespace
+{
+  class FLoopbackSessionInfo : public FOnlineSessionInfo
+  {
+  public:
+    explicit FLoopbackSessionInfo(const FString& id) : SessionId(FUniqueNetIdString::Create(id, FName("Loopback"))) {}
+
+    virtual const uint8* GetBytes() const override { return nullptr; }
+    virtual int32 GetSize() const override { return sizeof(FLoopbackSessionInfo); }
+    virtual bool IsValid() const override { return true; }
+    virtual FString ToString() const override { return SessionId->ToString(); }
+    virtual FString ToDebugString() const override { return ToString(); }
+    virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+
+  private:
+    FUniqueNetIdRef SessionId;
+  };
+
+  struct FLoopbackHostedSession
+  {
+    FOnlineSessionSettings Settings;
+    int32 OpenSlots = 0;
+  };
+
+  // Sessions hosted by every loopback backend in the process, by session id
+  TMap<FString, FLoopbackHostedSession> LoopbackRegistry;
+  int32 NextLoopbackSessionId = 0;
+}
+
+FLoopbackSessionBackend::FLoopbackSessionBackend(float inMinLatency, float inMaxLatency, float inFailureRate) :
+  MinLatency(FMath::Max(inMinLatency, 0.f)),
+  MaxLatency(FMath::Max(inMaxLatency, inMinLatency)),
+  FailureRate(FMath::Clamp(inFailureRate, 0.f, 1.f))
+{
+}
+
+FLoopbackSessionBackend::~FLoopbackSessionBackend()
+{
+  for (const TPair<FName, TSharedPtr<FNamedOnlineSession>>& session : NamedSessions)
+  {
+    if (session.Value->bHosting && session.Value->SessionInfo.IsValid())
+    {
+      LoopbackRegistry.Remove(session.Value->SessionInfo->ToString());
+    }
+  }
+}
+
+int32 FLoopbackSessionBackend::GetNumRegisteredSessions()
+{
+  return LoopbackRegistry.Num();
+}
+
+void FLoopbackSessionBackend::Complete(TFunction<void(bool bFailed)> completion)
+{
+  const bool bFailed = FMath::FRand() < FailureRate;
+  TWeakPtr<FLoopbackSessionBackend> weakThis = AsShared();
+  FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([weakThis, bFailed, completion = MoveTemp(completion)](float)
+  {
+    // A backend destroyed while an operation was in flight completes nothing
+    if (weakThis.IsValid())
+    {
+      completion(bFailed);
+    }
+    return false;
+  }), FMath::FRandRange(MinLatency, MaxLatency));
+}
+
+bool FLoopbackSessionBackend::CreateSession(const FUniqueNetIdPtr& hostingPlayerId, FName sessionName, const FOnlineSessionSettings& newSessionSettings)
+{
+  if (NamedSessions.Contains(sessionName)) return false;
+
+  TSharedPtr<FNamedOnlineSession> session = MakeShared<FNamedOnlineSession>(sessionName, newSessionSettings);
+  session->bHosting = true;
+  session->NumOpenPublicConnections = newSessionSettings.NumPublicConnections;
+  session->SessionState = EOnlineSessionState::Creating;
+  NamedSessions.Add(sessionName, session);
+
+  Complete([this, sessionName, session](bool bFailed)
+  {
+    if (bFailed)
+    {
+      NamedSessions.Remove(sessionName);
+      OnCreateSessionComplete.Broadcast(sessionName, false);
+      return;
+    }
+    const FString sessionId = FString::Printf(TEXT("Loopback-%d"), NextLoopbackSessionId++);
+    session->SessionInfo = MakeShared<FLoopbackSessionInfo>(sessionId);
+    session->SessionState = EOnlineSessionState::Pending;
+    FLoopbackHostedSession& hosted = LoopbackRegistry.Add(sessionId);
+    hosted.Settings = session->SessionSettings;
+    hosted.OpenSlots = session->SessionSettings.NumPublicConnections;
+    OnCreateSessionComplete.Broadcast(sessionName, true);
+  });
+  return true;
+}
+
+bool FLoopbackSessionBackend::FindSessions(const FUniqueNetIdPtr& searchingPlayerId, const TSharedRef<FOnlineSessionSearch>& searchSettings)
+{
+  searchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+  const float latency = FMath::FRandRange(MinLatency, MaxLatency);
+
+  Complete([this, searchSettings, latency](bool bFailed)
+  {
+    searchSettings->SearchResults.Reset();
+    if (bFailed)
+    {
+      searchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+      OnFindSessionsComplete.Broadcast(false);
+      return;
+    }
+
+    FString matchType;
+    const bool bFilterMatchType = searchSettings->QuerySettings.Get(FName("MatchType"), matchType);
+    int32 minSlots = 0;
+    searchSettings->QuerySettings.Get(SEARCH_MINSLOTSAVAILABLE, minSlots);
+    for (const TPair<FString, FLoopbackHostedSession>& hosted : LoopbackRegistry)
+    {
+      if (searchSettings->SearchResults.Num() >= searchSettings->MaxSearchResults) break;
+      if (hosted.Value.OpenSlots < minSlots) continue;
+
+      FString hostedMatchType;
+      hosted.Value.Settings.Get(FName("MatchType"), hostedMatchType);
+      if (bFilterMatchType && hostedMatchType != matchType) continue;
+
+      FOnlineSessionSearchResult& result = searchSettings->SearchResults.AddDefaulted_GetRef();
+      result.Session = FOnlineSession(hosted.Value.Settings);
+      result.Session.SessionInfo = MakeShared<FLoopbackSessionInfo>(hosted.Key);
+      result.Session.NumOpenPublicConnections = hosted.Value.OpenSlots;
+      result.PingInMs = FMath::RoundToInt(latency * 1000.f);
+    }
+    searchSettings->SearchState = EOnlineAsyncTaskState::Done;
+    OnFindSessionsComplete.Broadcast(true);
+  });
+  return true;
+}
+
+bool FLoopbackSessionBackend::JoinSession(const FUniqueNetIdPtr& playerId, FName sessionName, const FOnlineSessionSearchResult& desiredSession)
+{
+  if (NamedSessions.Contains(sessionName) || !desiredSession.IsValid()) return false;
+
+  const FString sessionId = desiredSession.GetSessionIdStr();
+  Complete([this, sessionName, sessionId](bool bFailed)
+  {
+    FLoopbackHostedSession* hosted = LoopbackRegistry.Find(sessionId);
+    if (bFailed || hosted == nullptr || hosted->OpenSlots <= 0)
+    {
+      OnJoinSessionComplete.Broadcast(sessionName, hosted == nullptr ? EOnJoinSessionCompleteResult::SessionDoesNotExist :
+        hosted->OpenSlots <= 0 ? EOnJoinSessionCompleteResult::SessionIsFull : EOnJoinSessionCompleteResult::UnknownError);
+      return;
+    }
+    --hosted->OpenSlots;
+
+    TSharedPtr<FNamedOnlineSession> session = MakeShared<FNamedOnlineSession>(sessionName, hosted->Settings);
+    session->SessionInfo = MakeShared<FLoopbackSessionInfo>(sessionId);
+    session->SessionState = EOnlineSessionState::Pending;
+    NamedSessions.Add(sessionName, session);
+    OnJoinSessionComplete.Broadcast(sessionName, EOnJoinSessionCompleteResult::Success);
+  });
+  return true;
+}
+
+bool FLoopbackSessionBackend::DestroySession(FName sessionName)
+{
+  TSharedPtr<FNamedOnlineSession> session = NamedSessions.FindRef(sessionName);
+  if (!session.IsValid()) return false;
+
+  session->SessionState = EOnlineSessionState::Destroying;
+  Complete([this, sessionName, session](bool bFailed)
+  {
+    if (bFailed)
+    {
+      session->SessionState = EOnlineSessionState::Pending;
+      OnDestroySessionComplete.Broadcast(sessionName, false);
+      return;
+    }
+    if (session->SessionInfo.IsValid())
+    {
+      const FString sessionId = session->SessionInfo->ToString();
+      if (session->bHosting)
+      {
+        LoopbackRegistry.Remove(sessionId);
+      }
+      else if (FLoopbackHostedSession* hosted = LoopbackRegistry.Find(sessionId))
+      {
+        ++hosted->OpenSlots;
+      }
+    }
+    NamedSessions.Remove(sessionName);
+    OnDestroySessionComplete.Broadcast(sessionName, true);
+  });
+  return true;
+}
+
+bool FLoopbackSessionBackend::StartSession(FName sessionName)
+{
+  TSharedPtr<FNamedOnlineSession> session = NamedSessions.FindRef(sessionName);
+  if (!session.IsValid() || session->SessionState != EOnlineSessionState::Pending) return false;
+
+  session->SessionState = EOnlineSessionState::Starting;
+  Complete([this, sessionName, session](bool bFailed)
+  {
+    session->SessionState = bFailed ? EOnlineSessionState::Pending : EOnlineSessionState::InProgress;
+    OnStartSessionComplete.Broadcast(sessionName, !bFailed);
+  });
+  return true;
+}
+
+FNamedOnlineSession* FLoopbackSessionBackend::GetNamedSession(FName sessionName)
+{
+  TSharedPtr<FNamedOnlineSession>* session = NamedSessions.Find(sessionName);
+  return session ? session->Get() : nullptr;
+}
+
+bool FLoopbackSessionBackend::GetResolvedConnectString(FName sessionName, FString& connectInfo)
+{
+  if (!NamedSessions.Contains(sessionName)) return false;
+
+  connectInfo = TEXT("127.0.0.1:7777");
+  return true;
+}
@@ -0,0 +1,323 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionsBenchmark.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionBackend.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CoreMisc.h"
+#include "UObject/Package.h"
+
+namespace
+{
+  const TCHAR* OperationNames[] = { TEXT("Create"), TEXT("Find"), TEXT("Join"), TEXT("Destroy") };
+
+  // Without progress for this long the run is reported as stalled, an operation never completed
+  constexpr double StallTimeout = 30.0;
+  constexpr int32 MaxDestroyRetries = 5;
+
+  double Percentile(TArray<double>& sortedSamples, double fraction)
+  {
+    if (sortedSamples.Num() == 0) return 0.0;
+    const int32 index = FMath::Clamp(FMath::CeilToInt(fraction * sortedSamples.Num()) - 1, 0, sortedSamples.Num() - 1);
+    return sortedSamples[index];
+  }
+
+  FAutoConsoleCommand SessionsBenchmarkCommand(
+    TEXT("Sessions.Benchmark"),
+    TEXT("Sessions.Benchmark [Cycles=1000] [Concurrency=100] [FailureRate=0] [MinLatency=0.01] [MaxLatency=0.1] [exit]\n")
+    TEXT("Runs create/find/join/destroy cycles on loopback backends and logs latency percentiles and leaked delegates."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+    {
+      auto argOr = [&args](int32 index, const TCHAR* fallback) { return args.IsValidIndex(index) ? args[index] : FString(fallback); };
+      const bool bExit = args.Contains(TEXT("exit"));
+
+      UMultiplayerSessionsBenchmark* benchmark = NewObject<UMultiplayerSessionsBenchmark>(GetTransientPackage());
+      benchmark->AddToRoot();
+      benchmark->Start(
+        FCString::Atoi(*argOr(0, TEXT("1000"))),
+        FCString::Atoi(*argOr(1, TEXT("100"))),
+        FCString::Atof(*argOr(2, TEXT("0"))),
+        FCString::Atof(*argOr(3, TEXT("0.01"))),
+        FCString::Atof(*argOr(4, TEXT("0.1"))),
+        bExit);
+    }));
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::Setup(UMultiplayerSessionsBenchmark* inBenchmark, int32 index, float minLatency, float maxLatency, float failureRate)
+{
+  Benchmark = inBenchmark;
+  MatchType = FString::Printf(TEXT("Bench%d"), index);
+
+  Host = NewObject<UMultiplayerSessionsSubsystem>(this);
+  Joiner = NewObject<UMultiplayerSessionsSubsystem>(this);
+  for (UMultiplayerSessionsSubsystem* subsystem : { Host, Joiner })
+  {
+    subsystem->SessionInterface = MakeShared<FLoopbackSessionBackend>(minLatency, maxLatency, failureRate);
+    subsystem->bIsLanBackend = true;
+    // Every find has to reach the backend, a cached answer would not measure anything
+    subsystem->CacheRefreshInterval = 0.f;
+  }
+
+  Host->MultiplayerOnCreateSessionComplete.AddDynamic(this, &ThisClass::OnHostCreated);
+  Host->MultiplayerOnDestroySessionComplete.AddDynamic(this, &ThisClass::OnHostDestroyed);
+  Joiner->MultiplayerOnDestroySessionComplete.AddDynamic(this, &ThisClass::OnJoinerDestroyed);
+  FindHandle = Joiner->MultiplayerOnFindSessionsComplete.AddUObject(this, &ThisClass::OnJoinerFound);
+  JoinHandle = Joiner->MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinerJoined);
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::Teardown()
+{
+  if (Host)
+  {
+    Host->MultiplayerOnCreateSessionComplete.RemoveAll(this);
+    Host->MultiplayerOnDestroySessionComplete.RemoveAll(this);
+  }
+  if (Joiner)
+  {
+    Joiner->MultiplayerOnDestroySessionComplete.RemoveAll(this);
+    Joiner->MultiplayerOnFindSessionsComplete.Remove(FindHandle);
+    Joiner->MultiplayerOnJoinSessionComplete.Remove(JoinHandle);
+  }
+}
+
+int32 UMultiplayerSessionsBenchmarkPipeline::GetNumBoundBackendDelegates() const
+{
+  int32 numBound = 0;
+  for (const UMultiplayerSessionsSubsystem* subsystem : { Host, Joiner })
+  {
+    if (subsystem && subsystem->SessionInterface.IsValid())
+    {
+      numBound += subsystem->SessionInterface->GetNumBoundDelegates();
+    }
+  }
+  return numBound;
+}
+
+int32 UMultiplayerSessionsBenchmarkPipeline::GetNumPendingOperations() const
+{
+  return (Host ? Host->GetNumPendingOperations() : 0) + (Joiner ? Joiner->GetNumPendingOperations() : 0);
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::StartCycle()
+{
+  if (!Benchmark->ClaimCycle()) return;
+
+  DestroyRetries = 0;
+  OperationStart = FPlatformTime::Seconds();
+  Host->CreateSession(2, MatchType);
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::OnHostCreated(bool bWasSuccessful)
+{
+  Benchmark->RecordLatency(UMultiplayerSessionsBenchmark::Create, FPlatformTime::Seconds() - OperationStart);
+  if (!bWasSuccessful)
+  {
+    Benchmark->RecordFailure(UMultiplayerSessionsBenchmark::Create);
+    Benchmark->OnCycleFinished();
+    StartCycle();
+    return;
+  }
+
+  bHostSessionAlive = true;
+  OperationStart = FPlatformTime::Seconds();
+  Joiner->FindSessions(10, MatchType);
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::OnJoinerFound(const TArray<FOnlineSessionSearchResult>& results, bool bWasSuccessful)
+{
+  Benchmark->RecordLatency(UMultiplayerSessionsBenchmark::Find, FPlatformTime::Seconds() - OperationStart);
+  if (!bWasSuccessful || results.Num() == 0)
+  {
+    Benchmark->RecordFailure(UMultiplayerSessionsBenchmark::Find);
+    DestroyAll();
+    return;
+  }
+
+  OperationStart = FPlatformTime::Seconds();
+  Joiner->JoinSession(results[0]);
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::OnJoinerJoined(EOnJoinSessionCompleteResult::Type result)
+{
+  Benchmark->RecordLatency(UMultiplayerSessionsBenchmark::Join, FPlatformTime::Seconds() - OperationStart);
+  if (result == EOnJoinSessionCompleteResult::Success)
+  {
+    bJoinerSessionAlive = true;
+  }
+  else
+  {
+    Benchmark->RecordFailure(UMultiplayerSessionsBenchmark::Join);
+  }
+  DestroyAll();
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::DestroyAll()
+{
+  // Both sides leave at once, like a match ending
+  if (bJoinerSessionAlive)
+  {
+    JoinerDestroyStart = FPlatformTime::Seconds();
+    Joiner->DestroySession();
+  }
+  if (bHostSessionAlive)
+  {
+    HostDestroyStart = FPlatformTime::Seconds();
+    Host->DestroySession();
+  }
+  FinishCycleIfDone();
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::OnHostDestroyed(bool bWasSuccessful)
+{
+  Benchmark->RecordLatency(UMultiplayerSessionsBenchmark::Destroy, FPlatformTime::Seconds() - HostDestroyStart);
+  if (!bWasSuccessful)
+  {
+    Benchmark->RecordFailure(UMultiplayerSessionsBenchmark::Destroy);
+    // A session left behind would make the next create destroy it first, retry so every cycle starts clean
+    if (++DestroyRetries <= MaxDestroyRetries)
+    {
+      HostDestroyStart = FPlatformTime::Seconds();
+      Host->DestroySession();
+      return;
+    }
+  }
+  bHostSessionAlive = false;
+  FinishCycleIfDone();
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::OnJoinerDestroyed(bool bWasSuccessful)
+{
+  Benchmark->RecordLatency(UMultiplayerSessionsBenchmark::Destroy, FPlatformTime::Seconds() - JoinerDestroyStart);
+  if (!bWasSuccessful)
+  {
+    Benchmark->RecordFailure(UMultiplayerSessionsBenchmark::Destroy);
+    if (++DestroyRetries <= MaxDestroyRetries)
+    {
+      JoinerDestroyStart = FPlatformTime::Seconds();
+      Joiner->DestroySession();
+      return;
+    }
+  }
+  bJoinerSessionAlive = false;
+  FinishCycleIfDone();
+}
+
+void UMultiplayerSessionsBenchmarkPipeline::FinishCycleIfDone()
+{
+  if (bHostSessionAlive || bJoinerSessionAlive) return;
+
+  Benchmark->OnCycleFinished();
+  StartCycle();
+}
+
+void UMultiplayerSessionsBenchmark::Start(int32 inCycles, int32 concurrency, float failureRate, float minLatency, float maxLatency, bool bInExitWhenDone)
+{
+  CyclesToStart = FMath::Max(inCycles, 1);
+  bExitWhenDone = bInExitWhenDone;
+  StartTime = LastProgressTime = FPlatformTime::Seconds();
+
+  UE_LOG(LogTemp, Display, TEXT("Sessions.Benchmark: %d cycles, %d concurrent, failure rate %.2f, latency %.3f-%.3fs"),
+    CyclesToStart, concurrency, failureRate, minLatency, maxLatency);
+
+  const int32 numPipelines = FMath::Clamp(concurrency, 1, CyclesToStart);
+  for (int32 i = 0; i < numPipelines; i++)
+  {
+    UMultiplayerSessionsBenchmarkPipeline* pipeline = NewObject<UMultiplayerSessionsBenchmarkPipeline>(this);
+    pipeline->Setup(this, i, minLatency, maxLatency, failureRate);
+    Pipelines.Add(pipeline);
+  }
+  for (UMultiplayerSessionsBenchmarkPipeline* pipeline : Pipelines)
+  {
+    pipeline->StartCycle();
+  }
+
+  ProgressTicker = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::CheckProgress), 1.f);
+}
+
+void UMultiplayerSessionsBenchmark::RecordLatency(int32 operation, double seconds)
+{
+  Latencies[operation].Add(seconds * 1000.0);
+  LastProgressTime = FPlatformTime::Seconds();
+}
+
+void UMultiplayerSessionsBenchmark::RecordFailure(int32 operation)
+{
+  Failures[operation]++;
+}
+
+bool UMultiplayerSessionsBenchmark::ClaimCycle()
+{
+  if (CyclesToStart <= 0) return false;
+
+  CyclesToStart--;
+  CyclesRunning++;
+  return true;
+}
+
+void UMultiplayerSessionsBenchmark::OnCycleFinished()
+{
+  CyclesRunning--;
+  CyclesFinished++;
+  if (CyclesToStart == 0 && CyclesRunning == 0)
+  {
+    // Let the backends finish their own completion bookkeeping before looking for leaks
+    FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float) { Finish(false); return false; }));
+  }
+}
+
+bool UMultiplayerSessionsBenchmark::CheckProgress(float deltaTime)
+{
+  if (FPlatformTime::Seconds() - LastProgressTime > StallTimeout)
+  {
+    Finish(true);
+    return false;
+  }
+  if (CyclesFinished != LastProgress)
+  {
+    UE_LOG(LogTemp, Display, TEXT("Sessions.Benchmark: %d cycles done, %d running"), CyclesFinished, CyclesRunning);
+    LastProgress = CyclesFinished;
+  }
+  return true;
+}
+
+void UMultiplayerSessionsBenchmark::Finish(bool bStalled)
+{
+  FTSTicker::GetCoreTicker().RemoveTicker(ProgressTicker);
+
+  const double elapsed = FPlatformTime::Seconds() - StartTime;
+  UE_LOG(LogTemp, Display, TEXT("Sessions.Benchmark: %d cycles in %.2fs, %.1f cycles/s%s"),
+    CyclesFinished, elapsed, CyclesFinished / FMath::Max(elapsed, 0.001), bStalled ? TEXT(", STALLED") : TEXT(""));
+  for (int32 op = 0; op < NumOperations; op++)
+  {
+    Latencies[op].Sort();
+    UE_LOG(LogTemp, Display, TEXT("  %-8s n=%-7d p50 %8.2fms  p95 %8.2fms  p99 %8.2fms  failed %d"),
+      OperationNames[op], Latencies[op].Num(), Percentile(Latencies[op], 0.5), Percentile(Latencies[op], 0.95), Percentile(Latencies[op], 0.99), Failures[op]);
+  }
+
+  // Every completion delegate a subsystem adds must be cleared again, and every session must be gone from the registry
+  int32 leakedDelegates = 0;
+  int32 pendingOperations = 0;
+  for (UMultiplayerSessionsBenchmarkPipeline* pipeline : Pipelines)
+  {
+    leakedDelegates += pipeline->GetNumBoundBackendDelegates();
+    pendingOperations += pipeline->GetNumPendingOperations();
+    pipeline->Teardown();
+  }
+  const int32 leakedSessions = FLoopbackSessionBackend::GetNumRegisteredSessions();
+  if (leakedDelegates > 0 || leakedSessions > 0 || pendingOperations > 0)
+  {
+    UE_LOG(LogTemp, Warning, TEXT("Sessions.Benchmark: %d completion delegates still bound, %d sessions still registered, %d operations still queued"),
+      leakedDelegates, leakedSessions, pendingOperations);
+  }
+
+  Pipelines.Empty();
+  RemoveFromRoot();
+
+  if (bExitWhenDone)
+  {
+    const bool bFailed = bStalled || leakedDelegates > 0 || leakedSessions > 0 || pendingOperations > 0;
+    FPlatformMisc::RequestExitWithStatus(false, bFailed ? 1 : 0);
+  }
+}
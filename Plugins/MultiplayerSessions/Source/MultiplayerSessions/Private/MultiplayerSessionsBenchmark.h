@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "Containers/Ticker.h"
+#include "MultiplayerSessionsBenchmark.generated.h"
+
+class UMultiplayerSessionsSubsystem;
+class UMultiplayerSessionsBenchmark;
+
+/**
+ * One host and one joiner cycling create, find, join and destroy through the subsystem's delegates
+ */
+UCLASS()
+class UMultiplayerSessionsBenchmarkPipeline : public UObject
+{
+  GENERATED_BODY()
+
+public:
+  void Setup(UMultiplayerSessionsBenchmark* inBenchmark, int32 index, float minLatency, float maxLatency, float failureRate);
+  void StartCycle();
+  void Teardown();
+  int32 GetNumBoundBackendDelegates() const;
+  int32 GetNumPendingOperations() const;
+
+private:
+  UFUNCTION()
+  void OnHostCreated(bool bWasSuccessful);
+  void OnJoinerFound(const TArray<FOnlineSessionSearchResult>& results, bool bWasSuccessful);
+  void OnJoinerJoined(EOnJoinSessionCompleteResult::Type result);
+  UFUNCTION()
+  void OnHostDestroyed(bool bWasSuccessful);
+  UFUNCTION()
+  void OnJoinerDestroyed(bool bWasSuccessful);
+
+  void DestroyAll();
+  void FinishCycleIfDone();
+
+  UPROPERTY()
+  UMultiplayerSessionsBenchmark* Benchmark = nullptr;
+  UPROPERTY()
+  UMultiplayerSessionsSubsystem* Host = nullptr;
+  UPROPERTY()
+  UMultiplayerSessionsSubsystem* Joiner = nullptr;
+
+  FString MatchType;
+  double OperationStart = 0.0;
+  double HostDestroyStart = 0.0;
+  double JoinerDestroyStart = 0.0;
+  bool bHostSessionAlive = false;
+  bool bJoinerSessionAlive = false;
+  int32 DestroyRetries = 0;
+  FDelegateHandle FindHandle;
+  FDelegateHandle JoinHandle;
+};
+
+/**
+ * Sessions.Benchmark [Cycles] [Concurrency] [FailureRate] [MinLatency] [MaxLatency] [exit]
+ * Runs Cycles create/find/join/destroy cycles, Concurrency at a time, through UMultiplayerSessionsSubsystem
+ * instances on loopback backends. Logs latency percentiles per operation, failures, and subsystems whose backend
+ * still has completion delegates bound afterwards. With exit the process exits, with 1 on leaks or a stall.
+ * Headless: -ExecCmds="Sessions.Benchmark 5000 500 0.02 0.02 0.3 exit"
+ */
+UCLASS()
+class UMultiplayerSessionsBenchmark : public UObject
+{
+  GENERATED_BODY()
+
+public:
+  void Start(int32 inCycles, int32 concurrency, float failureRate, float minLatency, float maxLatency, bool bInExitWhenDone);
+
+  // Called by the pipelines
+  void RecordLatency(int32 operation, double seconds);
+  void RecordFailure(int32 operation);
+  bool ClaimCycle();
+  void OnCycleFinished();
+
+  enum EOperation { Create, Find, Join, Destroy, NumOperations };
+
+private:
+  bool CheckProgress(float deltaTime);
+  void Finish(bool bStalled);
+
+  UPROPERTY()
+  TArray<UMultiplayerSessionsBenchmarkPipeline*> Pipelines;
+
+  TArray<double> Latencies[NumOperations];
+  int32 Failures[NumOperations] = {};
+  int32 CyclesToStart = 0;
+  int32 CyclesRunning = 0;
+  int32 CyclesFinished = 0;
+  int32 LastProgress = 0;
+  double StartTime = 0.0;
+  double LastProgressTime = 0.0;
+  bool bExitWhenDone = false;
+  FTSTicker::FDelegateHandle ProgressTicker;
+};
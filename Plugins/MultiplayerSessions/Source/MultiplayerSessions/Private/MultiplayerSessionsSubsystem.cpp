@@ -5,6 +5,11 @@
 #include "OnlineSubsystem.h"
 #include "OnlineSessionSettings.h"
 #include "Online/OnlineSessionNames.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Misc/CommandLine.h"
+
+// Reported by name in Blaster's memory report
+LLM_DEFINE_TAG(MultiplayerSessions);
 
 UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem() :
   CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
@@ -13,161 +18,568 @@ UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem() :
   DestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete)),
   StartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete))
 {
+}
+
+void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+  Super::Initialize(Collection);
+
+  InitializeBackend();
+}
+
+void UMultiplayerSessionsSubsystem::Deinitialize()
+{
+  CancelAllOperations();
+  RunningOperation.Reset();
+  FTSTicker::GetCoreTicker().RemoveTicker(TimeoutHandle);
+  ClearBackendDelegates();
+
+  Super::Deinitialize();
+}
+
+void UMultiplayerSessionsSubsystem::InitializeBackend()
+{
+  // Honours -BuildIdOverride=, sessions of other builds are never offered
+  BuildUniqueId = GetBuildUniqueId();
+
+  FParse::Value(FCommandLine::Get(), TEXT("SessionBackend="), SessionBackend);
+  FParse::Value(FCommandLine::Get(), TEXT("SessionLoopbackFailureRate="), LoopbackFailureRate);
+  FString latency;
+  if (FParse::Value(FCommandLine::Get(), TEXT("SessionLoopbackLatency="), latency))
+  {
+    FString minLatency, maxLatency;
+    if (latency.Split(TEXT(","), &minLatency, &maxLatency))
+    {
+      LoopbackMinLatency = FCString::Atof(*minLatency);
+      LoopbackMaxLatency = FCString::Atof(*maxLatency);
+    }
+  }
+
+  if (SessionBackend == TEXT("Loopback"))
+  {
+    SessionInterface = MakeShared<FLoopbackSessionBackend>(LoopbackMinLatency, LoopbackMaxLatency, LoopbackFailureRate);
+    bIsLanBackend = true;
+    return;
+  }
+
   IOnlineSubsystem* subsystem = IOnlineSubsystem::Get();
   if (subsystem)
   {
-    SessionInterface = subsystem->GetSessionInterface();
+    SessionInterface = MakeShared<FOnlineSubsystemSessionBackend>(subsystem->GetSessionInterface());
+    bIsLanBackend = subsystem->GetSubsystemName() == "NULL";
   }
 }
 
-void UMultiplayerSessionsSubsystem::CreateSession(int32 numPublicConnections, FString matchType)
+FUniqueNetIdPtr UMultiplayerSessionsSubsystem::GetLocalUserId() const
 {
-  if (!SessionInterface.IsValid()) return;
+  const UWorld* world = GetWorld();
+  const ULocalPlayer* localPlayer = world ? world->GetFirstLocalPlayerFromController() : nullptr;
+  return localPlayer ? localPlayer->GetPreferredUniqueNetId().GetUniqueNetId() : nullptr;
+}
+
+bool UMultiplayerSessionsSubsystem::GetResolvedConnectString(FString& address) const
+{
+  return SessionInterface.IsValid() && SessionInterface->GetResolvedConnectString(NAME_GameSession, address);
+}
+
+FSessionOperationHandle UMultiplayerSessionsSubsystem::CreateSession(int32 numPublicConnections, FString matchType)
+{
+  TSharedRef<FSessionOperation> operation = MakeShared<FSessionOperation>();
+  operation->Type = ESessionOperationType::Create;
+  operation->NumPublicConnections = numPublicConnections;
+  operation->MatchType = matchType;
+  return Enqueue(operation);
+}
+
+FSessionOperationHandle UMultiplayerSessionsSubsystem::FindSessions(int32 maxSearchResults, FString matchType)
+{
+  TSharedRef<FSessionOperation> operation = MakeShared<FSessionOperation>();
+  operation->Type = ESessionOperationType::Find;
+  operation->MaxSearchResults = maxSearchResults;
+  operation->MatchType = matchType;
+  return Enqueue(operation);
+}
+
+FSessionOperationHandle UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& sessionResult)
+{
+  TSharedRef<FSessionOperation> operation = MakeShared<FSessionOperation>();
+  operation->Type = ESessionOperationType::Join;
+  operation->JoinTarget = sessionResult;
+  return Enqueue(operation);
+}
+
+FSessionOperationHandle UMultiplayerSessionsSubsystem::DestroySession()
+{
+  TSharedRef<FSessionOperation> operation = MakeShared<FSessionOperation>();
+  operation->Type = ESessionOperationType::Destroy;
+  return Enqueue(operation);
+}
+
+FSessionOperationHandle UMultiplayerSessionsSubsystem::StartSession()
+{
+  TSharedRef<FSessionOperation> operation = MakeShared<FSessionOperation>();
+  operation->Type = ESessionOperationType::Start;
+  return Enqueue(operation);
+}
+
+FSessionOperationHandle UMultiplayerSessionsSubsystem::Enqueue(const TSharedRef<FSessionOperation>& operation)
+{
+  if (TSharedPtr<FSessionOperation> existing = FindCoalescable(*operation))
+  {
+    // The latest create or join wins, a find asks for as many results as any of its callers
+    switch (operation->Type)
+    {
+    case ESessionOperationType::Create:
+      existing->NumPublicConnections = operation->NumPublicConnections;
+      existing->MatchType = operation->MatchType;
+      break;
+    case ESessionOperationType::Join:
+      existing->JoinTarget = operation->JoinTarget;
+      break;
+    case ESessionOperationType::Find:
+      existing->MaxSearchResults = FMath::Max(existing->MaxSearchResults, operation->MaxSearchResults);
+      break;
+    default:
+      break;
+    }
+    return FSessionOperationHandle(this, existing);
+  }
+
+  // Whatever is still waiting to set up a session would be torn down right away
+  if (operation->Type == ESessionOperationType::Destroy)
+  {
+    for (const TSharedPtr<FSessionOperation>& pending : TArray<TSharedPtr<FSessionOperation>>(PendingOperations))
+    {
+      if (pending->Type != ESessionOperationType::Find)
+      {
+        CancelOperation(pending);
+      }
+    }
+  }
+
+  PendingOperations.Add(operation);
+  RunNextOperation();
+  return FSessionOperationHandle(this, operation);
+}
+
+TSharedPtr<FSessionOperation> UMultiplayerSessionsSubsystem::FindCoalescable(const FSessionOperation& operation) const
+{
+  // A running find already sees every session a new one would, the other types are only merged while queued
+  if (operation.Type == ESessionOperationType::Find && RunningOperation.IsValid() && !RunningOperation->IsDone() &&
+    RunningOperation->Type == ESessionOperationType::Find && RunningOperation->MatchType == operation.MatchType)
+  {
+    return RunningOperation;
+  }
+  for (const TSharedPtr<FSessionOperation>& pending : PendingOperations)
+  {
+    if (pending->Type != operation.Type) continue;
+    if (operation.Type != ESessionOperationType::Find || pending->MatchType == operation.MatchType)
+    {
+      return pending;
+    }
+  }
+  return nullptr;
+}
+
+void UMultiplayerSessionsSubsystem::CancelOperation(const TSharedPtr<FSessionOperation>& operation)
+{
+  if (!operation.IsValid() || operation->IsDone()) return;
+
+  if (PendingOperations.Remove(operation) > 0)
+  {
+    operation->State = ESessionOperationState::Cancelled;
+    NotifyOperation(*operation);
+    return;
+  }
+  if (operation == RunningOperation)
+  {
+    // The backend cannot take a request back, the queue keeps waiting for its answer so requests never overlap
+    operation->State = ESessionOperationState::Cancelled;
+    NotifyOperation(*operation);
+  }
+}
+
+void UMultiplayerSessionsSubsystem::CancelAllOperations()
+{
+  for (const TSharedPtr<FSessionOperation>& pending : TArray<TSharedPtr<FSessionOperation>>(PendingOperations))
+  {
+    CancelOperation(pending);
+  }
+  // A copy, callbacks of the cancelled operation may queue new ones
+  const TSharedPtr<FSessionOperation> running = RunningOperation;
+  CancelOperation(running);
+}
+
+void UMultiplayerSessionsSubsystem::RunNextOperation()
+{
+  if (RunningOperation.IsValid() || PendingOperations.Num() == 0) return;
+
+  // Held here while it runs, finishing it synchronously releases RunningOperation's reference
+  TSharedPtr<FSessionOperation> operation = PendingOperations[0];
+  PendingOperations.RemoveAt(0);
+  RunningOperation = operation;
+  operation->State = ESessionOperationState::Running;
+
+  TimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnOperationTimeout), OperationTimeout);
+  RunOperation(operation);
+}
+
+void UMultiplayerSessionsSubsystem::RunOperation(const TSharedPtr<FSessionOperation>& operationPtr)
+{
+  FSessionOperation& operation = *operationPtr;
+
+  LLM_SCOPE_BYTAG(MultiplayerSessions);
 
-  // remove existing session if any
-  auto existingSession = SessionInterface->GetNamedSession(NAME_GameSession);
-  if (existingSession != nullptr)
+  bool bStarted = false;
+  if (SessionInterface.IsValid())
   {
-    bCreateSessionOnDestroy = true;
-    LastNumPublicConnections = numPublicConnections;
-    LastMatchType = matchType;
+    switch (operation.Type)
+    {
+    case ESessionOperationType::Create:
+      bStarted = RunCreate(operation);
+      break;
+    case ESessionOperationType::Find:
+      bStarted = RunFind(operation);
+      break;
+    case ESessionOperationType::Join:
+      JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+      bStarted = SessionInterface->JoinSession(GetLocalUserId(), NAME_GameSession, operation.JoinTarget);
+      break;
+    case ESessionOperationType::Destroy:
+      // Nothing to destroy counts as destroyed
+      if (SessionInterface->GetNamedSession(NAME_GameSession) == nullptr)
+      {
+        FinishOperation(RunningOperation, ESessionOperationState::Succeeded);
+        return;
+      }
+      DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+      bStarted = SessionInterface->DestroySession(NAME_GameSession);
+      break;
+    case ESessionOperationType::Start:
+      StartSessionCompleteDelegateHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegate);
+      bStarted = SessionInterface->StartSession(NAME_GameSession);
+      break;
+    }
+  }
+
+  // RunFind may have finished from the cache already
+  if (!bStarted && RunningOperation == operationPtr)
+  {
+    FinishOperation(RunningOperation, ESessionOperationState::Failed);
+  }
+}
 
-    DestroySession();
+bool UMultiplayerSessionsSubsystem::RunCreate(FSessionOperation& operation)
+{
+  // remove existing session first, the create continues when the destroy completes
+  if (SessionInterface->GetNamedSession(NAME_GameSession) != nullptr)
+  {
+    operation.bDestroyingForCreate = true;
+    DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+    return SessionInterface->DestroySession(NAME_GameSession);
   }
+  operation.bDestroyingForCreate = false;
 
   // session settings
   LastSessionSettings = MakeShareable(new FOnlineSessionSettings());
-  LastSessionSettings->bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL";
-  LastSessionSettings->NumPublicConnections = numPublicConnections;
+  LastSessionSettings->bIsLANMatch = bIsLanBackend;
+  LastSessionSettings->NumPublicConnections = operation.NumPublicConnections;
   LastSessionSettings->bAllowJoinInProgress = true;
   LastSessionSettings->bAllowJoinViaPresence = true;
   LastSessionSettings->bUsesPresence = true;
   LastSessionSettings->bShouldAdvertise = true;
   LastSessionSettings->bUseLobbiesIfAvailable = true;
-  LastSessionSettings->Set(FName("MatchType"), matchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
-  LastSessionSettings->BuildUniqueId = 1;
+  LastSessionSettings->Set(FName("MatchType"), operation.MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+  LastSessionSettings->BuildUniqueId = BuildUniqueId;
+  LastSessionSettings->Set(FName("BuildId"), LastSessionSettings->BuildUniqueId, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
 
   // create session
   CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
-  const ULocalPlayer* localPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-  if (!SessionInterface->CreateSession(*localPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *LastSessionSettings))
-  {
-    SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
-
-    MultiplayerOnCreateSessionComplete.Broadcast(false);
-  }
+  return SessionInterface->CreateSession(GetLocalUserId(), NAME_GameSession, *LastSessionSettings);
 }
 
-void UMultiplayerSessionsSubsystem::FindSessions(int32 maxSearchResults)
+bool UMultiplayerSessionsSubsystem::RunFind(FSessionOperation& operation)
 {
-  if (!SessionInterface.IsValid()) return;
+  SearchMatchType = operation.MatchType;
+  SearchCacheKey = GetCacheKey(operation.MatchType, BuildUniqueId);
+  const FSessionCacheBucket* bucket = SessionCache.Find(SearchCacheKey);
+  const double now = FPlatformTime::Seconds();
+  if (bucket && bucket->LastRefreshTime >= 0.0 && now - bucket->LastRefreshTime < CacheRefreshInterval)
+  {
+    TArray<FOnlineSessionSearchResult> cachedResults = GetSortedResults(operation.MatchType);
+    if (cachedResults.Num() > 0)
+    {
+      operation.SearchResults = MoveTemp(cachedResults);
+      FinishOperation(RunningOperation, ESessionOperationState::Succeeded);
+      return true;
+    }
+  }
 
   FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
   LastSessionSearch = MakeShareable(new FOnlineSessionSearch());
-  LastSessionSearch->MaxSearchResults = maxSearchResults;
-  LastSessionSearch->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL";
+  LastSessionSearch->MaxSearchResults = operation.MaxSearchResults;
+  LastSessionSearch->bIsLanQuery = bIsLanBackend;
   LastSessionSearch->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
-
-  const ULocalPlayer* localPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-  if (!SessionInterface->FindSessions(*localPlayer->GetPreferredUniqueNetId(), LastSessionSearch.ToSharedRef()))
+  // Let the backend filter, results are checked again when merged since not every backend honours every setting
+  LastSessionSearch->QuerySettings.Set(SEARCH_MINSLOTSAVAILABLE, 1, EOnlineComparisonOp::GreaterThanEquals);
+  LastSessionSearch->QuerySettings.Set(FName("BuildId"), BuildUniqueId, EOnlineComparisonOp::Equals);
+  if (!operation.MatchType.IsEmpty())
   {
-    SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
-
-    MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+    LastSessionSearch->QuerySettings.Set(FName("MatchType"), operation.MatchType, EOnlineComparisonOp::Equals);
   }
+  return SessionInterface->FindSessions(GetLocalUserId(), LastSessionSearch.ToSharedRef());
 }
 
-void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& sessionResult)
+void UMultiplayerSessionsSubsystem::FinishOperation(TSharedPtr<FSessionOperation> operation, ESessionOperationState state)
 {
-  if (!SessionInterface.IsValid())
+  // By value, callers pass RunningOperation itself, which is reset below
+  if (!operation.IsValid()) return;
+
+  if (operation == RunningOperation)
   {
-    MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
-    return;
+    RunningOperation.Reset();
+    FTSTicker::GetCoreTicker().RemoveTicker(TimeoutHandle);
+    ClearBackendDelegates();
+  }
+  // A cancelled operation already told its callers
+  if (!operation->IsDone())
+  {
+    operation->State = state;
+    NotifyOperation(*operation);
   }
 
-  JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+  RunNextOperation();
+}
 
-  const ULocalPlayer* localPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-  if (!SessionInterface->JoinSession(*localPlayer->GetPreferredUniqueNetId(), NAME_GameSession, sessionResult))
+void UMultiplayerSessionsSubsystem::NotifyOperation(FSessionOperation& operation)
+{
+  TArray<FSessionOperationCallback> callbacks = MoveTemp(operation.Callbacks);
+  for (const FSessionOperationCallback& callback : callbacks)
   {
-    SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+    callback(operation);
+  }
+
+  // Cancelled requests are not reported to the listeners of the subsystem
+  if (operation.State == ESessionOperationState::Cancelled) return;
 
-    MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
+  const bool bSucceeded = operation.Succeeded();
+  switch (operation.Type)
+  {
+  case ESessionOperationType::Create:
+    MultiplayerOnCreateSessionComplete.Broadcast(bSucceeded);
+    break;
+  case ESessionOperationType::Find:
+    MultiplayerOnFindSessionsComplete.Broadcast(operation.SearchResults, bSucceeded);
+    break;
+  case ESessionOperationType::Join:
+    MultiplayerOnJoinSessionComplete.Broadcast(operation.JoinResult);
+    break;
+  case ESessionOperationType::Destroy:
+    MultiplayerOnDestroySessionComplete.Broadcast(bSucceeded);
+    break;
+  case ESessionOperationType::Start:
+    MultiplayerOnStartSessionComplete.Broadcast(bSucceeded);
+    break;
   }
 }
 
-void UMultiplayerSessionsSubsystem::DestroySession()
+void UMultiplayerSessionsSubsystem::ClearBackendDelegates()
+{
+  if (!SessionInterface.IsValid()) return;
+
+  // Only one operation runs at a time, an answer arriving after its operation finished has nobody to go to
+  SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+  SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+  SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+  SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+  SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);
+}
+
+bool UMultiplayerSessionsSubsystem::OnOperationTimeout(float deltaTime)
 {
-  if (!SessionInterface.IsValid())
+  if (RunningOperation.IsValid())
   {
-    MultiplayerOnDestroySessionComplete.Broadcast(false);
-    return;
+    UE_LOG(LogTemp, Warning, TEXT("Session operation %d timed out after %.1fs"), int32(RunningOperation->Type), OperationTimeout);
+    FinishOperation(RunningOperation, ESessionOperationState::TimedOut);
   }
+  return false;
+}
 
-  DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName sessionName, bool bWasSuccessful)
+{
+  if (!RunningOperation.IsValid() || RunningOperation->Type != ESessionOperationType::Create) return;
+
+  FinishOperation(RunningOperation, bWasSuccessful ? ESessionOperationState::Succeeded : ESessionOperationState::Failed);
+}
 
-  if (!SessionInterface->DestroySession(NAME_GameSession))
+void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
+{
+  if (!RunningOperation.IsValid() || RunningOperation->Type != ESessionOperationType::Find) return;
+
+  if (bWasSuccessful)
   {
-    SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
-    MultiplayerOnDestroySessionComplete.Broadcast(false);
+    MergeSearchResults(LastSessionSearch->SearchResults);
   }
+
+  RunningOperation->SearchResults = GetSortedResults(SearchMatchType);
+  const bool bFound = bWasSuccessful && RunningOperation->SearchResults.Num() > 0;
+  FinishOperation(RunningOperation, bFound ? ESessionOperationState::Succeeded : ESessionOperationState::Failed);
 }
 
-void UMultiplayerSessionsSubsystem::StartSession()
+FString UMultiplayerSessionsSubsystem::GetCacheKey(const FString& matchType, int32 buildId) const
 {
+  return FString::Printf(TEXT("%s|%d"), *matchType, buildId);
 }
 
-void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName sessionName, bool bWasSuccessful)
+bool UMultiplayerSessionsSubsystem::IsSearchedBucket(const FString& bucketKey, const FString& matchType) const
+{
+  // No match type searches every match type of this build
+  return matchType.IsEmpty() ? bucketKey.EndsWith(FString::Printf(TEXT("|%d"), BuildUniqueId)) : bucketKey == GetCacheKey(matchType, BuildUniqueId);
+}
+
+void UMultiplayerSessionsSubsystem::MergeSearchResults(const TArray<FOnlineSessionSearchResult>& results)
 {
-  if (SessionInterface)
+  const double now = FPlatformTime::Seconds();
+  TSet<FString> seenIds;
+  for (const FOnlineSessionSearchResult& result : results)
   {
-    SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+    if (!result.IsValid()) continue;
+    seenIds.Add(result.GetSessionIdStr());
+
+    FString matchType;
+    result.Session.SessionSettings.Get(FName("MatchType"), matchType);
+    int32 buildId = result.Session.SessionSettings.BuildUniqueId;
+    result.Session.SessionSettings.Get(FName("BuildId"), buildId);
+    if (buildId != BuildUniqueId) continue;
+
+    // A session seen before is updated in place, ping and free slots change between searches
+    FCachedSession& cached = SessionCache.FindOrAdd(GetCacheKey(matchType, buildId)).Sessions.FindOrAdd(result.GetSessionIdStr());
+    cached.Result = result;
+    cached.LastSeenTime = now;
+    cached.Score = ScoreSession(result);
   }
 
-  MultiplayerOnCreateSessionComplete.Broadcast(bWasSuccessful);
+  // A search that was not cut short by MaxSearchResults saw every session of the buckets it covered, the rest are gone
+  const bool bCompleteSearch = LastSessionSearch.IsValid() && results.Num() < LastSessionSearch->MaxSearchResults;
+  for (TPair<FString, FSessionCacheBucket>& bucket : SessionCache)
+  {
+    const bool bSearchedBucket = IsSearchedBucket(bucket.Key, SearchMatchType);
+    for (auto it = bucket.Value.Sessions.CreateIterator(); it; ++it)
+    {
+      const bool bGone = bCompleteSearch && bSearchedBucket && !seenIds.Contains(it.Key());
+      if (bGone || now - it.Value().LastSeenTime > CacheEntryLifetime)
+      {
+        it.RemoveCurrent();
+      }
+    }
+    if (bSearchedBucket)
+    {
+      bucket.Value.LastRefreshTime = now;
+    }
+  }
+  SessionCache.FindOrAdd(SearchCacheKey).LastRefreshTime = now;
 }
 
-void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
+void UMultiplayerSessionsSubsystem::EvictSession(const FString& sessionId)
 {
-  if (SessionInterface)
+  for (TPair<FString, FSessionCacheBucket>& bucket : SessionCache)
   {
-    SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+    bucket.Value.Sessions.Remove(sessionId);
   }
+}
+
+float UMultiplayerSessionsSubsystem::ScoreSession(const FOnlineSessionSearchResult& result)
+{
+  const int32 maxSlots = result.Session.SessionSettings.NumPublicConnections;
+  const int32 openSlots = result.Session.NumOpenPublicConnections;
+  if (maxSlots <= 0 || openSlots <= 0) return TNumericLimits<float>::Max();
+
+  // Among servers with similar ping, prefer fuller ones, their match starts sooner
+  const float emptyFraction = float(openSlots) / maxSlots;
+  return result.PingInMs + emptyFraction * 50.f;
+}
 
-  if (LastSessionSearch->SearchResults.Num() <= 0)
+TArray<FOnlineSessionSearchResult> UMultiplayerSessionsSubsystem::GetSortedResults(const FString& matchType) const
+{
+  TArray<const FCachedSession*> sorted;
+  for (const TPair<FString, FSessionCacheBucket>& bucket : SessionCache)
   {
-    MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
-    return;
+    if (!IsSearchedBucket(bucket.Key, matchType)) continue;
+
+    for (const TPair<FString, FCachedSession>& session : bucket.Value.Sessions)
+    {
+      if (session.Value.Score < TNumericLimits<float>::Max())
+      {
+        sorted.Add(&session.Value);
+      }
+    }
   }
+  sorted.Sort([](const FCachedSession& a, const FCachedSession& b) { return a.Score < b.Score; });
 
-  MultiplayerOnFindSessionsComplete.Broadcast(LastSessionSearch->SearchResults, bWasSuccessful);
+  TArray<FOnlineSessionSearchResult> results;
+  results.Reserve(sorted.Num());
+  for (const FCachedSession* session : sorted)
+  {
+    results.Add(session->Result);
+  }
+  return results;
 }
 
 void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName sessionName, EOnJoinSessionCompleteResult::Type result)
 {
-  if (SessionInterface)
+  if (!RunningOperation.IsValid() || RunningOperation->Type != ESessionOperationType::Join) return;
+
+  RunningOperation->JoinResult = result;
+  // A session that could not be joined is full or gone, the next search must not offer it from the cache
+  if (result != EOnJoinSessionCompleteResult::Success && result != EOnJoinSessionCompleteResult::AlreadyInSession)
   {
-    SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+    EvictSession(RunningOperation->JoinTarget.GetSessionIdStr());
   }
-
-  MultiplayerOnJoinSessionComplete.Broadcast(result);
+  FinishOperation(RunningOperation, result == EOnJoinSessionCompleteResult::Success ? ESessionOperationState::Succeeded : ESessionOperationState::Failed);
 }
 
 void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName sessionName, bool bWasSuccessful)
 {
-  if (SessionInterface)
+  if (!RunningOperation.IsValid()) return;
+
+  if (RunningOperation->Type == ESessionOperationType::Create && RunningOperation->bDestroyingForCreate)
   {
     SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+    if (bWasSuccessful && !RunningOperation->IsDone() && RunCreate(*RunningOperation))
+    {
+      return;
+    }
+    FinishOperation(RunningOperation, ESessionOperationState::Failed);
+    return;
   }
-  if (bWasSuccessful && bCreateSessionOnDestroy)
-  {
-    bCreateSessionOnDestroy = false;
-    CreateSession(LastNumPublicConnections, LastMatchType);
-  }
+  if (RunningOperation->Type != ESessionOperationType::Destroy) return;
 
-  MultiplayerOnDestroySessionComplete.Broadcast(bWasSuccessful);
+  FinishOperation(RunningOperation, bWasSuccessful ? ESessionOperationState::Succeeded : ESessionOperationState::Failed);
 }
 
 void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName sessionName, bool bWasSuccessful)
 {
+  if (!RunningOperation.IsValid() || RunningOperation->Type != ESessionOperationType::Start) return;
+
+  FinishOperation(RunningOperation, bWasSuccessful ? ESessionOperationState::Succeeded : ESessionOperationState::Failed);
+}
+
+void FSessionOperationHandle::OnComplete(FSessionOperationCallback callback) const
+{
+  if (!Operation.IsValid()) return;
+
+  if (Operation->IsDone())
+  {
+    callback(*Operation);
+    return;
+  }
+  Operation->Callbacks.Add(MoveTemp(callback));
+}
+
+void FSessionOperationHandle::Cancel() const
+{
+  if (UMultiplayerSessionsSubsystem* subsystem = Subsystem.Get())
+  {
+    subsystem->CancelOperation(Operation);
+  }
 }
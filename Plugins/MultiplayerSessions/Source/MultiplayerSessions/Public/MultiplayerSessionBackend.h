@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "OnlineSessionSettings.h"
+#include "Containers/Ticker.h"
+
+/**
+ * The session operations UMultiplayerSessionsSubsystem uses, with the same delegate handle pattern as IOnlineSession.
+ * Bound completion delegates are counted so tests can detect handles that were never cleared.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionBackend
+{
+public:
+  virtual ~FMultiplayerSessionBackend() = default;
+
+  virtual bool CreateSession(const FUniqueNetIdPtr& hostingPlayerId, FName sessionName, const FOnlineSessionSettings& newSessionSettings) = 0;
+  virtual bool FindSessions(const FUniqueNetIdPtr& searchingPlayerId, const TSharedRef<FOnlineSessionSearch>& searchSettings) = 0;
+  virtual bool JoinSession(const FUniqueNetIdPtr& playerId, FName sessionName, const FOnlineSessionSearchResult& desiredSession) = 0;
+  virtual bool DestroySession(FName sessionName) = 0;
+  virtual bool StartSession(FName sessionName) = 0;
+  virtual FNamedOnlineSession* GetNamedSession(FName sessionName) = 0;
+  virtual bool GetResolvedConnectString(FName sessionName, FString& connectInfo) = 0;
+
+  FDelegateHandle AddOnCreateSessionCompleteDelegate_Handle(const FOnCreateSessionCompleteDelegate& delegate);
+  void ClearOnCreateSessionCompleteDelegate_Handle(FDelegateHandle& handle);
+  FDelegateHandle AddOnFindSessionsCompleteDelegate_Handle(const FOnFindSessionsCompleteDelegate& delegate);
+  void ClearOnFindSessionsCompleteDelegate_Handle(FDelegateHandle& handle);
+  FDelegateHandle AddOnJoinSessionCompleteDelegate_Handle(const FOnJoinSessionCompleteDelegate& delegate);
+  void ClearOnJoinSessionCompleteDelegate_Handle(FDelegateHandle& handle);
+  FDelegateHandle AddOnDestroySessionCompleteDelegate_Handle(const FOnDestroySessionCompleteDelegate& delegate);
+  void ClearOnDestroySessionCompleteDelegate_Handle(FDelegateHandle& handle);
+  FDelegateHandle AddOnStartSessionCompleteDelegate_Handle(const FOnStartSessionCompleteDelegate& delegate);
+  void ClearOnStartSessionCompleteDelegate_Handle(FDelegateHandle& handle);
+
+  FORCEINLINE int32 GetNumBoundDelegates() const { return NumBoundDelegates; }
+
+protected:
+  FOnCreateSessionComplete OnCreateSessionComplete;
+  FOnFindSessionsComplete OnFindSessionsComplete;
+  FOnJoinSessionComplete OnJoinSessionComplete;
+  FOnDestroySessionComplete OnDestroySessionComplete;
+  FOnStartSessionComplete OnStartSessionComplete;
+
+private:
+  int32 NumBoundDelegates = 0;
+};
+
+/**
+ * Forwards to the session interface of the default online subsystem, Steam or NULL
+ */
+class MULTIPLAYERSESSIONS_API FOnlineSubsystemSessionBackend : public FMultiplayerSessionBackend
+{
+public:
+  explicit FOnlineSubsystemSessionBackend(IOnlineSessionPtr inSessionInterface);
+  virtual ~FOnlineSubsystemSessionBackend() override;
+
+  virtual bool CreateSession(const FUniqueNetIdPtr& hostingPlayerId, FName sessionName, const FOnlineSessionSettings& newSessionSettings) override;
+  virtual bool FindSessions(const FUniqueNetIdPtr& searchingPlayerId, const TSharedRef<FOnlineSessionSearch>& searchSettings) override;
+  virtual bool JoinSession(const FUniqueNetIdPtr& playerId, FName sessionName, const FOnlineSessionSearchResult& desiredSession) override;
+  virtual bool DestroySession(FName sessionName) override;
+  virtual bool StartSession(FName sessionName) override;
+  virtual FNamedOnlineSession* GetNamedSession(FName sessionName) override;
+  virtual bool GetResolvedConnectString(FName sessionName, FString& connectInfo) override;
+
+private:
+  IOnlineSessionPtr SessionInterface;
+  FDelegateHandle CreateHandle;
+  FDelegateHandle FindHandle;
+  FDelegateHandle JoinHandle;
+  FDelegateHandle DestroyHandle;
+  FDelegateHandle StartHandle;
+};
+
+/**
+ * In process stand in for an online backend. All loopback backends in the process share one session registry,
+ * every operation completes after a random latency and fails with FailureRate.
+ */
+class MULTIPLAYERSESSIONS_API FLoopbackSessionBackend : public FMultiplayerSessionBackend, public TSharedFromThis<FLoopbackSessionBackend>
+{
+public:
+  FLoopbackSessionBackend(float inMinLatency, float inMaxLatency, float inFailureRate);
+  virtual ~FLoopbackSessionBackend() override;
+
+  virtual bool CreateSession(const FUniqueNetIdPtr& hostingPlayerId, FName sessionName, const FOnlineSessionSettings& newSessionSettings) override;
+  virtual bool FindSessions(const FUniqueNetIdPtr& searchingPlayerId, const TSharedRef<FOnlineSessionSearch>& searchSettings) override;
+  virtual bool JoinSession(const FUniqueNetIdPtr& playerId, FName sessionName, const FOnlineSessionSearchResult& desiredSession) override;
+  virtual bool DestroySession(FName sessionName) override;
+  virtual bool StartSession(FName sessionName) override;
+  virtual FNamedOnlineSession* GetNamedSession(FName sessionName) override;
+  virtual bool GetResolvedConnectString(FName sessionName, FString& connectInfo) override;
+
+  static int32 GetNumRegisteredSessions();
+
+private:
+  // Runs the completion after the simulated latency, passes whether the operation should fail
+  void Complete(TFunction<void(bool bFailed)> completion);
+
+  float MinLatency = 0.f;
+  float MaxLatency = 0.f;
+  float FailureRate = 0.f;
+
+  TMap<FName, TSharedPtr<FNamedOnlineSession>> NamedSessions;
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "Interfaces/OnlineSessionInterface.h"
+#include "MultiplayerSessionBackend.h"
 #include "MultiplayerSessionsSubsystem.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnCreateSessionComplete, bool, bWasSuccessful);
@@ -13,22 +14,126 @@ DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnJoinSessionComplete, EOnJoinSe
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnDestroySessionComplete, bool, bWasSuccessful);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnStartSessionComplete, bool, bWasSuccessful);
 
+struct FCachedSession
+{
+  FOnlineSessionSearchResult Result;
+  double LastSeenTime = 0.0;
+  float Score = 0.f; // Lower is better
+};
+
+// Sessions of one match type and build, keyed by session id
+struct FSessionCacheBucket
+{
+  TMap<FString, FCachedSession> Sessions;
+  double LastRefreshTime = -1.0;
+};
+
+enum class ESessionOperationType : uint8
+{
+  Create,
+  Find,
+  Join,
+  Destroy,
+  Start
+};
+
+enum class ESessionOperationState : uint8
+{
+  Queued,
+  Running,
+  Succeeded,
+  Failed,
+  Cancelled,
+  TimedOut
+};
+
+struct FSessionOperation;
+using FSessionOperationCallback = TFunction<void(const FSessionOperation& operation)>;
+
+// One queued session request, shared by every caller whose request was coalesced into it
+struct FSessionOperation
+{
+  ESessionOperationType Type = ESessionOperationType::Find;
+  ESessionOperationState State = ESessionOperationState::Queued;
+
+  int32 NumPublicConnections = 0;
+  FString MatchType;
+  int32 MaxSearchResults = 0;
+  FOnlineSessionSearchResult JoinTarget;
+
+  TArray<FOnlineSessionSearchResult> SearchResults;
+  EOnJoinSessionCompleteResult::Type JoinResult = EOnJoinSessionCompleteResult::UnknownError;
+
+  bool IsDone() const { return State > ESessionOperationState::Running; }
+  bool Succeeded() const { return State == ESessionOperationState::Succeeded; }
+
+private:
+  friend class UMultiplayerSessionsSubsystem;
+
+  TArray<FSessionOperationCallback> Callbacks;
+  // A create that found an old session destroys it first
+  bool bDestroyingForCreate = false;
+};
+
+/**
+ * What a session request returns, lets the caller wait for the result or cancel
+ */
+class MULTIPLAYERSESSIONS_API FSessionOperationHandle
+{
+public:
+  FSessionOperationHandle() = default;
+
+  bool IsValid() const { return Operation.IsValid(); }
+  bool IsDone() const { return Operation.IsValid() && Operation->IsDone(); }
+  ESessionOperationState GetState() const { return Operation.IsValid() ? Operation->State : ESessionOperationState::Failed; }
+
+  // Called once when the operation finishes, right away when it already has
+  void OnComplete(FSessionOperationCallback callback) const;
+  // A queued operation never runs. A running one finishes as cancelled now, the backend request runs out unreported.
+  void Cancel() const;
+
+private:
+  friend class UMultiplayerSessionsSubsystem;
+
+  FSessionOperationHandle(UMultiplayerSessionsSubsystem* inSubsystem, const TSharedPtr<FSessionOperation>& inOperation) :
+    Subsystem(inSubsystem), Operation(inOperation) {}
+
+  TWeakObjectPtr<UMultiplayerSessionsSubsystem> Subsystem;
+  TSharedPtr<FSessionOperation> Operation;
+};
+
 /**
- *
+ * Creates, finds, joins and destroys sessions through a FMultiplayerSessionBackend.
+ * Requests run one at a time in the order they were made, each with a timeout. A request matching one already queued
+ * is merged into it: finds for the same match type share one search, a later create or join replaces the queued one.
+ * Every operation completes exactly once, through its handle and the matching MultiplayerOn* delegate.
+ * SessionBackend selects it: OnlineSubsystem for the default online subsystem, Loopback for the in process stand in.
+ * -SessionBackend=, -SessionLoopbackLatency=Min,Max and -SessionLoopbackFailureRate= override the config.
  */
-UCLASS()
+UCLASS(Config = Game)
 class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstanceSubsystem
 {
   GENERATED_BODY()
 
+  // Drives subsystems without a game instance or local player
+  friend class UMultiplayerSessionsBenchmark;
+
 public:
   UMultiplayerSessionsSubsystem();
+  virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+  virtual void Deinitialize() override;
+
+  FSessionOperationHandle CreateSession(int32 numPublicConnections, FString matchType);
+  // Results are filtered by match type and build and sorted best first, a recent search is answered from the cache
+  FSessionOperationHandle FindSessions(int32 maxSearchResults, FString matchType = FString());
+  FSessionOperationHandle JoinSession(const FOnlineSessionSearchResult& sessionResult);
+  FSessionOperationHandle DestroySession();
+  FSessionOperationHandle StartSession();
+  bool GetResolvedConnectString(FString& address) const;
 
-  void CreateSession(int32 numPublicConnections, FString matchType);
-  void FindSessions(int32 maxSearchResults);
-  void JoinSession(const FOnlineSessionSearchResult& sessionResult);
-  void DestroySession();
-  void StartSession();
+  void CancelOperation(const TSharedPtr<FSessionOperation>& operation);
+  void CancelAllOperations();
+  FORCEINLINE int32 GetNumPendingOperations() const { return PendingOperations.Num() + (RunningOperation.IsValid() ? 1 : 0); }
 
 protected:
   void OnCreateSessionComplete(FName sessionName, bool bWasSuccessful);
@@ -47,7 +152,43 @@ public:
 
 
 private:
-  IOnlineSessionPtr SessionInterface = nullptr;
+  void InitializeBackend();
+  FUniqueNetIdPtr GetLocalUserId() const;
+
+  UPROPERTY(Config)
+  FString SessionBackend = TEXT("OnlineSubsystem");
+
+  UPROPERTY(Config)
+  float LoopbackMinLatency = 0.05f;
+
+  UPROPERTY(Config)
+  float LoopbackMaxLatency = 0.2f;
+
+  UPROPERTY(Config)
+  float LoopbackFailureRate = 0.f;
+
+  // An operation the backend has not answered within this many seconds fails as timed out
+  UPROPERTY(Config)
+  float OperationTimeout = 30.f;
+
+  FSessionOperationHandle Enqueue(const TSharedRef<FSessionOperation>& operation);
+  TSharedPtr<FSessionOperation> FindCoalescable(const FSessionOperation& operation) const;
+  void RunNextOperation();
+  // The caller keeps operation alive, it can finish and leave RunningOperation before this returns
+  void RunOperation(const TSharedPtr<FSessionOperation>& operation);
+  bool RunCreate(FSessionOperation& operation);
+  bool RunFind(FSessionOperation& operation);
+  void FinishOperation(TSharedPtr<FSessionOperation> operation, ESessionOperationState state);
+  void NotifyOperation(FSessionOperation& operation);
+  void ClearBackendDelegates();
+  bool OnOperationTimeout(float deltaTime);
+
+  TArray<TSharedPtr<FSessionOperation>> PendingOperations;
+  TSharedPtr<FSessionOperation> RunningOperation;
+  FTSTicker::FDelegateHandle TimeoutHandle;
+
+  TSharedPtr<FMultiplayerSessionBackend> SessionInterface = nullptr;
+  bool bIsLanBackend = false;
   TSharedPtr<FOnlineSessionSettings> LastSessionSettings = nullptr;
   TSharedPtr<FOnlineSessionSearch> LastSessionSearch = nullptr;
 
@@ -66,7 +207,22 @@ private:
   FOnStartSessionCompleteDelegate StartSessionCompleteDelegate;
   FDelegateHandle StartSessionCompleteDelegateHandle;
 
-  bool bCreateSessionOnDestroy = false;
-  int32 LastNumPublicConnections;
-  FString LastMatchType;
+  void MergeSearchResults(const TArray<FOnlineSessionSearchResult>& results);
+  // Cached sessions a search for matchType returns, best first
+  TArray<FOnlineSessionSearchResult> GetSortedResults(const FString& matchType) const;
+  FString GetCacheKey(const FString& matchType, int32 buildId) const;
+  bool IsSearchedBucket(const FString& bucketKey, const FString& matchType) const;
+  void EvictSession(const FString& sessionId);
+  static float ScoreSession(const FOnlineSessionSearchResult& result);
+
+  // Cache of search results by match type and build
+  TMap<FString, FSessionCacheBucket> SessionCache;
+  int32 BuildUniqueId = 0;
+  FString SearchCacheKey;
+  FString SearchMatchType;
+
+  // A search younger than this is answered from the cache
+  float CacheRefreshInterval = 10.f;
+  // Sessions not seen by a search for this long are dropped
+  float CacheEntryLifetime = 60.f;
 };
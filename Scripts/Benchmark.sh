@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+# Runs the Blaster gameplay micro-benchmarks headless and compares them with a baseline.
+# Exits non-zero when a metric regressed by more than the threshold.
+#
+# Usage: UE_ROOT=/path/to/UnrealEngine Scripts/Benchmark.sh [baseline.json] [threshold] [scenarios]
+#   scenarios is a comma separated subset of HUDSetterStorm,CharacterTick,ProjectileFire,RespawnChurn,MatchPhaseCycle
+
+set -euo pipefail
+
+BASELINE=${1:-}
+THRESHOLD=${2:-0.1}
+SCENARIOS=${3:-}
+
+PROJECT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="$PROJECT_DIR/Blaster.uproject"
+EDITOR="${UE_ROOT:?Set UE_ROOT to the engine root}/Engine/Binaries/Linux/UnrealEditor-Cmd"
+MAP=/Game/Maps/BlasterMap
+OUT="$PROJECT_DIR/Saved/Benchmark/$(date +%Y%m%d-%H%M%S).json"
+
+ARGS=(-game -nullrhi -nosound -nosteam -unattended -nopause -log
+	-BlasterBenchmark="$SCENARIOS" -BlasterBenchmarkOut="$OUT" -BlasterBenchmarkThreshold="$THRESHOLD")
+if [[ -n "$BASELINE" ]]; then
+	ARGS+=(-BlasterBenchmarkBaseline="$BASELINE")
+fi
+
+STATUS=0
+"$EDITOR" "$PROJECT" "$MAP" "${ARGS[@]}" || STATUS=$?
+
+echo "Results: $OUT"
+exit $STATUS
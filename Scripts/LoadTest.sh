@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+# Runs a headless Blaster load test on one Linux box: a dedicated server with server side bots,
+# plus optional headless clients that play on their own. Results land in Saved/LoadTest/<timestamp>/.
+#
+# Usage: UE_ROOT=/path/to/UnrealEngine Scripts/LoadTest.sh [bots] [clients] [duration_seconds]
+
+set -euo pipefail
+
+BOTS=${1:-16}
+CLIENTS=${2:-0}
+DURATION=${3:-300}
+
+PROJECT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="$PROJECT_DIR/Blaster.uproject"
+EDITOR="${UE_ROOT:?Set UE_ROOT to the engine root}/Engine/Binaries/Linux/UnrealEditor-Cmd"
+MAP=/Game/Maps/BlasterMap
+COMMON_ARGS="-nullrhi -nosound -nosteam -unattended -nopause -log"
+
+"$EDITOR" "$PROJECT" "$MAP" -server $COMMON_ARGS \
+	-BlasterLoadTest -BlasterBots="$BOTS" -BlasterLoadTestDuration="$DURATION" &
+SERVER_PID=$!
+
+# Give the server time to load the map before clients connect
+sleep 20
+
+CLIENT_PIDS=()
+for ((i = 0; i < CLIENTS; i++)); do
+	"$EDITOR" "$PROJECT" 127.0.0.1 -game $COMMON_ARGS -BlasterAutoPlay > /dev/null 2>&1 &
+	CLIENT_PIDS+=($!)
+done
+
+wait "$SERVER_PID"
+STATUS=$?
+
+for PID in "${CLIENT_PIDS[@]}"; do
+	kill "$PID" 2> /dev/null || true
+done
+
+exit $STATUS
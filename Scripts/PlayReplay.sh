@@ -0,0 +1,20 @@
+#!/usr/bin/env bash
+# Plays a recorded server replay headless and re-profiles it.
+# Frame time percentiles go to Saved/ReplayProfile/<replay>.csv, an Insights trace with the Blaster counters next to the log.
+#
+# Record on the server with -BlasterRecordReplay (or Blaster.Replay.Record 1), replays are written to the
+# UBlasterReplayRecorder ReplayDirectory (Saved/Demos/ by default), older segments compressed to <replay>.replay.oz.
+# Usage: UE_ROOT=/path/to/UnrealEngine Scripts/PlayReplay.sh <replay name without .replay>
+
+set -euo pipefail
+
+REPLAY=${1:?Usage: PlayReplay.sh <replay name>}
+
+PROJECT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="$PROJECT_DIR/Blaster.uproject"
+EDITOR="${UE_ROOT:?Set UE_ROOT to the engine root}/Engine/Binaries/Linux/UnrealEditor-Cmd"
+
+"$EDITOR" "$PROJECT" -game -nullrhi -nosound -nosteam -unattended -nopause -log \
+	-BlasterPlayReplay="$REPLAY" -trace=cpu,frame,counters,Blaster -tracefile="$PROJECT_DIR/Saved/ReplayProfile/$REPLAY.utrace"
+
+echo "Results: $PROJECT_DIR/Saved/ReplayProfile/$REPLAY.csv"
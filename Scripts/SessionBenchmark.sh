@@ -0,0 +1,21 @@
+#!/usr/bin/env bash
+# Runs session create/find/join/destroy cycles headless on the in process loopback backend.
+# Latency percentiles per operation, failures and leaked completion delegates are logged under Sessions.Benchmark,
+# the process exits with 1 when delegates or sessions leaked or an operation never completed.
+#
+# Usage: UE_ROOT=/path/to/UnrealEngine Scripts/SessionBenchmark.sh [Cycles] [Concurrency] [FailureRate] [MinLatency] [MaxLatency]
+
+set -euo pipefail
+
+CYCLES=${1:-5000}
+CONCURRENCY=${2:-500}
+FAILURE_RATE=${3:-0.02}
+MIN_LATENCY=${4:-0.02}
+MAX_LATENCY=${5:-0.3}
+
+PROJECT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="$PROJECT_DIR/Blaster.uproject"
+EDITOR="${UE_ROOT:?Set UE_ROOT to the engine root}/Engine/Binaries/Linux/UnrealEditor-Cmd"
+
+"$EDITOR" "$PROJECT" -game -nullrhi -nosound -nosteam -unattended -nopause -log -SessionBackend=Loopback \
+	-ExecCmds="Sessions.Benchmark $CYCLES $CONCURRENCY $FAILURE_RATE $MIN_LATENCY $MAX_LATENCY exit"
@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterAIController.h"
+#include "BotPerceptionSubsystem.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "Blaster/BlasterStats.h"
+#include "InputActionValue.h"
+#include "Kismet/KismetMathLibrary.h"
+
+ABlasterAIController::ABlasterAIController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	bWantsPlayerState = true;
+}
+
+void ABlasterAIController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Perception = GetWorld()->GetSubsystem<UBotPerceptionSubsystem>();
+	RandomStream.Initialize(GetTypeHash(GetName()));
+
+	// Spread thinking and sight checks of all bots over different frames
+	ThinkCountdown = RandomStream.FRandRange(0.f, ThinkInterval);
+	SightCheckCountdown = RandomStream.FRandRange(0.f, SightCheckInterval);
+}
+
+void ABlasterAIController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	Target = nullptr;
+	WeaponGoal = nullptr;
+	bTargetVisible = false;
+	bFiring = false;
+}
+
+void ABlasterAIController::OnUnPossess()
+{
+	StopFiring(Cast<ABlasterCharacter>(GetPawn()));
+
+	Super::OnUnPossess();
+}
+
+void ABlasterAIController::Tick(float DeltaTime)
+{
+	BLASTER_SCOPE(BotTick);
+
+	Super::Tick(DeltaTime);
+
+	ABlasterCharacter* BlasterCharacter = Cast<ABlasterCharacter>(GetPawn());
+	if (BlasterCharacter == nullptr || BlasterCharacter->IsElimmed()) return;
+
+	ThinkCountdown -= DeltaTime;
+	if (ThinkCountdown <= 0.f)
+	{
+		Think(BlasterCharacter);
+		ThinkCountdown = ThinkInterval;
+	}
+
+	if (ABlasterCharacter* CurrentTarget = Target.Get())
+	{
+		if (bTargetVisible)
+		{
+			AimAndFire(BlasterCharacter, DeltaTime);
+		}
+		else
+		{
+			SteerTowards(BlasterCharacter, CurrentTarget->GetActorLocation());
+		}
+	}
+	else if (AWeapon* Weapon = WeaponGoal.Get())
+	{
+		SteerTowards(BlasterCharacter, Weapon->GetActorLocation());
+	}
+}
+
+void ABlasterAIController::Think(ABlasterCharacter* BlasterCharacter)
+{
+	if (Perception == nullptr) return;
+
+	if (!BlasterCharacter->IsWeaponEquipped())
+	{
+		Target = nullptr;
+		// OverlappingWeapon is set by UBlasterInteractionSubsystem, equip it like a player would
+		if (BlasterCharacter->GetOverlappingWeapon())
+		{
+			BlasterCharacter->Equip_Input(FInputActionValue());
+			WeaponGoal = nullptr;
+		}
+		else
+		{
+			WeaponGoal = Perception->FindNearestWeapon(BlasterCharacter->GetActorLocation(), WeaponSearchRadius);
+		}
+		return;
+	}
+
+	WeaponGoal = nullptr;
+
+	AWeapon* EquippedWeapon = BlasterCharacter->GetEquippedWeapon();
+	if (EquippedWeapon && EquippedWeapon->IsEmpty() && BlasterCharacter->GetCombatState() != ECombatState::ECS_Reloading)
+	{
+		StopFiring(BlasterCharacter);
+		BlasterCharacter->Reload_Input();
+	}
+
+	ABlasterCharacter* NewTarget = Perception->FindNearestEnemy(BlasterCharacter, SightRadius);
+	if (NewTarget != Target.Get())
+	{
+		Target = NewTarget;
+		SightCheckCountdown = 0.f;
+	}
+
+	SightCheckCountdown -= ThinkInterval;
+	if (SightCheckCountdown <= 0.f)
+	{
+		bTargetVisible = Target.IsValid() && HasLineOfSight(BlasterCharacter, Target.Get());
+		SightCheckCountdown = SightCheckInterval;
+	}
+	if (!bTargetVisible)
+	{
+		StopFiring(BlasterCharacter);
+	}
+
+	AimOffset = FRotator(RandomStream.FRandRange(-AimError, AimError), RandomStream.FRandRange(-AimError, AimError), 0.f);
+}
+
+void ABlasterAIController::SteerTowards(ABlasterCharacter* BlasterCharacter, const FVector& Location)
+{
+	FVector ToLocation = Location - BlasterCharacter->GetActorLocation();
+	ToLocation.Z = 0.f;
+	if (ToLocation.SizeSquared() < FMath::Square(50.f)) return;
+
+	const FVector Direction = ToLocation.GetSafeNormal();
+	const FRotator YawRotation(0.f, GetControlRotation().Yaw, 0.f);
+	const FVector Forward = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
+	const FVector Right = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
+
+	// Move_Input expects X = right, Y = forward relative to the control rotation
+	BlasterCharacter->Move_Input(FInputActionValue(FVector2D(FVector::DotProduct(Direction, Right), FVector::DotProduct(Direction, Forward))));
+
+	FRotator ControlRotation = GetControlRotation();
+	ControlRotation.Yaw = Direction.Rotation().Yaw;
+	ControlRotation.Pitch = 0.f;
+	SetControlRotation(ControlRotation);
+}
+
+void ABlasterAIController::AimAndFire(ABlasterCharacter* BlasterCharacter, float DeltaTime)
+{
+	ABlasterCharacter* CurrentTarget = Target.Get();
+	if (CurrentTarget == nullptr || CurrentTarget->IsElimmed())
+	{
+		StopFiring(BlasterCharacter);
+		return;
+	}
+
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	BlasterCharacter->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+
+	// UCombatComponent traces along the control rotation to find HitTarget, so aiming is just rotating the controller
+	const FRotator DesiredRotation = (CurrentTarget->GetActorLocation() - EyeLocation).Rotation() + AimOffset;
+	const FRotator NewRotation = FMath::RInterpTo(GetControlRotation(), DesiredRotation, DeltaTime, AimInterpSpeed);
+	SetControlRotation(NewRotation);
+
+	const float AimDelta = FMath::Abs(UKismetMathLibrary::NormalizedDeltaRotator(NewRotation, DesiredRotation).Yaw);
+	const bool bShouldFire = AimDelta <= FireConeDegrees && BlasterCharacter->GetCombatState() == ECombatState::ECS_Unoccupied;
+	if (bShouldFire && !bFiring)
+	{
+		bFiring = true;
+		BlasterCharacter->Aim_Input();
+		BlasterCharacter->StartFire_Input();
+	}
+	else if (!bShouldFire && bFiring)
+	{
+		StopFiring(BlasterCharacter);
+	}
+}
+
+bool ABlasterAIController::HasLineOfSight(ABlasterCharacter* BlasterCharacter, ABlasterCharacter* InTarget) const
+{
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	BlasterCharacter->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(BlasterBotSight), false, BlasterCharacter);
+	Params.AddIgnoredActor(InTarget);
+	return !GetWorld()->LineTraceTestByChannel(EyeLocation, InTarget->GetActorLocation(), ECollisionChannel::ECC_Visibility, Params);
+}
+
+void ABlasterAIController::StopFiring(ABlasterCharacter* BlasterCharacter)
+{
+	if (!bFiring) return;
+	bFiring = false;
+	if (BlasterCharacter)
+	{
+		BlasterCharacter->EndFire_Input();
+		BlasterCharacter->UnAim_Input();
+	}
+}
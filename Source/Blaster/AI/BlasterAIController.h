@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "BlasterAIController.generated.h"
+
+class ABlasterCharacter;
+class AWeapon;
+class UBotPerceptionSubsystem;
+
+/**
+* Combat bot. Plays through ABlasterCharacter's input functions and UCombatComponent just like a player,
+* and respawns through ABlasterGameMode::RequestRespawn after being eliminated.
+*/
+UCLASS()
+class BLASTER_API ABlasterAIController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	ABlasterAIController();
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+
+	// Runs at ThinkInterval, picks goals and targets from the shared perception data
+	void Think(ABlasterCharacter* BlasterCharacter);
+	void SteerTowards(ABlasterCharacter* BlasterCharacter, const FVector& Location);
+	void AimAndFire(ABlasterCharacter* BlasterCharacter, float DeltaTime);
+	bool HasLineOfSight(ABlasterCharacter* BlasterCharacter, ABlasterCharacter* Target) const;
+	void StopFiring(ABlasterCharacter* BlasterCharacter);
+
+private:
+	UPROPERTY(EditDefaultsOnly, Category = Bot)
+	float ThinkInterval = 0.25f;
+
+	// Line of sight to the current target is only re-checked this often
+	UPROPERTY(EditDefaultsOnly, Category = Bot)
+	float SightCheckInterval = 0.5f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Bot)
+	float SightRadius = 5000.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Bot)
+	float WeaponSearchRadius = 10000.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Bot)
+	float AimInterpSpeed = 8.f;
+
+	// Random aim error in degrees, re-rolled on every think
+	UPROPERTY(EditDefaultsOnly, Category = Bot)
+	float AimError = 3.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Bot)
+	float FireConeDegrees = 5.f;
+
+	UPROPERTY()
+	UBotPerceptionSubsystem* Perception = nullptr;
+
+	TWeakObjectPtr<ABlasterCharacter> Target;
+	TWeakObjectPtr<AWeapon> WeaponGoal;
+
+	FRandomStream RandomStream;
+	float ThinkCountdown = 0.f;
+	float SightCheckCountdown = 0.f;
+	bool bTargetVisible = false;
+	bool bFiring = false;
+	FRotator AimOffset = FRotator::ZeroRotator;
+};
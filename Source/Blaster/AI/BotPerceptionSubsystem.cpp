@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BotPerceptionSubsystem.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/Interaction/BlasterInteractionSubsystem.h"
+#include "Blaster/BlasterStats.h"
+#include "EngineUtils.h"
+
+namespace
+{
+	FIntPoint CellFor(const FVector& Location, float CellSize)
+	{
+		return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+	}
+}
+
+void UBotPerceptionSubsystem::FGrid::Reset()
+{
+	Cells.Reset();
+	Locations.Reset();
+}
+
+void UBotPerceptionSubsystem::FGrid::Add(const FVector& Location, float InCellSize)
+{
+	const int32 Index = Locations.Add(Location);
+	Cells.FindOrAdd(CellFor(Location, InCellSize)).Add(Index);
+}
+
+template<typename VisitorType>
+void UBotPerceptionSubsystem::FGrid::ForEachInRadius(const FVector& Location, float Radius, float InCellSize, VisitorType Visit) const
+{
+	const FIntPoint Min = CellFor(Location - FVector(Radius), InCellSize);
+	const FIntPoint Max = CellFor(Location + FVector(Radius), InCellSize);
+	const float RadiusSquared = Radius * Radius;
+
+	for (int32 X = Min.X; X <= Max.X; ++X)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+			if (Cell == nullptr) continue;
+
+			for (int32 Index : *Cell)
+			{
+				const float DistSquared = FVector::DistSquared(Location, Locations[Index]);
+				if (DistSquared <= RadiusSquared)
+				{
+					Visit(Index, DistSquared);
+				}
+			}
+		}
+	}
+}
+
+bool UBotPerceptionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBotPerceptionSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (GetWorld()->GetNetMode() == NM_Client) return;
+
+	TimeSinceRebuild += DeltaTime;
+	if (TimeSinceRebuild >= UpdateInterval)
+	{
+		Rebuild();
+		TimeSinceRebuild = 0.f;
+	}
+}
+
+TStatId UBotPerceptionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBotPerceptionSubsystem, STATGROUP_Tickables);
+}
+
+void UBotPerceptionSubsystem::Rebuild()
+{
+	BLASTER_SCOPE(BotPerception);
+
+	CharacterGrid.Reset();
+	Characters.Reset();
+	for (TActorIterator<ABlasterCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->IsElimmed()) continue;
+		CharacterGrid.Add(It->GetActorLocation(), CellSize);
+		Characters.Add(*It);
+	}
+}
+
+ABlasterCharacter* UBotPerceptionSubsystem::FindNearestEnemy(const ABlasterCharacter* Seeker, float Radius) const
+{
+	if (Seeker == nullptr) return nullptr;
+
+	ABlasterCharacter* Nearest = nullptr;
+	float NearestDistSquared = TNumericLimits<float>::Max();
+	CharacterGrid.ForEachInRadius(Seeker->GetActorLocation(), Radius, CellSize, [&](int32 Index, float DistSquared)
+	{
+		ABlasterCharacter* Candidate = Characters[Index].Get();
+		if (Candidate && Candidate != Seeker && !Candidate->IsElimmed() && DistSquared < NearestDistSquared)
+		{
+			Nearest = Candidate;
+			NearestDistSquared = DistSquared;
+		}
+	});
+	return Nearest;
+}
+
+AWeapon* UBotPerceptionSubsystem::FindNearestWeapon(const FVector& Location, float Radius) const
+{
+	const UBlasterInteractionSubsystem* Interaction = GetWorld()->GetSubsystem<UBlasterInteractionSubsystem>();
+	return Interaction ? Interaction->FindNearestPickup(Location, Radius) : nullptr;
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BotPerceptionSubsystem.generated.h"
+
+class ABlasterCharacter;
+class AWeapon;
+
+/**
+* Shared, low rate spatial index of characters on the server.
+* Bots query it instead of running their own sight checks every tick. Weapons are looked up in the pickup index of
+* UBlasterInteractionSubsystem, which also decides what a character can pick up.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UBotPerceptionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	ABlasterCharacter* FindNearestEnemy(const ABlasterCharacter* Seeker, float Radius) const;
+	AWeapon* FindNearestWeapon(const FVector& Location, float Radius) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FGrid
+	{
+		TMap<FIntPoint, TArray<int32>> Cells;
+		TArray<FVector> Locations;
+
+		void Reset();
+		void Add(const FVector& Location, float CellSize);
+		// Calls Visit(Index, DistSquared) for every entry within Radius of Location
+		template<typename VisitorType>
+		void ForEachInRadius(const FVector& Location, float Radius, float CellSize, VisitorType Visit) const;
+	};
+
+	void Rebuild();
+
+	UPROPERTY(Config)
+	float UpdateInterval = 0.2f;
+
+	UPROPERTY(Config)
+	float CellSize = 2000.f;
+
+	float TimeSinceRebuild = 0.f;
+
+	FGrid CharacterGrid;
+	TArray<TWeakObjectPtr<ABlasterCharacter>> Characters;
+};
@@ -0,0 +1,9 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterArsenal.h"
+
+FPrimaryAssetId UBlasterArsenal::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(TEXT("BlasterArsenal"), GetFName());
+}
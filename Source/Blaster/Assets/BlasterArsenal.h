@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "BlasterArsenal.generated.h"
+
+class AWeapon;
+class UWeaponDefinition;
+
+/**
+* Everything a match can spawn, as primary asset BlasterArsenal. The Match bundle is streamed in during warmup
+* together with the soft references of these classes, see UBlasterAssetPreloadSubsystem.
+*/
+UCLASS()
+class BLASTER_API UBlasterArsenal : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	UPROPERTY(EditDefaultsOnly, Category = Arsenal, meta = (AssetBundles = "Match"))
+	TArray<TSoftClassPtr<AWeapon>> WeaponClasses;
+
+	UPROPERTY(EditDefaultsOnly, Category = Arsenal, meta = (AssetBundles = "Match"))
+	TArray<TSoftClassPtr<APawn>> CharacterClasses;
+
+	// Definitions a weapon can be switched to at runtime, clients need them loaded to resolve a replicated WeaponId
+	UPROPERTY(EditDefaultsOnly, Category = Arsenal, meta = (AssetBundles = "Match"))
+	TArray<TSoftObjectPtr<UWeaponDefinition>> WeaponDefinitions;
+};
@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterAssetPreloadSubsystem.h"
+#include "BlasterArsenal.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "Blaster/Weapon/WeaponDefinition.h"
+#include "Engine/AssetManager.h"
+#include "GameFramework/GameMode.h"
+#include "GameFramework/GameState.h"
+#include "EngineUtils.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace BlasterAssets
+{
+	const FPrimaryAssetType ArsenalType(TEXT("BlasterArsenal"));
+	const FName MatchBundle(TEXT("Match"));
+
+	void ReportSyncLoad(const FSoftObjectPath& Path)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Asset preload: %s was not preloaded, loading it synchronously"), *Path.ToString());
+	}
+}
+
+bool UBlasterAssetPreloadSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBlasterAssetPreloadSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	PreloadStartTime = FPlatformTime::Seconds();
+
+#if !UE_BUILD_SHIPPING
+	SyncLoadHandle = FCoreUObjectDelegates::OnSyncLoadPackage.AddUObject(this, &UBlasterAssetPreloadSubsystem::OnSyncLoadPackage);
+#endif
+
+	TArray<FPrimaryAssetId> ArsenalIds;
+	if (UAssetManager::IsInitialized())
+	{
+		UAssetManager::Get().GetPrimaryAssetIdList(BlasterAssets::ArsenalType, ArsenalIds);
+	}
+	TSharedPtr<FStreamableHandle> Handle = ArsenalIds.Num() > 0 ?
+		UAssetManager::Get().LoadPrimaryAssets(ArsenalIds, { BlasterAssets::MatchBundle }, FStreamableDelegate::CreateUObject(this, &UBlasterAssetPreloadSubsystem::OnArsenalLoaded)) :
+		nullptr;
+	if (Handle.IsValid() && !Handle->HasLoadCompleted())
+	{
+		Handles.Add(Handle);
+		return;
+	}
+	OnArsenalLoaded();
+}
+
+void UBlasterAssetPreloadSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::OnSyncLoadPackage.Remove(SyncLoadHandle);
+	for (const TSharedPtr<FStreamableHandle>& Handle : Handles)
+	{
+		Handle->ReleaseHandle();
+	}
+	Handles.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBlasterAssetPreloadSubsystem::OnArsenalLoaded()
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr) return;
+
+	TArray<UClass*> Classes;
+	TArray<const UObject*> Definitions;
+	TArray<UObject*> Arsenals;
+	if (UAssetManager::IsInitialized())
+	{
+		UAssetManager::Get().GetPrimaryAssetObjectList(BlasterAssets::ArsenalType, Arsenals);
+	}
+	for (UObject* Object : Arsenals)
+	{
+		if (const UBlasterArsenal* Arsenal = Cast<UBlasterArsenal>(Object))
+		{
+			for (const TSoftClassPtr<AWeapon>& WeaponClass : Arsenal->WeaponClasses)
+			{
+				Classes.AddUnique(WeaponClass.Get());
+			}
+			for (const TSoftClassPtr<APawn>& CharacterClass : Arsenal->CharacterClasses)
+			{
+				Classes.AddUnique(CharacterClass.Get());
+			}
+			for (const TSoftObjectPtr<UWeaponDefinition>& Definition : Arsenal->WeaponDefinitions)
+			{
+				Definitions.AddUnique(Definition.Get());
+			}
+		}
+	}
+
+	// Without an arsenal asset the level is the arsenal, clients know the game mode only through the game state
+	const AGameStateBase* GameState = World->GetGameState();
+	const AGameModeBase* GameModeDefaults = GameState ? GameState->GetDefaultGameMode() : nullptr;
+	if (GameModeDefaults)
+	{
+		Classes.AddUnique(GameModeDefaults->DefaultPawnClass);
+	}
+	for (TActorIterator<AWeapon> It(World); It; ++It)
+	{
+		Classes.AddUnique(It->GetClass());
+	}
+	Classes.Remove(nullptr);
+
+	// Assets of the arsenal's weapon definitions go into the first batch
+	TArray<FSoftObjectPath> DefinitionPaths;
+	for (const UObject* Definition : Definitions)
+	{
+		GatherObjectSoftReferences(Definition, DefinitionPaths);
+	}
+
+	LoadReferencedAssets(Classes, MoveTemp(DefinitionPaths));
+}
+
+void UBlasterAssetPreloadSubsystem::LoadReferencedAssets(const TArray<UClass*>& Classes, TArray<FSoftObjectPath> Paths)
+{
+	for (UClass* Class : Classes)
+	{
+		GatherSoftReferences(Class, Paths);
+	}
+
+	if (Paths.Num() == 0)
+	{
+		bPreloadComplete = true;
+		UE_LOG(LogTemp, Log, TEXT("Asset preload: %d assets in %.2fs"), RequestedPaths.Num(), FPlatformTime::Seconds() - PreloadStartTime);
+		return;
+	}
+
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths,
+		FStreamableDelegate::CreateUObject(this, &UBlasterAssetPreloadSubsystem::OnReferencedAssetsLoaded, Paths),
+		FStreamableManager::AsyncLoadHighPriority);
+	if (Handle.IsValid())
+	{
+		Handles.Add(Handle);
+	}
+	else
+	{
+		OnReferencedAssetsLoaded(Paths);
+	}
+}
+
+void UBlasterAssetPreloadSubsystem::OnReferencedAssetsLoaded(TArray<FSoftObjectPath> Paths)
+{
+	// Loaded classes, projectiles and casings, have soft references of their own
+	TArray<UClass*> Classes;
+	for (const FSoftObjectPath& Path : Paths)
+	{
+		if (UClass* Class = Cast<UClass>(Path.ResolveObject()))
+		{
+			Classes.Add(Class);
+		}
+	}
+	LoadReferencedAssets(Classes);
+}
+
+void UBlasterAssetPreloadSubsystem::GatherSoftReferences(UClass* Class, TArray<FSoftObjectPath>& OutPaths)
+{
+	if (Class == nullptr || VisitedClasses.Contains(Class)) return;
+	VisitedClasses.Add(Class);
+
+	GatherObjectSoftReferences(Class->GetDefaultObject(), OutPaths);
+}
+
+void UBlasterAssetPreloadSubsystem::GatherObjectSoftReferences(const UObject* Object, TArray<FSoftObjectPath>& OutPaths)
+{
+	if (Object == nullptr || VisitedObjects.Contains(Object)) return;
+	VisitedObjects.Add(Object);
+
+	for (TFieldIterator<FSoftObjectProperty> It(Object->GetClass()); It; ++It)
+	{
+		for (int32 Index = 0; Index < It->ArrayDim; ++Index)
+		{
+			const FSoftObjectPath& Path = It->GetPropertyValuePtr_InContainer(Object, Index)->ToSoftObjectPath();
+			if (Path.IsNull() || RequestedPaths.Contains(Path)) continue;
+
+			RequestedPaths.Add(Path);
+			OutPaths.Add(Path);
+		}
+	}
+
+	// Weapon definitions and other data assets hold the soft references of the classes pointing at them
+	for (TFieldIterator<FObjectProperty> It(Object->GetClass()); It; ++It)
+	{
+		if (!It->PropertyClass->IsChildOf(UDataAsset::StaticClass())) continue;
+
+		for (int32 Index = 0; Index < It->ArrayDim; ++Index)
+		{
+			GatherObjectSoftReferences(It->GetObjectPropertyValue_InContainer(Object, Index), OutPaths);
+		}
+	}
+}
+
+void UBlasterAssetPreloadSubsystem::OnSyncLoadPackage(const FString& PackageName)
+{
+	const AGameState* GameState = GetWorld() ? GetWorld()->GetGameState<AGameState>() : nullptr;
+	if (GameState && GameState->GetMatchState() == MatchState::InProgress)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Asset preload: synchronous load of %s during the match"), *PackageName);
+	}
+}
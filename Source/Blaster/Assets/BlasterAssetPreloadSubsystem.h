@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "BlasterAssetPreloadSubsystem.generated.h"
+
+/**
+* Streams weapon, projectile, FX and montage assets in asynchronously while the match warms up.
+* Starts from the Match bundle of every BlasterArsenal asset, the default pawn and the weapons in the level, and follows
+* the soft references on their class defaults until nothing new turns up. Loaded assets stay resident for the world.
+* The game mode holds the match in warmup until preloading completed. Outside shipping builds any synchronous load
+* while the match is in progress is logged.
+*/
+UCLASS()
+class BLASTER_API UBlasterAssetPreloadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	FORCEINLINE bool IsPreloadComplete() const { return bPreloadComplete; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void OnArsenalLoaded();
+	void LoadReferencedAssets(const TArray<UClass*>& Classes, TArray<FSoftObjectPath> Paths = TArray<FSoftObjectPath>());
+	void OnReferencedAssetsLoaded(TArray<FSoftObjectPath> Paths);
+	void GatherSoftReferences(UClass* Class, TArray<FSoftObjectPath>& OutPaths);
+	void GatherObjectSoftReferences(const UObject* Object, TArray<FSoftObjectPath>& OutPaths);
+	void OnSyncLoadPackage(const FString& PackageName);
+
+	TArray<TSharedPtr<FStreamableHandle>> Handles;
+	TSet<FSoftObjectPath> RequestedPaths;
+	TSet<UClass*> VisitedClasses;
+	TSet<const UObject*> VisitedObjects;
+	bool bPreloadComplete = false;
+	double PreloadStartTime = 0.0;
+	FDelegateHandle SyncLoadHandle;
+};
+
+namespace BlasterAssets
+{
+	BLASTER_API void ReportSyncLoad(const FSoftObjectPath& Path);
+
+	// Returns the asset the preloader streamed in, anything it missed is loaded synchronously and reported
+	template<typename T>
+	T* Get(const TSoftObjectPtr<T>& Asset)
+	{
+		T* Loaded = Asset.Get();
+		if (Loaded == nullptr && !Asset.IsNull())
+		{
+			ReportSyncLoad(Asset.ToSoftObjectPath());
+			Loaded = Asset.LoadSynchronous();
+		}
+		return Loaded;
+	}
+
+	template<typename T>
+	UClass* Get(const TSoftClassPtr<T>& Class)
+	{
+		UClass* Loaded = Class.Get();
+		if (Loaded == nullptr && !Class.IsNull())
+		{
+			ReportSyncLoad(Class.ToSoftObjectPath());
+			Loaded = Class.LoadSynchronous();
+		}
+		return Loaded;
+	}
+}
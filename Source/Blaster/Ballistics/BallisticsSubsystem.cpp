@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BallisticsSubsystem.h"
+#include "Blaster/Weapon/Projectile.h"
+#include "Blaster/Blaster.h"
+#include "Blaster/BlasterStats.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+namespace
+{
+	// Keeps a redirected bullet from tracing into the surface it just left
+	constexpr float SurfaceOffset = 0.5f;
+}
+
+bool UBallisticsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallisticsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SurfaceTable.SetNum(SurfaceType_Max);
+	for (const FBallisticsSurface& Surface : Surfaces)
+	{
+		SurfaceTable[Surface.Surface] = Surface;
+	}
+
+	// What the projectile's collision box blocked
+	ObjectParams.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldStatic);
+	ObjectParams.AddObjectTypesToQuery(ECC_SkeletalMesh);
+}
+
+TStatId UBallisticsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBallisticsSubsystem, STATGROUP_Tickables);
+}
+
+void UBallisticsSubsystem::AddProjectile(AProjectile* Projectile)
+{
+	if (Projectile == nullptr) return;
+
+	const UProjectileMovementComponent* Movement = Projectile->GetProjectileMovementComponent();
+	FBullet& Bullet = Bullets.AddDefaulted_GetRef();
+	Bullet.Projectile = Projectile;
+	Bullet.Location = Projectile->GetActorLocation();
+	Bullet.Velocity = Movement ? Movement->Velocity : Projectile->GetActorForwardVector();
+	Bullet.GravityZ = Movement ? Movement->GetGravityZ() : GetWorld()->GetGravityZ();
+	Bullet.MuzzleSpeed = Bullet.Velocity.Size();
+	Bullet.Time = GetWorld()->GetTimeSeconds();
+	Bullet.SpawnTime = Bullet.Time;
+}
+
+void UBallisticsSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (GetWorld()->GetNetMode() == NM_Client || Bullets.Num() == 0) return;
+
+	BLASTER_SCOPE(Ballistics);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const int32 NumBullets = Bullets.Num();
+	int32 TraceBudget = MaxTracesPerFrame;
+	int32 FirstDeferred = INDEX_NONE;
+	int32 NumDeferred = 0;
+
+	for (int32 Step = 0; Step < NumBullets; ++Step)
+	{
+		const int32 Index = (NextBullet + Step) % NumBullets;
+		FBullet& Bullet = Bullets[Index];
+		const EAdvanceResult Result = TraceBudget > 0 ? Advance(Bullet, Now, TraceBudget) : EAdvanceResult::OutOfBudget;
+		Bullet.bFinished = Result == EAdvanceResult::Finished;
+		if (Result == EAdvanceResult::OutOfBudget)
+		{
+			FirstDeferred = FirstDeferred == INDEX_NONE ? Index : FirstDeferred;
+			++NumDeferred;
+		}
+	}
+
+	CSV_CUSTOM_STAT(Blaster, BallisticsTraces, MaxTracesPerFrame - TraceBudget, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(Blaster, BallisticsDeferred, NumDeferred, ECsvCustomStatOp::Set);
+
+	// Keep the place of the first bullet that did not get its turn
+	int32 NumFinishedBefore = 0;
+	if (FirstDeferred != INDEX_NONE)
+	{
+		for (int32 Index = 0; Index < FirstDeferred; ++Index)
+		{
+			NumFinishedBefore += Bullets[Index].bFinished ? 1 : 0;
+		}
+	}
+	Bullets.RemoveAll([](const FBullet& Bullet) { return Bullet.bFinished; });
+	NextBullet = FirstDeferred != INDEX_NONE && Bullets.Num() > 0 ? (FirstDeferred - NumFinishedBefore) % Bullets.Num() : 0;
+}
+
+UBallisticsSubsystem::EAdvanceResult UBallisticsSubsystem::Advance(FBullet& Bullet, double Now, int32& TraceBudget)
+{
+	AProjectile* Projectile = Bullet.Projectile.Get();
+	if (Projectile == nullptr) return EAdvanceResult::Finished;
+
+	if (Now - Bullet.SpawnTime > MaxFlightTime || Bullet.Velocity.SizeSquared() < FMath::Square(MinSpeed))
+	{
+		Projectile->Destroy();
+		return EAdvanceResult::Finished;
+	}
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(BlasterBallistics), false, Projectile);
+	Params.bReturnPhysicalMaterial = true;
+	if (APawn* Shooter = Projectile->GetInstigator())
+	{
+		Params.AddIgnoredActor(Shooter);
+	}
+
+	const FVector Gravity(0.f, 0.f, Bullet.GravityZ);
+	float TimeLeft = float(Now - Bullet.Time);
+	while (TimeLeft > UE_KINDA_SMALL_NUMBER)
+	{
+		if (TraceBudget <= 0)
+		{
+			Bullet.Time = Now - TimeLeft;
+			Projectile->SetActorLocationAndRotation(Bullet.Location, Bullet.Velocity.Rotation());
+			return EAdvanceResult::OutOfBudget;
+		}
+
+		// One straight chord per step, the drop of the whole step is in its end point
+		const FVector End = Bullet.Location + Bullet.Velocity * TimeLeft + 0.5f * Gravity * FMath::Square(TimeLeft);
+		--TraceBudget;
+
+		FHitResult Hit;
+		if (!GetWorld()->LineTraceSingleByObjectType(Hit, Bullet.Location, End, ObjectParams, Params))
+		{
+			Bullet.Location = End;
+			Bullet.Velocity += Gravity * TimeLeft;
+			break;
+		}
+
+		const float Elapsed = TimeLeft * Hit.Time;
+		TimeLeft -= Elapsed;
+		Bullet.Location = Hit.ImpactPoint;
+		Bullet.Velocity += Gravity * Elapsed;
+
+		const float SpeedBefore = Bullet.Velocity.Size();
+		const bool bGoesOn = Cast<APawn>(Hit.GetActor()) == nullptr && Bullet.Segments < MaxSegmentsPerBullet && PassOrGlance(Bullet, Hit, TraceBudget);
+		if (!bGoesOn)
+		{
+			Projectile->SetActorLocation(Hit.ImpactPoint);
+			Projectile->Impact(Hit);
+			return EAdvanceResult::Finished;
+		}
+
+		++Bullet.Segments;
+		Projectile->Redirect(Bullet.Location, Bullet.Velocity, SpeedBefore > 0.f ? Bullet.Velocity.Size() / SpeedBefore : 0.f);
+	}
+
+	Bullet.Time = Now;
+	Projectile->SetActorLocationAndRotation(Bullet.Location, Bullet.Velocity.Rotation());
+	return EAdvanceResult::InFlight;
+}
+
+bool UBallisticsSubsystem::PassOrGlance(FBullet& Bullet, const FHitResult& Hit, int32& TraceBudget)
+{
+	const FBallisticsSurface& Surface = GetSurface(Hit);
+	const float Speed = Bullet.Velocity.Size();
+	if (Speed <= 0.f) return false;
+	const FVector Direction = Bullet.Velocity / Speed;
+
+	const float GlanceAngle = 90.f - FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(-FVector::DotProduct(Direction, Hit.ImpactNormal), -1.f, 1.f)));
+	if (GlanceAngle <= Surface.RicochetAngle)
+	{
+		Bullet.Velocity = Bullet.Velocity.MirrorByVector(Hit.ImpactNormal) * Surface.RicochetSpeedScale;
+		Bullet.Location = Hit.ImpactPoint + Hit.ImpactNormal * SurfaceOffset;
+		return true;
+	}
+
+	UPrimitiveComponent* Component = Hit.GetComponent();
+	if (Surface.PenetrationDepth <= 0.f || Component == nullptr || TraceBudget <= 0) return false;
+
+	// Slower bullets pass less, trace back from as deep as this one reaches to find where it comes out
+	const float Reach = Surface.PenetrationDepth * (Bullet.MuzzleSpeed > 0.f ? Speed / Bullet.MuzzleSpeed : 1.f);
+	--TraceBudget;
+	FHitResult Exit;
+	const FCollisionQueryParams ExitParams(SCENE_QUERY_STAT(BlasterBallisticsExit), false);
+	if (!Component->LineTraceComponent(Exit, Hit.ImpactPoint + Direction * Reach, Hit.ImpactPoint, ExitParams) || Exit.bStartPenetrating)
+	{
+		return false;
+	}
+
+	const float Thickness = FVector::Dist(Hit.ImpactPoint, Exit.ImpactPoint);
+	Bullet.Velocity *= FMath::Max(1.f - Thickness / Reach, 0.f);
+	Bullet.Location = Exit.ImpactPoint + Direction * SurfaceOffset;
+	return true;
+}
+
+const FBallisticsSurface& UBallisticsSubsystem::GetSurface(const FHitResult& Hit) const
+{
+	const EPhysicalSurface SurfaceType = UPhysicalMaterial::DetermineSurfaceType(Hit.PhysMaterial.Get());
+	return SurfaceTable[SurfaceType];
+}
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Chaos/ChaosEngineInterface.h"
+#include "BallisticsSubsystem.generated.h"
+
+class AProjectile;
+
+/**
+* How bullets react to one physical surface type
+*/
+USTRUCT()
+struct FBallisticsSurface
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+	TEnumAsByte<EPhysicalSurface> Surface = SurfaceType_Default;
+
+	// Thickness of this material a bullet at full speed passes through, 0 stops every bullet
+	UPROPERTY(EditAnywhere)
+	float PenetrationDepth = 0.f;
+
+	// Largest angle between the surface and the bullet's path that still ricochets, 0 never ricochets
+	UPROPERTY(EditAnywhere)
+	float RicochetAngle = 0.f;
+
+	// Share of the speed a ricochet keeps
+	UPROPERTY(EditAnywhere)
+	float RicochetSpeedScale = 0.6f;
+};
+
+/**
+* Server side flight of projectiles: gravity drop, penetration through thin surfaces and ricochets.
+* All bullets advance in one pass after actors ticked, one trace per segment, under MaxTracesPerFrame. Bullets the
+* budget did not reach this frame keep their pending time and continue first next frame.
+* A bullet stops for good on a pawn, on a surface it can neither pass nor glance off, or after MaxSegmentsPerBullet.
+* Clients keep simulating their own projectile movement, only penetrations and ricochets are sent to them.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UBallisticsSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Takes over the flight of a projectile on the server
+	void AddProjectile(AProjectile* Projectile);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FBullet
+	{
+		TWeakObjectPtr<AProjectile> Projectile;
+		FVector Location = FVector::ZeroVector;
+		FVector Velocity = FVector::ZeroVector;
+		float GravityZ = 0.f;
+		float MuzzleSpeed = 0.f;
+		// Time of the world the bullet has been advanced to
+		double Time = 0.0;
+		double SpawnTime = 0.0;
+		int32 Segments = 1;
+		bool bFinished = false;
+	};
+
+	enum class EAdvanceResult : uint8
+	{
+		InFlight,
+		OutOfBudget,
+		Finished
+	};
+
+	EAdvanceResult Advance(FBullet& Bullet, double Now, int32& TraceBudget);
+	// Returns true when the bullet goes on past Hit, the bullet is moved onto its new path
+	bool PassOrGlance(FBullet& Bullet, const FHitResult& Hit, int32& TraceBudget);
+	const FBallisticsSurface& GetSurface(const FHitResult& Hit) const;
+
+	UPROPERTY(Config)
+	int32 MaxTracesPerFrame = 256;
+
+	// Straight legs of one bullet, every penetration or ricochet starts a new one
+	UPROPERTY(Config)
+	int32 MaxSegmentsPerBullet = 4;
+
+	UPROPERTY(Config)
+	float MaxFlightTime = 3.f;
+
+	// Below this speed a bullet is spent
+	UPROPERTY(Config)
+	float MinSpeed = 1000.f;
+
+	UPROPERTY(Config)
+	TArray<FBallisticsSurface> Surfaces;
+
+	// Surfaces indexed by EPhysicalSurface, built from Surfaces once
+	TArray<FBallisticsSurface> SurfaceTable;
+
+	FCollisionObjectQueryParams ObjectParams;
+
+	TArray<FBullet> Bullets;
+	// First bullet to advance next frame, moves on when the budget runs out so every bullet gets its turn
+	int32 NextBullet = 0;
+};
@@ -14,6 +14,11 @@
 #include "Blaster/HUD/BlasterHUD.h"
 #include "../DebugHelper.h"
 #include "TimerManager.h"
+#include "Blaster/LoadTest/BlasterLoadTestSubsystem.h"
+#include "Blaster/BlasterStats.h"
+#include "Blaster/BlasterServerLean.h"
+#include "Blaster/Cosmetics/BlasterCosmeticsSubsystem.h"
+#include "Blaster/Weapon/WeaponDefinition.h"
 
 UCombatComponent::UCombatComponent()
 {
@@ -25,6 +30,9 @@ UCombatComponent::UCombatComponent()
 
 void UCombatComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+  BLASTER_SCOPE(CombatTick);
+  LLM_SCOPE_BYTAG(Blaster_Combat);
+
   Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
   if (Character && Character->IsLocallyControlled())
@@ -43,7 +51,7 @@ void UCombatComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Out
 
   DOREPLIFETIME(UCombatComponent, EquippedWeapon);
   DOREPLIFETIME(UCombatComponent, bAiming);
-  DOREPLIFETIME(UCombatComponent, CombatState);
+  DOREPLIFETIME_CONDITION(UCombatComponent, CombatState, COND_SkipOwner);
 }
 
 void UCombatComponent::BeginPlay()
@@ -58,6 +66,8 @@ void UCombatComponent::BeginPlay()
 
 void UCombatComponent::SetHUDCrosshairs(float DeltaTime)
 {
+  BLASTER_SCOPE(HUDUpdate);
+
   if (Character == nullptr || Character->Controller == nullptr) return;
 
   Controller = Controller == nullptr ? Cast<ABlasterPlayerController>(Character->Controller) : Controller;
@@ -66,23 +76,44 @@ void UCombatComponent::SetHUDCrosshairs(float DeltaTime)
     HUD = HUD == nullptr ? Cast<ABlasterHUD>(Controller->GetHUD()) : HUD;
     if (HUD)
     {
-      if (EquippedWeapon)
+      // A weapon's definition can replicate after the weapon itself, so this follows the definition rather than the equip
+      const UWeaponDefinition* Definition = EquippedWeapon ? EquippedWeapon->GetDefinition() : nullptr;
+      if (Definition != CrosshairsDefinition || bCrosshairsPending)
       {
-        HUDPackage.CrosshairsCenter = EquippedWeapon->CrosshairsCenter;
-        HUDPackage.CrosshairsLeft = EquippedWeapon->CrosshairsLeft;
-        HUDPackage.CrosshairsRight = EquippedWeapon->CrosshairsRight;
-        HUDPackage.CrosshairsBottom = EquippedWeapon->CrosshairsBottom;
-        HUDPackage.CrosshairsTop = EquippedWeapon->CrosshairsTop;
+        CacheCrosshairs(Definition);
       }
-      else
+      HUD->SetHUDPackage(HUDPackage);
+    }
+  }
+}
+
+void UCombatComponent::CacheCrosshairs(const UWeaponDefinition* Definition)
+{
+  const bool bChanged = Definition != CrosshairsDefinition;
+  CrosshairsDefinition = Definition;
+  bCrosshairsPending = false;
+
+  UTexture2D** Textures[] = { &HUDPackage.CrosshairsCenter, &HUDPackage.CrosshairsLeft, &HUDPackage.CrosshairsRight, &HUDPackage.CrosshairsTop, &HUDPackage.CrosshairsBottom };
+  const TSoftObjectPtr<UTexture2D>* Crosshairs[] = { nullptr, nullptr, nullptr, nullptr, nullptr };
+  if (Definition)
+  {
+    Crosshairs[0] = &Definition->CrosshairsCenter;
+    Crosshairs[1] = &Definition->CrosshairsLeft;
+    Crosshairs[2] = &Definition->CrosshairsRight;
+    Crosshairs[3] = &Definition->CrosshairsTop;
+    Crosshairs[4] = &Definition->CrosshairsBottom;
+  }
+  for (int32 Index = 0; Index < UE_ARRAY_COUNT(Textures); ++Index)
+  {
+    *Textures[Index] = Crosshairs[Index] ? Crosshairs[Index]->Get() : nullptr;
+    // Never loaded here, a crosshair the preloader has not streamed in yet is drawn once it arrives
+    if (*Textures[Index] == nullptr && Crosshairs[Index] && !Crosshairs[Index]->IsNull())
+    {
+      if (bChanged)
       {
-        HUDPackage.CrosshairsCenter = nullptr;
-        HUDPackage.CrosshairsLeft = nullptr;
-        HUDPackage.CrosshairsRight = nullptr;
-        HUDPackage.CrosshairsBottom = nullptr;
-        HUDPackage.CrosshairsTop = nullptr;
+        UE_LOG(LogTemp, Warning, TEXT("Crosshair %s of %s is not loaded yet"), *Crosshairs[Index]->ToString(), *Definition->GetName());
       }
-      HUD->SetHUDPackage(HUDPackage);
+      bCrosshairsPending = true;
     }
   }
 }
@@ -107,6 +138,7 @@ void UCombatComponent::EquipWeapon(AWeapon* weapon)
   if (Character == nullptr || weapon == nullptr) return;
   if (EquippedWeapon)
   {
+    CancelReload();
     EquippedWeapon->Dropped();
   }
   EquippedWeapon = weapon;
@@ -118,6 +150,7 @@ void UCombatComponent::EquipWeapon(AWeapon* weapon)
   }
   EquippedWeapon->SetOwner(Character);
   EquippedWeapon->SetHUDAmmo();
+  EquippedWeapon->SyncAmmoToOwner();
   if (EquippedWeapon->IsEmpty())
   {
     Reload();
@@ -138,6 +171,7 @@ void UCombatComponent::SetAiming(bool aiming)
 
 void UCombatComponent::ServerSetAiming_Implementation(bool bIsAiming)
 {
+  BLASTER_COUNT_RPC(ServerSetAiming);
   bAiming = bIsAiming;
   if (Character)
   {
@@ -148,6 +182,10 @@ void UCombatComponent::ServerSetAiming_Implementation(bool bIsAiming)
 void UCombatComponent::FireButtonPressed(bool bPressed)
 {
   bFireButtonPressed = bPressed;
+  if (bPressed && CombatState == ECombatState::ECS_Reloading)
+  {
+    bFireBuffered = true;
+  }
   if (bFireButtonPressed && EquippedWeapon)
   {
     Fire();
@@ -159,25 +197,33 @@ void UCombatComponent::Fire()
   if (CanFire())
   {
     bCanFire = false;
-    ServerFire(HitTarget);
+    uint16 ShotSequence = 0;
+    if (!Character->HasAuthority())
+    {
+      // The owner sees its shot at once, the server leaves it out of the owner's cosmetic events.
+      // Its own seed only shapes what it sees, the server's pellets come from the server's seed
+      ShotSequence = EquippedWeapon->PredictShot();
+      LocalFire(HitTarget, uint16(FMath::Rand()));
+    }
+    ServerFire(HitTarget, ShotSequence);
     StartFireTimer();
   }
 }
 
 bool UCombatComponent::CanFire()
 {
-  if (EquippedWeapon == nullptr) return false;
+  if (EquippedWeapon == nullptr || EquippedWeapon->GetDefinition() == nullptr) return false;
   return !EquippedWeapon->IsEmpty() && bCanFire && CombatState == ECombatState::ECS_Unoccupied;
 }
 
 void UCombatComponent::StartFireTimer()
 {
-  if (EquippedWeapon == nullptr || Character == nullptr) return;
+  if (EquippedWeapon == nullptr || EquippedWeapon->GetDefinition() == nullptr || Character == nullptr) return;
   Character->GetWorldTimerManager().SetTimer(
     FireTimer,
     this,
     &UCombatComponent::FireTimerFinished,
-    EquippedWeapon->FireDelay
+    EquippedWeapon->GetDefinition()->FireDelay
   );
 }
 
@@ -185,7 +231,7 @@ void UCombatComponent::FireTimerFinished()
 {
   if (EquippedWeapon == nullptr) return;
   bCanFire = true;
-  if (bFireButtonPressed && EquippedWeapon->bAutomatic)
+  if (bFireButtonPressed && EquippedWeapon->GetDefinition() && EquippedWeapon->GetDefinition()->bAutomatic)
   {
     Fire();
   }
@@ -195,63 +241,189 @@ void UCombatComponent::FireTimerFinished()
   }
 }
 
-void UCombatComponent::ServerFire_Implementation(const FVector_NetQuantize& TraceHitTarget)
+void UCombatComponent::ServerFire_Implementation(const FVector_NetQuantize& TraceHitTarget, uint16 ShotSequence)
 {
-  MulticastFire(TraceHitTarget);
+  BLASTER_COUNT_RPC(ServerFire);
+  if (EquippedWeapon == nullptr) return;
+
+  if (CombatState == ECombatState::ECS_Reloading && IsRemotelyControlled() && GetWorld()->GetTimeSeconds() >= ReloadEndTime - MaxReloadLead)
+  {
+    FinishReloading();
+  }
+
+  // The client predicted this shot, tell it when the server disagrees
+  if (EquippedWeapon->IsEmpty() || CombatState != ECombatState::ECS_Unoccupied)
+  {
+    EquippedWeapon->RejectShot(ShotSequence);
+    return;
+  }
+  // Chosen here, a seed from the client could be one that packs every pellet onto the target
+  const uint16 FireSeed = uint16(FMath::Rand());
+  LocalFire(TraceHitTarget, FireSeed);
+  EquippedWeapon->ConfirmShot(ShotSequence);
+  if (UBlasterCosmeticsSubsystem* Cosmetics = GetWorld()->GetSubsystem<UBlasterCosmeticsSubsystem>())
+  {
+    Cosmetics->QueueFire(Character, TraceHitTarget, FireSeed);
+  }
 }
 
-void UCombatComponent::MulticastFire_Implementation(const FVector_NetQuantize& TraceHitTarget)
+void UCombatComponent::LocalFire(const FVector& TraceHitTarget, uint16 FireSeed)
 {
   if (EquippedWeapon == nullptr) return;
   if (Character && CombatState == ECombatState::ECS_Unoccupied)
   {
     Character->PlayFireMontage(bAiming);
-    EquippedWeapon->Fire(TraceHitTarget);
+    EquippedWeapon->Fire(TraceHitTarget, FireSeed);
+  }
+}
+
+namespace
+{
+  // Reload numbers wrap around, a is newer when it is less than half the range ahead of b
+  bool IsNewerReload(uint8 a, uint8 b)
+  {
+    return int8(a - b) > 0;
   }
 }
 
 void UCombatComponent::Reload()
 {
-  if (CombatState != ECombatState::ECS_Reloading)
-    ServerReload();
+  if (!CanReload()) return;
+
+  if (Character->HasAuthority())
+  {
+    // Bots and the listen server's player, or the server reloading for a remote owner after equipping an empty weapon
+    StartReload();
+    SendCombatStateToOwner();
+    return;
+  }
+  ++ReloadSequence;
+  StartReload();
+  ServerReload(ReloadSequence);
 }
 
-void UCombatComponent::ServerReload_Implementation()
+bool UCombatComponent::CanReload() const
 {
-  if (Character == nullptr || EquippedWeapon == nullptr) return;
+  return Character && EquippedWeapon && CombatState != ECombatState::ECS_Reloading &&
+    EquippedWeapon->GetAmmo() < EquippedWeapon->GetMagCapacity();
+}
 
+void UCombatComponent::StartReload()
+{
   CombatState = ECombatState::ECS_Reloading;
-  HandleReload();
+  const float ReloadDuration = Character->PlayReloadMontage();
+  ReloadEndTime = GetWorld()->GetTimeSeconds() + ReloadDuration;
+  // No montage plays on a lean server, so no notify will finish the reload
+  if (BlasterServerLean::IsEnabled())
+  {
+    Character->GetWorldTimerManager().SetTimer(ReloadTimer, this, &UCombatComponent::FinishReloading, FMath::Max(ReloadDuration, UE_KINDA_SMALL_NUMBER));
+  }
 }
 
-void UCombatComponent::FinishReloading()
+void UCombatComponent::ServerReload_Implementation(uint8 Sequence)
+{
+  BLASTER_COUNT_RPC(ServerReload);
+  if (Character == nullptr || EquippedWeapon == nullptr) return;
+
+  ReloadSequence = Sequence;
+  if (!CanReload())
+  {
+    SendCombatStateToOwner();
+    return;
+  }
+  StartReload();
+}
+
+void UCombatComponent::CancelReload()
 {
   if (Character == nullptr) return;
-  if (Character->HasAuthority())
+
+  Character->GetWorldTimerManager().ClearTimer(ReloadTimer);
+  if (CombatState == ECombatState::ECS_Reloading)
   {
     CombatState = ECombatState::ECS_Unoccupied;
+    Character->StopReloadMontage();
+    SendCombatStateToOwner();
+  }
+}
+
+void UCombatComponent::FinishReloading()
+{
+  if (Character == nullptr || CombatState != ECombatState::ECS_Reloading) return;
+
+  CombatState = ECombatState::ECS_Unoccupied;
+  if (Character->HasAuthority())
+  {
     if (EquippedWeapon)
       EquippedWeapon->SetAmmo(EquippedWeapon->GetMagCapacity());
+    SendCombatStateToOwner();
+  }
+  else if (Character->IsLocallyControlled() && EquippedWeapon)
+  {
+    EquippedWeapon->PredictRefill();
   }
-  if (bFireButtonPressed)
+  ResumeBufferedFire();
+}
+
+void UCombatComponent::ResumeBufferedFire()
+{
+  const bool bWantsFire = bFireButtonPressed || bFireBuffered;
+  bFireBuffered = false;
+  if (bWantsFire)
   {
     Fire();
   }
 }
 
+bool UCombatComponent::IsRemotelyControlled() const
+{
+  return Character && Character->HasAuthority() && !Character->IsLocallyControlled();
+}
+
+void UCombatComponent::SendCombatStateToOwner()
+{
+  if (IsRemotelyControlled())
+  {
+    BLASTER_COUNT_RPC(ClientCorrectCombatState);
+    ClientCorrectCombatState(CombatState, ReloadSequence);
+  }
+}
+
+void UCombatComponent::ClientCorrectCombatState_Implementation(ECombatState ServerState, uint8 Sequence)
+{
+  // The owner already predicted another reload, the server answers that one separately
+  if (IsNewerReload(ReloadSequence, Sequence) || ServerState == CombatState || Character == nullptr) return;
+
+  if (ServerState == ECombatState::ECS_Reloading)
+  {
+    // A reload the server started by itself, or one the owner finished too early
+    StartReload();
+    return;
+  }
+
+  // Refused or finished on the server before the montage here got there, the ammo arrives with ClientSyncAmmo
+  Character->StopReloadMontage();
+  CombatState = ServerState;
+  ResumeBufferedFire();
+}
+
 void UCombatComponent::OnRep_CombatState()
 {
   switch (CombatState)
   {
   case ECombatState::ECS_Reloading:
-    HandleReload();
-    break;
-  case ECombatState::ECS_Unoccupied:
-    if (bFireButtonPressed)
     {
-      Fire();
+      // Reloading is replicated state, only its montage is culled like the other cosmetics
+      const UBlasterCosmeticsSubsystem* Cosmetics = GetWorld()->GetSubsystem<UBlasterCosmeticsSubsystem>();
+      if (Cosmetics == nullptr || Cosmetics->ShouldPlayLocally(Character))
+      {
+        HandleReload();
+      }
     }
     break;
+  case ECombatState::ECS_Unoccupied:
+    ResumeBufferedFire();
+    break;
   }
 }
 
@@ -263,21 +435,37 @@ void UCombatComponent::HandleReload()
 
 void UCombatComponent::TraceUnderCrosshairs(FHitResult& TraceHitResult)
 {
-  FVector2D ViewportSize;
+  BLASTER_SCOPE(TraceUnderCrosshairs);
+
+  FVector CrosshairWorldPosition;
+  FVector CrosshairWorldDirection;
+  bool bScreenToWorld = false;
+
+  FVector2D ViewportSize = FVector2D::ZeroVector;
   if (GEngine && GEngine->GameViewport)
   {
     GEngine->GameViewport->GetViewportSize(ViewportSize);
   }
 
-  FVector2D CrosshairLocation(ViewportSize.X / 2.f, ViewportSize.Y / 2.f);
-  FVector CrosshairWorldPosition;
-  FVector CrosshairWorldDirection;
-  bool bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(
-    UGameplayStatics::GetPlayerController(this, 0),
-    CrosshairLocation,
-    CrosshairWorldPosition,
-    CrosshairWorldDirection
-  );
+  APlayerController* PlayerController = Character ? Cast<APlayerController>(Character->Controller) : nullptr;
+  if (PlayerController && PlayerController->IsLocalPlayerController() && !ViewportSize.IsZero())
+  {
+    FVector2D CrosshairLocation(ViewportSize.X / 2.f, ViewportSize.Y / 2.f);
+    bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(
+      PlayerController,
+      CrosshairLocation,
+      CrosshairWorldPosition,
+      CrosshairWorldDirection
+    );
+  }
+  else if (Character && Character->Controller)
+  {
+    // Bots and headless clients have no viewport, aim along the controller's view instead
+    FRotator ViewRotation;
+    Character->Controller->GetPlayerViewPoint(CrosshairWorldPosition, ViewRotation);
+    CrosshairWorldDirection = ViewRotation.Vector();
+    bScreenToWorld = true;
+  }
 
   if (bScreenToWorld)
   {
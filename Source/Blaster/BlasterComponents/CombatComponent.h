@@ -38,17 +38,24 @@ protected:
 	void ServerSetAiming(bool bIsAiming);
 	void FireButtonPressed(bool bPressed);
 
+	// ShotSequence numbers the shot for ammo prediction, 0 when the shooter is not a remote client.
+	// The server picks the spread seed, the pellets a remote shooter played itself are only cosmetic
 	UFUNCTION(Server, Reliable)
-	void ServerFire(const FVector_NetQuantize& TraceHitTarget);
+	void ServerFire(const FVector_NetQuantize& TraceHitTarget, uint16 ShotSequence);
 
-	UFUNCTION(NetMulticast, Reliable)
-	void MulticastFire(const FVector_NetQuantize& TraceHitTarget);
+	// FireSeed drives the spread of multi pellet weapons, every machine playing the server's shot generates the same pellets from it.
+	// Runs the shot on the server and the shooting client, other machines play it from the cosmetic event the server queues
+	void LocalFire(const FVector& TraceHitTarget, uint16 FireSeed);
 
 	void TraceUnderCrosshairs(FHitResult& TraceHitResult);
 	void SetHUDCrosshairs(float DeltaTime);
+	void CacheCrosshairs(const class UWeaponDefinition* Definition);
 	void Fire();
 	bool CanFire();
 	void Reload();
+	bool CanReload() const;
+	// Enters the reload state and plays the montage, on the server and, predicted, on the owning client
+	void StartReload();
 	UFUNCTION(BlueprintCallable)
 	void HandleReload();
 	UFUNCTION()
@@ -57,8 +64,21 @@ protected:
 	void FireTimerFinished();
 	UFUNCTION(BlueprintCallable)
 	void FinishReloading();
+	void ResumeBufferedFire();
 	UFUNCTION(Server, Reliable)
-	void ServerReload();
+	void ServerReload(uint8 Sequence);
+	// Server: the reload belongs to the weapon being let go of, it must not finish on the next one or after death
+	void CancelReload();
+
+	/**
+	* Reload prediction. The owning client enters the reload and plays the montage without waiting for the server, and
+	* finishes it when its own montage does. CombatState skips the owner, the server answers the owner's reload Sequence
+	* with the state it settled on when it refused or finished the reload, and the owner rolls back to it.
+	*/
+	UFUNCTION(Client, Reliable)
+	void ClientCorrectCombatState(ECombatState ServerState, uint8 Sequence);
+	void SendCombatStateToOwner();
+	bool IsRemotelyControlled() const;
 
 protected:
 	UPROPERTY()
@@ -86,6 +106,12 @@ protected:
 
 	FHUDPackage HUDPackage;
 
+	// Definition the crosshair textures in HUDPackage were resolved from, only compared against
+	const UWeaponDefinition* CrosshairsDefinition = nullptr;
+
+	// Some crosshair textures were still streaming in, resolved again until they are all there
+	bool bCrosshairsPending = false;
+
 	/**
 	* Automatic fire
 	*/
@@ -93,6 +119,23 @@ protected:
 	FTimerHandle FireTimer;
 	bool bCanFire = true;
 
+	// Fire pressed during a reload, fires once the reload is done even if released by then
+	bool bFireBuffered = false;
+
+	// Owning client: last predicted reload, server: last reload the owner asked for
+	uint8 ReloadSequence = 0;
+
+	// Server: world time the reload montage ends
+	float ReloadEndTime = 0.f;
+
+	// Lean server: ends the reload in place of the montage's notify
+	FTimerHandle ReloadTimer;
+
+	// A remote owner finishes its reload ahead of the server by up to half its round trip, a shot arriving this close
+	// to the end of the server's reload finishes it instead of being refused
+	UPROPERTY(EditAnywhere)
+	float MaxReloadLead = 0.3f;
+
 	UPROPERTY(ReplicatedUsing = OnRep_CombatState)
 	ECombatState CombatState = ECombatState::ECS_Unoccupied;
 
@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterMemoryReport.h"
+#include "BlasterStats.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "Blaster/Weapon/Projectile.h"
+#include "Blaster/Weapon/Casing.h"
+#include "Blueprint/UserWidget.h"
+#include "GameFramework/GameMode.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectIterator.h"
+
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<bool> CVarBlasterMemReportPhaseChanges(
+	TEXT("Blaster.MemReport.PhaseChanges"),
+	true,
+	TEXT("Takes a memory report at every match phase change. Each one walks every UObject and appends to a file on the game thread."));
+
+static TAutoConsoleVariable<float> CVarBlasterMemReportGrowthPercent(
+	TEXT("Blaster.MemReport.GrowthPercent"),
+	5.f,
+	TEXT("Growth against the same phase of the previous match above which a memory report value is flagged."));
+
+static FAutoConsoleCommandWithWorld BlasterMemReportCommand(
+	TEXT("Blaster.MemReport"),
+	TEXT("Logs the Blaster memory report now."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		BlasterMemoryReport::Report(World, TEXT("Manual"));
+	}));
+
+namespace
+{
+	struct FMemoryValue
+	{
+		FString Name;
+		double Value = 0.0;
+		double MinGrowth = 0.0; // Changes smaller than this are noise, never flagged
+	};
+
+	// Reports survive RestartGame, the world and game mode do not
+	TMap<FName, TArray<FMemoryValue>> PreviousReports;
+	int32 ReportedMatches = 0;
+
+	// Named at the first report, paths and time are not set up yet during static initialization
+	const FString& GetReportFile()
+	{
+		static const FString ReportFile = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MemoryReport"), FString::Printf(TEXT("MemoryReport-%s.csv"), *FDateTime::Now().ToString()));
+		return ReportFile;
+	}
+
+	void GatherValues(TArray<FMemoryValue>& OutValues)
+	{
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		OutValues.Add({ TEXT("UsedPhysicalMB"), MemoryStats.UsedPhysical / (1024.0 * 1024.0), 16.0 });
+		OutValues.Add({ TEXT("UObjects"), double(GUObjectArray.GetObjectArrayNumMinusAvailable()), 100.0 });
+
+		struct FCountedClass
+		{
+			const TCHAR* Name;
+			UClass* Class;
+			int32 Count;
+		};
+		FCountedClass Counted[] = {
+			{ TEXT("Characters"), ABlasterCharacter::StaticClass(), 0 },
+			{ TEXT("Weapons"), AWeapon::StaticClass(), 0 },
+			{ TEXT("Projectiles"), AProjectile::StaticClass(), 0 },
+			{ TEXT("Casings"), ACasing::StaticClass(), 0 },
+			{ TEXT("ParticleComponents"), UParticleSystemComponent::StaticClass(), 0 },
+			{ TEXT("UserWidgets"), UUserWidget::StaticClass(), 0 },
+		};
+		for (TObjectIterator<UObject> It(RF_ClassDefaultObject | RF_ArchetypeObject); It; ++It)
+		{
+			for (FCountedClass& Entry : Counted)
+			{
+				if (It->IsA(Entry.Class))
+				{
+					++Entry.Count;
+				}
+			}
+		}
+		for (const FCountedClass& Entry : Counted)
+		{
+			OutValues.Add({ Entry.Name, double(Entry.Count), 4.0 });
+		}
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		if (FLowLevelMemTracker::IsEnabled())
+		{
+			const FName Tags[] = {
+				LLMTagDeclaration_Blaster_Combat.GetUniqueName(),
+				LLMTagDeclaration_Blaster_Weapons.GetUniqueName(),
+				LLMTagDeclaration_Blaster_Projectiles.GetUniqueName(),
+				LLMTagDeclaration_Blaster_Effects.GetUniqueName(),
+				LLMTagDeclaration_Blaster_HUD.GetUniqueName(),
+				LLMTagDeclaration_Blaster_Replication.GetUniqueName(),
+				FName(TEXT("MultiplayerSessions")),
+			};
+			for (const FName& Tag : Tags)
+			{
+				const int64 Bytes = FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, Tag, ELLMTagSet::None);
+				OutValues.Add({ FString::Printf(TEXT("LLM %sMB"), *Tag.ToString()), Bytes / (1024.0 * 1024.0), 1.0 });
+			}
+		}
+#endif
+	}
+}
+
+void BlasterMemoryReport::Report(UWorld* World, FName Phase)
+{
+	LLM_SCOPE_BYTAG(Blaster);
+
+	if (Phase == MatchState::WaitingToStart)
+	{
+		++ReportedMatches;
+	}
+
+	TArray<FMemoryValue> Values;
+	GatherValues(Values);
+
+	const TArray<FMemoryValue>* Previous = PreviousReports.Find(Phase);
+	const double GrowthFraction = CVarBlasterMemReportGrowthPercent.GetValueOnGameThread() / 100.0;
+	int32 NumFlagged = 0;
+	FString Csv;
+	UE_LOG(LogTemp, Log, TEXT("Memory report: match %d, %s, %s"), ReportedMatches, *Phase.ToString(), World ? *World->GetMapName() : TEXT("no world"));
+	for (const FMemoryValue& Value : Values)
+	{
+		const FMemoryValue* Before = Previous ? Previous->FindByPredicate([&Value](const FMemoryValue& Other) { return Other.Name == Value.Name; }) : nullptr;
+		const double Growth = Before ? Value.Value - Before->Value : 0.0;
+		const bool bFlagged = Before && Growth > Value.MinGrowth && Growth > Before->Value * GrowthFraction;
+		NumFlagged += bFlagged ? 1 : 0;
+
+		UE_LOG(LogTemp, Log, TEXT("  %-32s %12.2f %12s%s"), *Value.Name, Value.Value,
+			Before ? *FString::Printf(TEXT("%+.2f"), Growth) : TEXT("-"), bFlagged ? TEXT("  GROWTH") : TEXT(""));
+		Csv += FString::Printf(TEXT("%d,%s,%s,%.3f,%.3f,%d\n"), ReportedMatches, *Phase.ToString(), *Value.Name, Value.Value, Before ? Before->Value : 0.0, bFlagged ? 1 : 0);
+	}
+	if (NumFlagged > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Memory report: %d values grew since the previous match's %s"), NumFlagged, *Phase.ToString());
+	}
+
+	const FString& ReportFile = GetReportFile();
+	if (!IFileManager::Get().FileExists(*ReportFile))
+	{
+		Csv = TEXT("Match,Phase,Metric,Value,Previous,Flagged\n") + Csv;
+	}
+	FFileHelper::SaveStringToFile(Csv, *ReportFile, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append);
+
+	PreviousReports.Add(Phase, MoveTemp(Values));
+}
+
+void BlasterMemoryReport::ReportPhaseChange(UWorld* World, FName Phase)
+{
+	if (CVarBlasterMemReportPhaseChanges.GetValueOnGameThread())
+	{
+		Report(World, Phase);
+	}
+}
+#else
+void BlasterMemoryReport::Report(UWorld* World, FName Phase)
+{
+}
+
+void BlasterMemoryReport::ReportPhaseChange(UWorld* World, FName Phase)
+{
+}
+#endif
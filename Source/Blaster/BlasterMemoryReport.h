@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Per match memory report, taken at every match phase change while Blaster.MemReport.PhaseChanges is on and with
+* Blaster.MemReport. Compiled out of shipping builds.
+* Logs process memory, UObject and gameplay object counts and, when running with -llm, the Blaster LLM tags.
+* Each value is compared with the same phase of the previous match in this process, growth above
+* Blaster.MemReport.GrowthPercent is flagged. Rows are appended to Saved/MemoryReport/ as CSV.
+* Servers cycling through RestartGame should report flat values, a steadily flagged metric points at the leak.
+*/
+namespace BlasterMemoryReport
+{
+	BLASTER_API void Report(UWorld* World, FName Phase);
+	// Reports when phase change reports are on
+	BLASTER_API void ReportPhaseChange(UWorld* World, FName Phase);
+}
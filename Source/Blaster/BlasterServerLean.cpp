@@ -0,0 +1,11 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterServerLean.h"
+#include "Misc/CommandLine.h"
+
+bool BlasterServerLean::IsEnabled()
+{
+	static const bool bEnabled = IsRunningDedicatedServer() && !FParse::Param(FCommandLine::Get(), TEXT("NoServerLean"));
+	return bEnabled;
+}
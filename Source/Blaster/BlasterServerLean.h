@@ -0,0 +1,16 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Server lean mode, on for dedicated servers unless started with -NoServerLean.
+* Cameras, spring arms and widget components are never created, and montages, weapon animations, casings, tracers
+* and impact effects are skipped. Anything gameplay depends on, like reload timing, is computed without them.
+* Decided once per process, it has to hold from the first constructed default object on.
+*/
+namespace BlasterServerLean
+{
+	BLASTER_API bool IsEnabled();
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterStats.h"
+#include "Misc/CoreDelegates.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+DEFINE_STAT(STAT_BlasterCharacterTick);
+DEFINE_STAT(STAT_BlasterAimOffset);
+DEFINE_STAT(STAT_BlasterCombatTick);
+DEFINE_STAT(STAT_BlasterTraceUnderCrosshairs);
+DEFINE_STAT(STAT_BlasterAnimUpdate);
+DEFINE_STAT(STAT_BlasterWeaponFire);
+DEFINE_STAT(STAT_BlasterGameModeTick);
+DEFINE_STAT(STAT_BlasterDrawHUD);
+DEFINE_STAT(STAT_BlasterHUDUpdate);
+DEFINE_STAT(STAT_BlasterBotTick);
+DEFINE_STAT(STAT_BlasterBotPerception);
+DEFINE_STAT(STAT_BlasterNetStats);
+DEFINE_STAT(STAT_BlasterShotValidation);
+DEFINE_STAT(STAT_BlasterInteraction);
+DEFINE_STAT(STAT_BlasterDamageResolve);
+DEFINE_STAT(STAT_BlasterBallistics);
+DEFINE_STAT(STAT_BlasterCosmeticEvents);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Projectiles"), STAT_BlasterLiveProjectiles, STATGROUP_Blaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Casings"), STAT_BlasterLiveCasings, STATGROUP_Blaster);
+
+CSV_DEFINE_CATEGORY_MODULE(BLASTER_API, Blaster, true);
+
+UE_TRACE_CHANNEL_DEFINE(BlasterChannel);
+
+LLM_DEFINE_TAG(Blaster);
+LLM_DEFINE_TAG(Blaster_Combat, TEXT("Combat"), TEXT("Blaster"));
+LLM_DEFINE_TAG(Blaster_Weapons, TEXT("Weapons"), TEXT("Blaster"));
+LLM_DEFINE_TAG(Blaster_Projectiles, TEXT("Projectiles"), TEXT("Blaster"));
+LLM_DEFINE_TAG(Blaster_Effects, TEXT("Effects"), TEXT("Blaster"));
+LLM_DEFINE_TAG(Blaster_HUD, TEXT("HUD"), TEXT("Blaster"));
+LLM_DEFINE_TAG(Blaster_Replication, TEXT("Replication"), TEXT("Blaster"));
+
+TRACE_DECLARE_INT_COUNTER(BlasterLiveProjectiles, TEXT("Blaster/LiveProjectiles"));
+TRACE_DECLARE_INT_COUNTER(BlasterLiveCasings, TEXT("Blaster/LiveCasings"));
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	int32 LiveProjectiles = 0;
+	int32 LiveCasings = 0;
+	FDelegateHandle EndFrameHandle;
+
+	// Counts only change on spawn and destroy, CSV needs a sample every frame
+	void SampleCsvCounts()
+	{
+		CSV_CUSTOM_STAT(Blaster, LiveProjectiles, LiveProjectiles, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(Blaster, LiveCasings, LiveCasings, ECsvCustomStatOp::Set);
+	}
+
+	void StartCsvSampling()
+	{
+		if (!EndFrameHandle.IsValid())
+		{
+			EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&SampleCsvCounts);
+		}
+	}
+}
+#endif
+
+void BlasterStats::ChangeLiveProjectiles(int32 Delta)
+{
+#if !UE_BUILD_SHIPPING
+	LiveProjectiles += Delta;
+	SET_DWORD_STAT(STAT_BlasterLiveProjectiles, LiveProjectiles);
+	TRACE_COUNTER_SET(BlasterLiveProjectiles, LiveProjectiles);
+	StartCsvSampling();
+#endif
+}
+
+void BlasterStats::ChangeLiveCasings(int32 Delta)
+{
+#if !UE_BUILD_SHIPPING
+	LiveCasings += Delta;
+	SET_DWORD_STAT(STAT_BlasterLiveCasings, LiveCasings);
+	TRACE_COUNTER_SET(BlasterLiveCasings, LiveCasings);
+	StartCsvSampling();
+#endif
+}
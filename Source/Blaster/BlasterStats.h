@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+#include "HAL/LowLevelMemTracker.h"
+
+/**
+* Profiling for Blaster's gameplay hot paths.
+*   stat Blaster                      cycle stats and live object counts
+*   -csvCategories=Blaster            per frame timings and counts in CSV captures
+*   -trace=cpu,counters,Blaster       Insights timing events on the Blaster channel, also from dedicated servers
+*   -llm, stat LLMFULL                memory by Blaster/ tag, see BlasterMemoryReport.h for the per match report
+*/
+DECLARE_STATS_GROUP(TEXT("Blaster"), STATGROUP_Blaster, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Tick"), STAT_BlasterCharacterTick, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character AimOffset"), STAT_BlasterAimOffset, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Combat TickComponent"), STAT_BlasterCombatTick, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Combat TraceUnderCrosshairs"), STAT_BlasterTraceUnderCrosshairs, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AnimInstance Update"), STAT_BlasterAnimUpdate, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon Fire"), STAT_BlasterWeaponFire, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GameMode Tick"), STAT_BlasterGameModeTick, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HUD DrawHUD"), STAT_BlasterDrawHUD, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HUD Setters"), STAT_BlasterHUDUpdate, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bot Tick"), STAT_BlasterBotTick, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bot Perception Rebuild"), STAT_BlasterBotPerception, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("NetStats Accounting"), STAT_BlasterNetStats, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shot Validation"), STAT_BlasterShotValidation, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Interaction Update"), STAT_BlasterInteraction, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Damage Resolve"), STAT_BlasterDamageResolve, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ballistics"), STAT_BlasterBallistics, STATGROUP_Blaster, BLASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cosmetic Events"), STAT_BlasterCosmeticEvents, STATGROUP_Blaster, BLASTER_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BLASTER_API, Blaster);
+
+UE_TRACE_CHANNEL_EXTERN(BlasterChannel, BLASTER_API);
+
+LLM_DECLARE_TAG_API(Blaster, BLASTER_API);
+LLM_DECLARE_TAG_API(Blaster_Combat, BLASTER_API);
+LLM_DECLARE_TAG_API(Blaster_Weapons, BLASTER_API);
+LLM_DECLARE_TAG_API(Blaster_Projectiles, BLASTER_API);
+LLM_DECLARE_TAG_API(Blaster_Effects, BLASTER_API);
+LLM_DECLARE_TAG_API(Blaster_HUD, BLASTER_API);
+LLM_DECLARE_TAG_API(Blaster_Replication, BLASTER_API);
+
+// Times the enclosing scope as cycle stat STAT_Blaster<Name>, CSV stat Blaster/<Name> and Insights event <Name> on the Blaster channel
+#if !UE_BUILD_SHIPPING
+#define BLASTER_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Blaster##Name); \
+	CSV_SCOPED_TIMING_STAT(Blaster, Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Blaster##Name, BlasterChannel)
+#else
+#define BLASTER_SCOPE(Name)
+#endif
+
+namespace BlasterStats
+{
+	// Live object counts, shown in stat Blaster, as Insights counters and sampled into CSV every frame
+	BLASTER_API void ChangeLiveProjectiles(int32 Delta);
+	BLASTER_API void ChangeLiveCasings(int32 Delta);
+}
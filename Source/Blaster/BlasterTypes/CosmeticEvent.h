@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HitZone.h"
+#include "CosmeticEvent.generated.h"
+
+class ABlasterCharacter;
+
+UENUM()
+enum class ECosmeticEventType : uint8
+{
+	ECET_Fire UMETA(DisplayName = "Fire"),
+	ECET_HitReact UMETA(DisplayName = "Hit React"),
+
+	ECET_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+/**
+* Something a character did that other players only need to see and hear, sent unreliably to the connections close
+* enough to notice it. What it changed in the game is replicated on properties.
+*/
+USTRUCT()
+struct FCosmeticEvent
+{
+	GENERATED_BODY()
+
+	// Not relevant to the receiving connection when it arrives as null
+	UPROPERTY()
+	ABlasterCharacter* Character = nullptr;
+
+	UPROPERTY()
+	ECosmeticEventType Type = ECosmeticEventType::ECET_Fire;
+
+	// Fire: where the shot went
+	UPROPERTY()
+	FVector_NetQuantize Target = FVector::ZeroVector;
+
+	// Fire: spread seed of multi pellet weapons
+	UPROPERTY()
+	uint16 Seed = 0;
+
+	// Hit react: where the hit landed
+	UPROPERTY()
+	EHitZone HitZone = EHitZone::EHZ_Body;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+UENUM(BlueprintType)
+enum class EHitZone : uint8
+{
+	EHZ_Body UMETA(DisplayName = "Body"),
+	EHZ_Head UMETA(DisplayName = "Head"),
+	EHZ_Limb UMETA(DisplayName = "Limb"),
+
+	EHZ_MAX UMETA(DisplayName = "DefaultMAX")
+};
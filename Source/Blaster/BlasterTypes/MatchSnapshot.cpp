@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchSnapshot.h"
+#include "UObject/CoreNet.h"
+#include "Blaster/GameMode/BlasterGameMode.h"
+
+namespace
+{
+	template<typename T>
+	bool SerializeObjectRef(FArchive& Ar, UPackageMap* Map, T*& Ref)
+	{
+		UObject* Object = Ref;
+		const bool bSuccess = Map->SerializeObject(Ar, T::StaticClass(), Object);
+		if (Ar.IsLoading())
+		{
+			Ref = Cast<T>(Object);
+		}
+		return bSuccess;
+	}
+}
+
+float FBlasterMatchSnapshot::GetLevelStartingTime() const
+{
+	if (MatchState == MatchState::WaitingToStart) return PhaseDeadline - WarmupTime;
+	if (MatchState == MatchState::InProgress) return PhaseDeadline - WarmupTime - MatchTime;
+	if (MatchState == MatchState::Cooldown) return PhaseDeadline - WarmupTime - MatchTime - CooldownTime;
+	return 0.f;
+}
+
+bool FBlasterMatchSnapshot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	Ar << Version;
+	if (Ar.IsLoading() && Version != CurrentVersion)
+	{
+		bOutSuccess = false;
+		Ar.SetError();
+		return false;
+	}
+
+	Ar << MatchState;
+	Ar << PhaseDeadline;
+	Ar << WarmupTime;
+	Ar << MatchTime;
+	Ar << CooldownTime;
+	Ar << ClientRequestTime;
+	Ar << ServerTime;
+
+	uint8 bRequester = bHasRequester;
+	Ar.SerializeBits(&bRequester, 1);
+	bHasRequester = bRequester != 0;
+	if (bHasRequester)
+	{
+		Ar << Requester.Score;
+		uint32 Defeats = FMath::Max(Requester.Defeats, 0);
+		Ar.SerializeIntPacked(Defeats);
+		Requester.Defeats = Defeats;
+
+		uint8 bHasWeapon = Requester.EquippedWeapon != nullptr;
+		Ar.SerializeBits(&bHasWeapon, 1);
+		if (bHasWeapon)
+		{
+			bOutSuccess &= SerializeObjectRef(Ar, Map, Requester.EquippedWeapon);
+			uint32 Ammo = FMath::Max(Requester.Ammo, 0);
+			Ar.SerializeIntPacked(Ammo);
+			Requester.Ammo = Ammo;
+		}
+	}
+
+	uint32 NumWeapons = DroppedWeapons.Num();
+	Ar.SerializeIntPacked(NumWeapons);
+	if (Ar.IsLoading())
+	{
+		if (NumWeapons > uint32(MaxDroppedWeapons))
+		{
+			bOutSuccess = false;
+			Ar.SetError();
+			return false;
+		}
+		DroppedWeapons.SetNum(NumWeapons);
+	}
+	for (FSnapshotWeaponEntry& Entry : DroppedWeapons)
+	{
+		bOutSuccess &= SerializeObjectRef(Ar, Map, Entry.Weapon);
+		bool bLocationSuccess = true;
+		Entry.Location.NetSerialize(Ar, Map, bLocationSuccess);
+		bOutSuccess &= bLocationSuccess;
+
+		uint32 State = static_cast<uint32>(Entry.WeaponState);
+		Ar.SerializeInt(State, static_cast<uint32>(EWeaponState::EWS_MAX));
+		Entry.WeaponState = static_cast<EWeaponState>(State);
+
+		uint8 bDormant = Entry.bDormant;
+		Ar.SerializeBits(&bDormant, 1);
+		Entry.bDormant = bDormant != 0;
+	}
+
+	return bOutSuccess;
+}
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "MatchSnapshot.generated.h"
+
+USTRUCT()
+struct FSnapshotPlayerEntry
+{
+	GENERATED_BODY()
+
+	float Score = 0.f;
+	int32 Defeats = 0;
+
+	UPROPERTY()
+	AWeapon* EquippedWeapon = nullptr;
+	int32 Ammo = 0;
+};
+
+USTRUCT()
+struct FSnapshotWeaponEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AWeapon* Weapon = nullptr;
+
+	FVector_NetQuantize Location;
+	EWeaponState WeaponState = EWeaponState::EWS_Initial;
+	bool bDormant = false;
+};
+
+/**
+* Everything a client joining mid match needs to bring its HUD up to date, sent as a single RPC parameter
+*/
+USTRUCT()
+struct FBlasterMatchSnapshot
+{
+	GENERATED_BODY()
+
+	static constexpr uint8 CurrentVersion = 2;
+
+	// Larger snapshots are refused on arrival, so the server leaves out the weapons furthest from the joining player
+	static constexpr int32 MaxDroppedWeapons = 512;
+
+	uint8 Version = CurrentVersion;
+
+	FName MatchState;
+	float PhaseDeadline = 0.f; // Server time at which the current phase ends
+	float WarmupTime = 0.f;
+	float MatchTime = 0.f;
+	float CooldownTime = 0.f;
+
+	// Echo of the client's request time and the server time the snapshot was built, used to sync clocks
+	float ClientRequestTime = 0.f;
+	float ServerTime = 0.f;
+
+	// The player the snapshot was built for, its PlayerState may not have replicated yet.
+	// Other players' scores reach the client on their own PlayerStates
+	UPROPERTY()
+	FSnapshotPlayerEntry Requester;
+	bool bHasRequester = false;
+
+	UPROPERTY()
+	TArray<FSnapshotWeaponEntry> DroppedWeapons;
+
+	// LevelStartingTime is not sent, it is derived back from the deadline of the current phase
+	float GetLevelStartingTime() const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FBlasterMatchSnapshot> : public TStructOpsTypeTraitsBase2<FBlasterMatchSnapshot>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
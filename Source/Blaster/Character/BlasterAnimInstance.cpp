@@ -8,6 +8,7 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "Blaster/Weapon/Weapon.h"
 #include "Blaster/BlasterTypes/CombatState.h"
+#include "Blaster/BlasterStats.h"
 
 void UBlasterAnimInstance::NativeInitializeAnimation()
 {
@@ -18,6 +19,8 @@ void UBlasterAnimInstance::NativeInitializeAnimation()
 
 void UBlasterAnimInstance::NativeUpdateAnimation(float DeltaTime)
 {
+  BLASTER_SCOPE(AnimUpdate);
+
   Super::NativeUpdateAnimation(DeltaTime);
 
   if (BlasterCharacter == nullptr)
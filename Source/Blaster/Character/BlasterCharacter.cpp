@@ -22,29 +22,60 @@
 #include "Blaster/GameMode/BlasterGameMode.h"
 #include "TimerManager.h"
 #include "Blaster/PlayerState/BlasterPlayerState.h"
+#include "Blaster/LoadTest/BlasterLoadTestSubsystem.h"
+#include "Blaster/BlasterStats.h"
+#include "Blaster/BlasterServerLean.h"
+#include "Blaster/Assets/BlasterAssetPreloadSubsystem.h"
+#include "Blaster/Cosmetics/BlasterCosmeticsSubsystem.h"
+#include "Blaster/Damage/BlasterDamageSubsystem.h"
+#include "Blaster/Damage/HitZoneSubsystem.h"
 
-ABlasterCharacter::ABlasterCharacter()
+namespace
+{
+  // Nobody looks through the camera or at the overhead widget on a dedicated server
+  const FObjectInitializer& WithoutViewComponents(const FObjectInitializer& ObjectInitializer)
+  {
+    if (!BlasterServerLean::IsEnabled()) return ObjectInitializer;
+    return ObjectInitializer
+      .DoNotCreateDefaultSubobject(TEXT("CameraBoom"))
+      .DoNotCreateDefaultSubobject(TEXT("FollowCamera"))
+      .DoNotCreateDefaultSubobject(TEXT("OverheadWidget"));
+  }
+}
+
+ABlasterCharacter::ABlasterCharacter(const FObjectInitializer& ObjectInitializer)
+  : Super(WithoutViewComponents(ObjectInitializer))
 {
   PrimaryActorTick.bCanEverTick = true;
 
   GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
   GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 
-  CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-  CameraBoom->SetupAttachment(GetMesh());
-  CameraBoom->TargetArmLength = 600.f;
-  CameraBoom->bUsePawnControlRotation = true;
+  // Optional so lean servers, subclasses and Blueprints can all go without them
+  CameraBoom = CreateOptionalDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
+  if (CameraBoom)
+  {
+    CameraBoom->SetupAttachment(GetMesh());
+    CameraBoom->TargetArmLength = 600.f;
+    CameraBoom->bUsePawnControlRotation = true;
+  }
 
-  FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
-  FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
-  FollowCamera->bUsePawnControlRotation = false;
+  FollowCamera = CreateOptionalDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
+  if (FollowCamera)
+  {
+    FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
+    FollowCamera->bUsePawnControlRotation = false;
+  }
+
+  OverheadWidget = CreateOptionalDefaultSubobject<UWidgetComponent>(TEXT("OverheadWidget"));
+  if (OverheadWidget)
+  {
+    OverheadWidget->SetupAttachment(RootComponent);
+  }
 
   bUseControllerRotationYaw = false;
   GetCharacterMovement()->bOrientRotationToMovement = true;
 
-  OverheadWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("OverheadWidget"));
-  OverheadWidget->SetupAttachment(RootComponent);
-
   Combat = CreateDefaultSubobject<UCombatComponent>(TEXT("CombatComponent"));
   Combat->SetIsReplicated(true);
 
@@ -76,11 +107,17 @@ void ABlasterCharacter::BeginPlay()
   if (HasAuthority())
   {
     OnTakeAnyDamage.AddDynamic(this, &ABlasterCharacter::ReceiveDamage);
+    if (UHitZoneSubsystem* HitZones = GetWorld()->GetSubsystem<UHitZoneSubsystem>())
+    {
+      HitZones->Prepare(GetMesh());
+    }
   }
 }
 
 void ABlasterCharacter::Tick(float DeltaTime)
 {
+  BLASTER_SCOPE(CharacterTick);
+
   Super::Tick(DeltaTime);
 
   if (GetLocalRole() > ENetRole::ROLE_SimulatedProxy && IsLocallyControlled())
@@ -100,20 +137,30 @@ void ABlasterCharacter::Tick(float DeltaTime)
   PollInit();
 }
 
+float ABlasterCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+  // Read by ReceiveDamage, which only gets to see the amount
+  PendingHitZone = DamageEvent.IsOfType(FHitZoneDamageEvent::ClassID) ? static_cast<const FHitZoneDamageEvent&>(DamageEvent).HitZone : EHitZone::EHZ_Body;
+  return Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+}
+
 void ABlasterCharacter::ReceiveDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatorController, AActor* DamageCauser)
 {
   Health = FMath::Clamp(Health - Damage, 0.f, MaxHealth);
   UpdateHUDHealth();
-  PlayHitReactMontage();
+  PlayHitReactMontage(PendingHitZone);
+  if (UBlasterCosmeticsSubsystem* Cosmetics = GetWorld()->GetSubsystem<UBlasterCosmeticsSubsystem>())
+  {
+    Cosmetics->QueueHitReact(this, PendingHitZone);
+  }
+  PendingHitZone = EHitZone::EHZ_Body;
 
   if (Health == 0.f)
   {
     ABlasterGameMode* BlasterGameMode = GetWorld()->GetAuthGameMode<ABlasterGameMode>();
     if (BlasterGameMode)
     {
-      BlasterPlayerController = BlasterPlayerController == nullptr ? Cast<ABlasterPlayerController>(Controller) : BlasterPlayerController;
-      ABlasterPlayerController* AttackerController = Cast<ABlasterPlayerController>(InstigatorController);
-      BlasterGameMode->PlayerEliminated(this, BlasterPlayerController, AttackerController);
+      BlasterGameMode->PlayerEliminated(this, Controller, InstigatorController);
     }
   }
 }
@@ -122,9 +169,11 @@ void ABlasterCharacter::Elim()
 {
   if (Combat && Combat->EquippedWeapon)
   {
+    Combat->CancelReload();
     Combat->EquippedWeapon->Dropped();
   }
-  MulticastElim();
+  bElimmed = true;
+  HandleElim();
   GetWorldTimerManager().SetTimer(
     ElimTimer,
     this,
@@ -133,13 +182,20 @@ void ABlasterCharacter::Elim()
   );
 }
 
-void ABlasterCharacter::MulticastElim_Implementation()
+void ABlasterCharacter::OnRep_Elimmed()
+{
+  if (bElimmed)
+  {
+    HandleElim();
+  }
+}
+
+void ABlasterCharacter::HandleElim()
 {
   if (BlasterPlayerController)
   {
     BlasterPlayerController->SetHUDWeaponAmmo(0);
   }
-  bElimmed = true;
   PlayElimMontage();
 
   // Disable character movement
@@ -165,10 +221,13 @@ void ABlasterCharacter::ElimTimerFinished()
 
 void ABlasterCharacter::PlayElimMontage()
 {
+  if (BlasterServerLean::IsEnabled()) return;
+
   UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-  if (AnimInstance && ElimMontage)
+  UAnimMontage* Montage = BlasterAssets::Get(ElimMontage);
+  if (AnimInstance && Montage)
   {
-    AnimInstance->Montage_Play(ElimMontage);
+    AnimInstance->Montage_Play(Montage);
     FName SectionName("StartDie");
     AnimInstance->Montage_JumpToSection(SectionName);
   }
@@ -184,7 +243,8 @@ float ABlasterCharacter::CalculateSpeed()
 
 void ABlasterCharacter::HideCameraIfCharacterClose()
 {
-  if (!IsLocallyControlled()) return;
+  // Bots count as locally controlled on the server, which has no camera when it is lean
+  if (!IsLocallyControlled() || FollowCamera == nullptr) return;
   if ((FollowCamera->GetComponentLocation() - GetActorLocation()).Size() < CameraThreshold)
   {
     GetMesh()->SetVisibility(false);
@@ -236,7 +296,9 @@ void ABlasterCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
   Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
   DOREPLIFETIME_CONDITION(ABlasterCharacter, OverlappingWeapon, COND_OwnerOnly);
-  DOREPLIFETIME(ABlasterCharacter, Health);
+  // Only the owner's HUD shows health, elims reach replays through bElimmed
+  DOREPLIFETIME_CONDITION(ABlasterCharacter, Health, COND_SkipReplay);
+  DOREPLIFETIME(ABlasterCharacter, bElimmed);
 }
 
 void ABlasterCharacter::PostInitializeComponents()
@@ -247,17 +309,23 @@ void ABlasterCharacter::PostInitializeComponents()
   {
     Combat->Character = this;
   }
+  if (BlasterServerLean::IsEnabled())
+  {
+    GetMesh()->VisibilityBasedAnimTickOption = ServerAnimTickOption;
+  }
 }
 
-void ABlasterCharacter::PlayHitReactMontage()
+void ABlasterCharacter::PlayHitReactMontage(EHitZone HitZone)
 {
-  if (Combat == nullptr || Combat->EquippedWeapon == nullptr) return;
+  if (Combat == nullptr || Combat->EquippedWeapon == nullptr || BlasterServerLean::IsEnabled()) return;
 
   UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-  if (AnimInstance && HitReactMontage)
+  UAnimMontage* Montage = BlasterAssets::Get(HitReactMontage);
+  if (AnimInstance && Montage)
   {
-    AnimInstance->Montage_Play(HitReactMontage);
-    FName SectionName("FromFront");
+    AnimInstance->Montage_Play(Montage);
+    const FName* ZoneSection = HitReactSections.Find(HitZone);
+    FName SectionName = ZoneSection && Montage->IsValidSectionName(*ZoneSection) ? *ZoneSection : FName("FromFront");
     AnimInstance->Montage_JumpToSection(SectionName);
   }
 }
@@ -373,6 +441,8 @@ void ABlasterCharacter::Reload_Input()
 
 void ABlasterCharacter::AimOffset(float deltaTime)
 {
+  BLASTER_SCOPE(AimOffset);
+
   if (Combat == nullptr || Combat->EquippedWeapon == nullptr) return;
 
   float Speed = CalculateSpeed();
@@ -483,7 +553,6 @@ void ABlasterCharacter::OnRep_ReplicatedMovement()
 void ABlasterCharacter::OnRep_Health()
 {
   UpdateHUDHealth();
-  PlayHitReactMontage();
 }
 
 void ABlasterCharacter::UpdateHUDHealth()
@@ -495,14 +564,31 @@ void ABlasterCharacter::UpdateHUDHealth()
   }
 }
 
+void ABlasterCharacter::PlayCosmeticEvent(const FCosmeticEvent& Event)
+{
+  switch (Event.Type)
+  {
+  case ECosmeticEventType::ECET_Fire:
+    if (Combat)
+    {
+      Combat->LocalFire(Event.Target, Event.Seed);
+    }
+    break;
+  case ECosmeticEventType::ECET_HitReact:
+    PlayHitReactMontage(Event.HitZone);
+    break;
+  }
+}
+
 void ABlasterCharacter::PlayFireMontage(bool bAiming)
 {
-  if (Combat == nullptr || Combat->EquippedWeapon == nullptr) return;
+  if (Combat == nullptr || Combat->EquippedWeapon == nullptr || BlasterServerLean::IsEnabled()) return;
 
   UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-  if (AnimInstance && FireWeaponMontage)
+  UAnimMontage* Montage = BlasterAssets::Get(FireWeaponMontage);
+  if (AnimInstance && Montage)
   {
-    AnimInstance->Montage_Play(FireWeaponMontage);
+    AnimInstance->Montage_Play(Montage);
     FName SectionName;
     SectionName = bAiming ? FName("RifleAim") : FName("RifleHip");
     AnimInstance->Montage_JumpToSection(SectionName);
@@ -511,7 +597,9 @@ void ABlasterCharacter::PlayFireMontage(bool bAiming)
 
 void ABlasterCharacter::SetOverlappingWeapon(AWeapon* weapon)
 {
-  if (weapon == nullptr && OverlappingWeapon)
+  if (OverlappingWeapon == weapon) return;
+
+  if (OverlappingWeapon && IsLocallyControlled())
   {
     OverlappingWeapon->ShowPickupWidget(false);
   }
@@ -551,7 +639,7 @@ void ABlasterCharacter::OnRep_OverlappingWeapon(AWeapon* lastWeapon)
     OverlappingWeapon->ShowPickupWidget(true);
   }
 
-  if (lastWeapon && OverlappingWeapon == nullptr)
+  if (lastWeapon && lastWeapon != OverlappingWeapon)
   {
     lastWeapon->ShowPickupWidget(false);
   }
@@ -559,6 +647,7 @@ void ABlasterCharacter::OnRep_OverlappingWeapon(AWeapon* lastWeapon)
 
 void ABlasterCharacter::ServerEquipButtonOPressed_Implementation()
 {
+  BLASTER_COUNT_RPC(ServerEquipButtonOPressed);
   if (Combat)
   {
     Combat->EquipWeapon(OverlappingWeapon);
@@ -578,14 +667,31 @@ void ABlasterCharacter::PollInit()
   }
 }
 
-void ABlasterCharacter::PlayReloadMontage()
+float ABlasterCharacter::PlayReloadMontage()
 {
-  if (Combat == nullptr || Combat->EquippedWeapon == nullptr) return;
+  if (Combat == nullptr || Combat->EquippedWeapon == nullptr) return 0.f;
+
+  UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+  UAnimMontage* Montage = BlasterAssets::Get(ReloadMontage);
+  if (Montage && BlasterServerLean::IsEnabled())
+  {
+    // Only the timing matters, UCombatComponent finishes the reload without the montage's notify
+    return Montage->GetPlayLength();
+  }
+  if (AnimInstance && Montage)
+  {
+    return AnimInstance->Montage_Play(Montage);
+  }
+  return 0.f;
+}
 
+void ABlasterCharacter::StopReloadMontage()
+{
   UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-  if (AnimInstance && ReloadMontage)
+  UAnimMontage* Montage = ReloadMontage.Get();
+  if (AnimInstance && Montage)
   {
-    AnimInstance->Montage_Play(ReloadMontage);
+    AnimInstance->Montage_Stop(0.2f, Montage);
   }
 }
 
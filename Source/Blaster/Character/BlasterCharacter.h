@@ -4,9 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Components/SkinnedMeshComponent.h"
 #include "Blaster/BlasterTypes/TurningInPlace.h"
 #include "Blaster/Interfaces/InteractWithCrosshairsInterface.h"
 #include "Blaster/BlasterTypes/CombatState.h"
+#include "Blaster/BlasterTypes/HitZone.h"
 #include "BlasterCharacter.generated.h"
 
 class USpringArmComponent;
@@ -24,13 +26,15 @@ class BLASTER_API ABlasterCharacter : public ACharacter, public IInteractWithCro
   GENERATED_BODY()
 
 public:
-  ABlasterCharacter();
+  ABlasterCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
   virtual void Tick(float DeltaTime) override;
   virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
   virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
   virtual void PostInitializeComponents() override;
+  virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
 
   void SetOverlappingWeapon(AWeapon* weapon);
+  FORCEINLINE AWeapon* GetOverlappingWeapon() const { return OverlappingWeapon; }
   bool IsWeaponEquipped();
   bool IsAiming() const;
   FORCEINLINE float GetAO_Yaw() const { return AO_Yaw; }
@@ -41,17 +45,19 @@ public:
   FORCEINLINE bool IsElimmed() const { return bElimmed; }
   FORCEINLINE float GetHealth() const { return Health; }
   FORCEINLINE float GetMaxHealth() const { return MaxHealth; }
+  FORCEINLINE UCombatComponent* GetCombat() const { return Combat; }
   ECombatState GetCombatState() const;
 
   void PlayFireMontage(bool bAiming);
   void Elim();
   void PlayElimMontage();
-  UFUNCTION(NetMulticast, Reliable)
-  void MulticastElim();
-  void PlayReloadMontage();
-protected:
-  virtual void BeginPlay() override;
+  // Plays a fire or hit react the server sent through UBlasterCosmeticsSubsystem
+  void PlayCosmeticEvent(const struct FCosmeticEvent& Event);
+  // Returns how long the reload plays, 0 without a montage
+  float PlayReloadMontage();
+  void StopReloadMontage();
 
+  // Bound to player input, bots drive the character through the same functions
   void Jump() override;
   void Move_Input(const FInputActionValue& Value);
   void Look_Input(const FInputActionValue& Value);
@@ -63,6 +69,8 @@ protected:
   void StartFire_Input();
   void EndFire_Input();
   void Reload_Input();
+protected:
+  virtual void BeginPlay() override;
 
   void AimOffset(float deltaTime);
   void TurnInPlace(float DeltaTime);
@@ -79,7 +87,9 @@ protected:
   void ServerEquipButtonOPressed();
 
   void HideCameraIfCharacterClose();
-  void PlayHitReactMontage();
+  void PlayHitReactMontage(EHitZone HitZone);
+  // Zone of the damage being applied, set by TakeDamage for ReceiveDamage on the server
+  EHitZone PendingHitZone = EHitZone::EHZ_Body;
   UFUNCTION()
   void ReceiveDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, class AController* InstigatorController, AActor* DamageCauser);
   void UpdateHUDHealth();
@@ -114,10 +124,17 @@ protected:
   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
   UInputAction* ReloadAction = nullptr;
   UPROPERTY(EditAnywhere, Category = Combat)
-  UAnimMontage* ElimMontage;
+  TSoftObjectPtr<UAnimMontage> ElimMontage;
 
+  // Replicated instead of multicast, an elimination must reach every client however far away it happened
+  UPROPERTY(ReplicatedUsing = OnRep_Elimmed)
   bool bElimmed = false;
-  
+
+  UFUNCTION()
+  void OnRep_Elimmed();
+
+  void HandleElim();
+
   FTimerHandle ElimTimer;
 
   UPROPERTY(EditDefaultsOnly)
@@ -128,7 +145,7 @@ protected:
   class ABlasterPlayerState* BlasterPlayerState;
 
   UPROPERTY(EditAnywhere, Category = Combat)
-  UAnimMontage* ReloadMontage;
+  TSoftObjectPtr<UAnimMontage> ReloadMontage;
 
   /**
   * Player health
@@ -181,8 +198,17 @@ protected:
   ETurningInPlace TurningInPlace;
 
   UPROPERTY(EditAnywhere, Category = Combat)
-  class UAnimMontage* FireWeaponMontage;
+  TSoftObjectPtr<class UAnimMontage> FireWeaponMontage;
 
   UPROPERTY(EditAnywhere, Category = Combat)
-  UAnimMontage* HitReactMontage;
+  TSoftObjectPtr<UAnimMontage> HitReactMontage;
+
+  // Hit react section of each zone, zones without one play FromFront
+  UPROPERTY(EditAnywhere, Category = Combat)
+  TMap<EHitZone, FName> HitReactSections;
+
+  // Mesh animation on a lean dedicated server. Bullets hit the mesh's physics bodies, so the default keeps bones
+  // current, OnlyTickPoseWhenRendered saves the most once hits no longer need bones
+  UPROPERTY(EditDefaultsOnly, Category = Server)
+  EVisibilityBasedAnimTickOption ServerAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
 };
@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterCosmeticsSubsystem.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/PlayerController/BlasterPlayerController.h"
+#include "Blaster/GameState/BlasterGameState.h"
+#include "Engine/DemoNetDriver.h"
+#include "Blaster/LoadTest/BlasterLoadTestSubsystem.h"
+#include "Blaster/BlasterStats.h"
+
+bool UBlasterCosmeticsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBlasterCosmeticsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ViewConeCos = FMath::Cos(FMath::DegreesToRadians(ViewConeHalfAngle));
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UBlasterCosmeticsSubsystem::OnPostActorTick);
+}
+
+void UBlasterCosmeticsSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	Pending.Reset();
+	PendingIndices.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBlasterCosmeticsSubsystem::QueueFire(ABlasterCharacter* Character, const FVector& Target, uint16 Seed)
+{
+	if (!ShouldQueue(Character)) return;
+
+	FCosmeticEvent& Event = Queue(Character, ECosmeticEventType::ECET_Fire);
+	Event.Target = Target;
+	Event.Seed = Seed;
+}
+
+void UBlasterCosmeticsSubsystem::QueueHitReact(ABlasterCharacter* Character, EHitZone HitZone)
+{
+	if (!ShouldQueue(Character)) return;
+
+	FCosmeticEvent& Event = Queue(Character, ECosmeticEventType::ECET_HitReact);
+	Event.HitZone = HitZone;
+}
+
+bool UBlasterCosmeticsSubsystem::ShouldQueue(const ABlasterCharacter* Character) const
+{
+	const ENetMode NetMode = GetWorld()->GetNetMode();
+	return Character && (NetMode == NM_DedicatedServer || NetMode == NM_ListenServer);
+}
+
+FCosmeticEvent& UBlasterCosmeticsSubsystem::Queue(ABlasterCharacter* Character, ECosmeticEventType Type)
+{
+	const TPair<ABlasterCharacter*, ECosmeticEventType> Key(Character, Type);
+	if (const int32* Found = PendingIndices.Find(Key))
+	{
+		return Pending[*Found];
+	}
+
+	PendingIndices.Add(Key, Pending.Num());
+	FCosmeticEvent& Event = Pending.AddDefaulted_GetRef();
+	Event.Character = Character;
+	Event.Type = Type;
+	return Event;
+}
+
+void UBlasterCosmeticsSubsystem::OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld()) return;
+
+	TimeSinceFlush += DeltaSeconds;
+	if (TimeSinceFlush < FlushInterval) return;
+	TimeSinceFlush = 0.f;
+
+	if (Pending.Num() > 0)
+	{
+		Flush();
+	}
+}
+
+void UBlasterCosmeticsSubsystem::Flush()
+{
+	BLASTER_SCOPE(CosmeticEvents);
+	LLM_SCOPE_BYTAG(Blaster_Replication);
+
+	TArray<FCosmeticEvent> Events = MoveTemp(Pending);
+	Pending.Reset();
+	PendingIndices.Reset();
+	Events.RemoveAll([](const FCosmeticEvent& Event) { return !IsValid(Event.Character); });
+	RecordForReplay(Events);
+
+	int32 NumSent = 0;
+	int32 NumCulled = 0;
+	TArray<TPair<float, int32>, TInlineAllocator<32>> Noticed;
+	TArray<FCosmeticEvent> Batch;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		ABlasterPlayerController* PlayerController = Cast<ABlasterPlayerController>(It->Get());
+		// The listen server's player already saw the server's own cosmetics
+		if (PlayerController == nullptr || PlayerController->IsLocalController()) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		const APawn* ViewPawn = PlayerController->GetPawn();
+
+		Noticed.Reset();
+		for (int32 Index = 0; Index < Events.Num(); ++Index)
+		{
+			const ABlasterCharacter* Character = Events[Index].Character;
+			if (Character == ViewPawn)
+			{
+				// Never culled, but the owner already played its own fire when it shot
+				if (Events[Index].Type != ECosmeticEventType::ECET_Fire)
+				{
+					Noticed.Emplace(0.f, Index);
+				}
+				continue;
+			}
+			const float DistanceSquared = GetViewDistanceSquared(ViewLocation, ViewRotation, Character->GetActorLocation());
+			if (DistanceSquared >= 0.f)
+			{
+				Noticed.Emplace(DistanceSquared, Index);
+			}
+		}
+		if (Noticed.Num() > MaxEventsPerConnection)
+		{
+			Noticed.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+			Noticed.SetNum(MaxEventsPerConnection);
+		}
+		NumCulled += Events.Num() - Noticed.Num();
+		if (Noticed.Num() == 0) continue;
+
+		Batch.Reset();
+		for (const TPair<float, int32>& Entry : Noticed)
+		{
+			Batch.Add(Events[Entry.Value]);
+		}
+		NumSent += Batch.Num();
+		BLASTER_COUNT_RPC(ClientCosmeticEvents);
+		PlayerController->ClientCosmeticEvents(Batch);
+	}
+
+	CSV_CUSTOM_STAT(Blaster, CosmeticEventsSent, NumSent, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(Blaster, CosmeticEventsCulled, NumCulled, ECsvCustomStatOp::Accumulate);
+}
+
+void UBlasterCosmeticsSubsystem::RecordForReplay(const TArray<FCosmeticEvent>& Events) const
+{
+	UDemoNetDriver* DemoNetDriver = GetWorld()->GetDemoNetDriver();
+	ABlasterGameState* GameState = GetWorld()->GetGameState<ABlasterGameState>();
+	if (DemoNetDriver == nullptr || !DemoNetDriver->IsRecording() || GameState == nullptr || Events.Num() == 0) return;
+
+	// Through the demo driver alone, calling the multicast would also send every event to every live client
+	struct FParms
+	{
+		TArray<FCosmeticEvent> Events;
+	};
+	FParms Parms{ Events };
+	UFunction* Function = GameState->FindFunctionChecked(GET_FUNCTION_NAME_CHECKED(ABlasterGameState, MulticastReplayCosmeticEvents));
+	DemoNetDriver->ProcessRemoteFunction(GameState, Function, &Parms, nullptr, nullptr);
+}
+
+float UBlasterCosmeticsSubsystem::GetViewDistanceSquared(const FVector& ViewLocation, const FRotator& ViewRotation, const FVector& Location) const
+{
+	const FVector ToLocation = Location - ViewLocation;
+	const float DistanceSquared = ToLocation.SizeSquared();
+	if (DistanceSquared <= FMath::Square(AudibleDistance)) return DistanceSquared;
+	if (DistanceSquared > FMath::Square(MaxDistance)) return -1.f;
+
+	const bool bInViewCone = FVector::DotProduct(ViewRotation.Vector(), ToLocation) >= ViewConeCos * FMath::Sqrt(DistanceSquared);
+	return bInViewCone ? DistanceSquared : -1.f;
+}
+
+void UBlasterCosmeticsSubsystem::PlayEvents(const TArray<FCosmeticEvent>& Events) const
+{
+	LLM_SCOPE_BYTAG(Blaster_Effects);
+
+	for (const FCosmeticEvent& Event : Events)
+	{
+		if (IsValid(Event.Character))
+		{
+			Event.Character->PlayCosmeticEvent(Event);
+		}
+	}
+}
+
+bool UBlasterCosmeticsSubsystem::ShouldPlayLocally(const AActor* Actor) const
+{
+	if (Actor == nullptr) return false;
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController == nullptr || !PlayerController->IsLocalController() || PlayerController->GetPawn() == Actor) return true;
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	return GetViewDistanceSquared(ViewLocation, ViewRotation, Actor->GetActorLocation()) >= 0.f;
+}
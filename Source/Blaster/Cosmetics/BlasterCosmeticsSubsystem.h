@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Blaster/BlasterTypes/CosmeticEvent.h"
+#include "BlasterCosmeticsSubsystem.generated.h"
+
+class APlayerController;
+
+/**
+* Cosmetic event channel, kept apart from gameplay events. The server collects the fire and hit react events of a
+* frame, one per character and type, and sends every connection the ones it could notice in a single unreliable RPC.
+* An event reaches a connection when it is within AudibleDistance of its view, or within MaxDistance and inside its
+* view cone. The owner of a character always gets its own events, except its fire, which it played when it shot.
+* Clients apply the same test to cosmetics driven by replicated state, such as the reload montage.
+* A server replay being recorded gets every event, unculled, so it plays back the same from any view.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UBlasterCosmeticsSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Server only, the server plays its own cosmetics when the event happens
+	void QueueFire(ABlasterCharacter* Character, const FVector& Target, uint16 Seed);
+	void QueueHitReact(ABlasterCharacter* Character, EHitZone HitZone);
+
+	// Plays events received from the server
+	void PlayEvents(const TArray<FCosmeticEvent>& Events) const;
+
+	// Whether the local player could notice cosmetics of Actor, always true without a local view
+	bool ShouldPlayLocally(const AActor* Actor) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	bool ShouldQueue(const ABlasterCharacter* Character) const;
+	// The pending event of Character and Type, a later event overwrites the earlier one
+	FCosmeticEvent& Queue(ABlasterCharacter* Character, ECosmeticEventType Type);
+	void OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void Flush();
+	// Server replays do not record client RPCs, so a recording gets every event through a multicast of its own
+	void RecordForReplay(const TArray<FCosmeticEvent>& Events) const;
+	// Distance squared to the view when Location should be played for it, negative when it is culled
+	float GetViewDistanceSquared(const FVector& ViewLocation, const FRotator& ViewRotation, const FVector& Location) const;
+
+	UPROPERTY(Config)
+	float FlushInterval = 0.033f;
+
+	// Heard from any direction
+	UPROPERTY(Config)
+	float AudibleDistance = 2000.f;
+
+	UPROPERTY(Config)
+	float MaxDistance = 10000.f;
+
+	// Half angle of the view cone, wider than the camera so turning does not miss what just started
+	UPROPERTY(Config)
+	float ViewConeHalfAngle = 70.f;
+
+	// Closest events win when more happen in one flush
+	UPROPERTY(Config)
+	int32 MaxEventsPerConnection = 24;
+
+	float ViewConeCos = 0.f;
+	float TimeSinceFlush = 0.f;
+
+	UPROPERTY()
+	TArray<FCosmeticEvent> Pending;
+	// Index in Pending of the event of each character and type, a later event replaces the earlier one
+	TMap<TPair<ABlasterCharacter*, ECosmeticEventType>, int32> PendingIndices;
+	FDelegateHandle PostActorTickHandle;
+};
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterDamageSubsystem.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/ShotValidation/ShotValidationSubsystem.h"
+#include "HitZoneSubsystem.h"
+#include "Blaster/BlasterStats.h"
+#include "Kismet/GameplayStatics.h"
+
+bool UBlasterDamageSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBlasterDamageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Collection.InitializeDependency<UShotValidationSubsystem>();
+
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UBlasterDamageSubsystem::OnPostActorTick);
+}
+
+void UBlasterDamageSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	Hits.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBlasterDamageSubsystem::QueueDamage(AActor* Victim, float Damage, AController* Instigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageType)
+{
+	if (Victim == nullptr || Damage <= 0.f) return;
+
+	FBlasterDamageHit& Hit = Hits.AddDefaulted_GetRef();
+	Hit.Victim = Victim;
+	Hit.Instigator = Instigator;
+	Hit.DamageCauser = DamageCauser;
+	Hit.DamageType = DamageType ? DamageType : TSubclassOf<UDamageType>(UDamageType::StaticClass());
+	Hit.Damage = Damage;
+}
+
+void UBlasterDamageSubsystem::QueuePointDamage(AActor* Victim, float Damage, const FHitResult& Hit, const FVector& ShotDirection, AController* Instigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageType)
+{
+	if (Victim == nullptr) return;
+
+	UHitZoneSubsystem* HitZones = GetWorld()->GetSubsystem<UHitZoneSubsystem>();
+	const EHitZone HitZone = HitZones ? HitZones->Resolve(Hit) : EHitZone::EHZ_Body;
+	const float ZoneDamage = Damage * (HitZones ? HitZones->GetDamageMultiplier(HitZone) : 1.f);
+	if (ZoneDamage <= 0.f) return;
+
+	QueueDamage(Victim, ZoneDamage, Instigator, DamageCauser, DamageType);
+
+	FBlasterDamageHit& Queued = Hits.Last();
+	Queued.bPointDamage = true;
+	Queued.Hit = Hit;
+	Queued.ShotDirection = ShotDirection;
+	Queued.HitZone = HitZone;
+}
+
+void UBlasterDamageSubsystem::OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld()) return;
+
+	if (UShotValidationSubsystem* ShotValidation = InWorld->GetSubsystem<UShotValidationSubsystem>())
+	{
+		ShotValidation->ProcessRequests();
+	}
+	if (Hits.Num() > 0)
+	{
+		Flush();
+	}
+}
+
+void UBlasterDamageSubsystem::Flush()
+{
+	BLASTER_SCOPE(DamageResolve);
+	LLM_SCOPE_BYTAG(Blaster_Combat);
+
+	struct FVictimDamage
+	{
+		AActor* Victim = nullptr;
+		const FBlasterDamageHit* Attribution = nullptr;
+		float Damage = 0.f;
+		float HealthLeft = 0.f;
+	};
+
+	// Eliminations respawn and fire again, anything queued while applying waits for the next frame
+	TArray<FBlasterDamageHit> Batch = MoveTemp(Hits);
+	Hits.Reset();
+
+	TArray<FVictimDamage, TInlineAllocator<16>> Victims;
+	TMap<AActor*, int32, TInlineSetAllocator<16>> VictimIndices;
+	for (const FBlasterDamageHit& Hit : Batch)
+	{
+		AActor* Victim = Hit.Victim.Get();
+		if (Victim == nullptr) continue;
+
+		int32 Index;
+		if (const int32* Found = VictimIndices.Find(Victim))
+		{
+			Index = *Found;
+		}
+		else
+		{
+			const ABlasterCharacter* BlasterCharacter = Cast<ABlasterCharacter>(Victim);
+			if (BlasterCharacter && BlasterCharacter->IsElimmed()) continue;
+
+			Index = Victims.AddDefaulted();
+			VictimIndices.Add(Victim, Index);
+			Victims[Index].Victim = Victim;
+			Victims[Index].HealthLeft = BlasterCharacter ? BlasterCharacter->GetHealth() : TNumericLimits<float>::Max();
+		}
+
+		// Hits after the lethal one change nothing and must not take the kill away from its attacker
+		FVictimDamage& Entry = Victims[Index];
+		if (Entry.HealthLeft <= 0.f) continue;
+
+		Entry.Damage += Hit.Damage;
+		Entry.HealthLeft -= Hit.Damage;
+		Entry.Attribution = &Hit;
+	}
+
+	CSV_CUSTOM_STAT(Blaster, DamageHits, Batch.Num(), ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(Blaster, DamageVictims, Victims.Num(), ECsvCustomStatOp::Accumulate);
+
+	for (const FVictimDamage& Entry : Victims)
+	{
+		// No attribution when the victim had no health left to take, it is not elimmed yet but nothing reached it
+		if (!IsValid(Entry.Victim) || Entry.Attribution == nullptr) continue;
+
+		const FBlasterDamageHit& Hit = *Entry.Attribution;
+		// A projectile destroyed itself on impact, it is still the damage causer
+		if (Hit.bPointDamage)
+		{
+			const FHitZoneDamageEvent DamageEvent(Entry.Damage, Hit.Hit, Hit.ShotDirection, Hit.DamageType, Hit.HitZone);
+			Entry.Victim->TakeDamage(Entry.Damage, DamageEvent, Hit.Instigator.Get(), Hit.DamageCauser.Get(true));
+		}
+		else
+		{
+			UGameplayStatics::ApplyDamage(Entry.Victim, Entry.Damage, Hit.Instigator.Get(), Hit.DamageCauser.Get(true), Hit.DamageType);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameFramework/DamageType.h"
+#include "Engine/DamageEvents.h"
+#include "Blaster/BlasterTypes/HitZone.h"
+#include "BlasterDamageSubsystem.generated.h"
+
+struct FBlasterDamageHit
+{
+	TWeakObjectPtr<AActor> Victim;
+	TWeakObjectPtr<AController> Instigator;
+	TWeakObjectPtr<AActor> DamageCauser;
+	TSubclassOf<UDamageType> DamageType;
+	float Damage = 0.f;
+	// Point damage only
+	bool bPointDamage = false;
+	FHitResult Hit;
+	FVector ShotDirection = FVector::ZeroVector;
+	EHitZone HitZone = EHitZone::EHZ_Body;
+};
+
+/**
+* Point damage that tells the victim which hit zone it struck, the zone's multiplier is already part of the damage
+*/
+struct FHitZoneDamageEvent : public FPointDamageEvent
+{
+	EHitZone HitZone = EHitZone::EHZ_Body;
+
+	static const int32 ClassID = 100;
+
+	FHitZoneDamageEvent(float InDamage, const FHitResult& InHitInfo, const FVector& InShotDirection, TSubclassOf<UDamageType> InDamageTypeClass, EHitZone InHitZone)
+		: FPointDamageEvent(InDamage, InHitInfo, InShotDirection, InDamageTypeClass), HitZone(InHitZone)
+	{
+	}
+
+	virtual int32 GetTypeID() const override { return FHitZoneDamageEvent::ClassID; }
+	virtual bool IsOfType(int32 InID) const override { return FHitZoneDamageEvent::ClassID == InID || FPointDamageEvent::IsOfType(InID); }
+};
+
+/**
+* Server side damage queue. Damage dealt during a frame is collected and resolved once per victim after all actors
+* ticked, so a shotgun volley or focus fire clamps health, updates the HUD, plays the hit react and replicates Health once.
+* Victims resolve in the order they were first hit. The attacker is the one whose hit was lethal, or the last one.
+* Point damage is scaled by the hit zone of each hit and applied as an FHitZoneDamageEvent with the attacker's hit.
+* Pending projectile hits are validated first, their damage is part of the same frame.
+*/
+UCLASS()
+class BLASTER_API UBlasterDamageSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void QueueDamage(AActor* Victim, float Damage, AController* Instigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageType = UDamageType::StaticClass());
+	// Damage is scaled by the hit zone Hit struck, see UHitZoneSubsystem
+	void QueuePointDamage(AActor* Victim, float Damage, const FHitResult& Hit, const FVector& ShotDirection, AController* Instigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageType = UDamageType::StaticClass());
+
+	// Applies everything queued so far, one ApplyDamage per victim
+	void Flush();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	TArray<FBlasterDamageHit> Hits;
+	FDelegateHandle PostActorTickHandle;
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitZoneSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkinnedAsset.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "Blaster/BlasterStats.h"
+
+EHitZone FHitZoneTable::Find(int32 BodyIndex, FName BoneName) const
+{
+	if (BodyBones.IsValidIndex(BodyIndex) && BodyBones[BodyIndex] == BoneName)
+	{
+		return Zones[BodyIndex];
+	}
+	// Hits that did not report their body
+	const int32 Index = BodyBones.IndexOfByKey(BoneName);
+	return Index != INDEX_NONE ? Zones[Index] : EHitZone::EHZ_Body;
+}
+
+bool UHitZoneSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHitZoneSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	for (const FHitZoneBone& ZoneBone : ZoneBones)
+	{
+		ZoneByBone.Add(ZoneBone.Bone, ZoneBone.Zone);
+	}
+}
+
+void UHitZoneSubsystem::Deinitialize()
+{
+	Tables.Reset();
+
+	Super::Deinitialize();
+}
+
+void UHitZoneSubsystem::Prepare(const USkeletalMeshComponent* Mesh)
+{
+	FindOrBuildTable(Mesh);
+}
+
+EHitZone UHitZoneSubsystem::Resolve(const FHitResult& Hit)
+{
+	const FHitZoneTable* Table = FindOrBuildTable(Cast<USkeletalMeshComponent>(Hit.GetComponent()));
+	return Table ? Table->Find(Hit.Item, Hit.BoneName) : EHitZone::EHZ_Body;
+}
+
+float UHitZoneSubsystem::GetDamageMultiplier(EHitZone Zone) const
+{
+	switch (Zone)
+	{
+	case EHitZone::EHZ_Head:
+		return HeadDamageMultiplier;
+	case EHitZone::EHZ_Limb:
+		return LimbDamageMultiplier;
+	default:
+		return 1.f;
+	}
+}
+
+const FHitZoneTable* UHitZoneSubsystem::FindOrBuildTable(const USkeletalMeshComponent* Mesh)
+{
+	const UPhysicsAsset* PhysicsAsset = Mesh ? Mesh->GetPhysicsAsset() : nullptr;
+	if (PhysicsAsset == nullptr) return nullptr;
+	if (const FHitZoneTable* Found = Tables.Find(PhysicsAsset)) return Found;
+
+	LLM_SCOPE_BYTAG(Blaster_Combat);
+
+	const FReferenceSkeleton* RefSkeleton = Mesh->GetSkinnedAsset() ? &Mesh->GetSkinnedAsset()->GetRefSkeleton() : nullptr;
+	FHitZoneTable& Table = Tables.Add(PhysicsAsset);
+	Table.BodyBones.Reserve(PhysicsAsset->SkeletalBodySetups.Num());
+	Table.Zones.Reserve(PhysicsAsset->SkeletalBodySetups.Num());
+	for (const USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+	{
+		const FName BoneName = BodySetup ? BodySetup->BoneName : NAME_None;
+
+		// Bones that are not listed take the zone of their closest listed parent
+		EHitZone Zone = EHitZone::EHZ_Body;
+		int32 BoneIndex = RefSkeleton ? RefSkeleton->FindBoneIndex(BoneName) : INDEX_NONE;
+		for (FName Bone = BoneName; Bone != NAME_None;)
+		{
+			if (const EHitZone* Listed = ZoneByBone.Find(Bone))
+			{
+				Zone = *Listed;
+				break;
+			}
+			BoneIndex = BoneIndex != INDEX_NONE ? RefSkeleton->GetParentIndex(BoneIndex) : INDEX_NONE;
+			Bone = BoneIndex != INDEX_NONE ? RefSkeleton->GetBoneName(BoneIndex) : NAME_None;
+		}
+
+		Table.BodyBones.Add(BoneName);
+		Table.Zones.Add(Zone);
+	}
+	return &Table;
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "Blaster/BlasterTypes/HitZone.h"
+#include "HitZoneSubsystem.generated.h"
+
+class UPhysicsAsset;
+class USkeletalMeshComponent;
+
+USTRUCT()
+struct FHitZoneBone
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+	FName Bone;
+
+	// Also the zone of every bone below it that is not listed itself
+	UPROPERTY(EditAnywhere)
+	EHitZone Zone = EHitZone::EHZ_Body;
+};
+
+/**
+* Hit zone of every body of a physics asset, indexed like its bodies
+*/
+struct FHitZoneTable
+{
+	TArray<FName> BodyBones;
+	TArray<EHitZone> Zones;
+
+	EHitZone Find(int32 BodyIndex, FName BoneName) const;
+};
+
+/**
+* Per bone damage. ZoneBones are baked once per physics asset into a table indexed by body, a hit on a skeletal mesh
+* reports the body it hit in FHitResult::Item, so resolving a hit is an index instead of a walk up the bone names.
+* The zone depends only on the physics asset and the body, hits traced against rewound body transforms resolve the same.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UHitZoneSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Bakes the table of the mesh's physics asset ahead of the first hit
+	void Prepare(const USkeletalMeshComponent* Mesh);
+
+	// Body for anything that is not a skeletal mesh with a physics asset
+	EHitZone Resolve(const FHitResult& Hit);
+
+	float GetDamageMultiplier(EHitZone Zone) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	const FHitZoneTable* FindOrBuildTable(const USkeletalMeshComponent* Mesh);
+
+	UPROPERTY(Config)
+	TArray<FHitZoneBone> ZoneBones;
+
+	UPROPERTY(Config)
+	float HeadDamageMultiplier = 2.f;
+
+	UPROPERTY(Config)
+	float LimbDamageMultiplier = 0.75f;
+
+	TMap<FName, EHitZone> ZoneByBone;
+	// A physics asset that is unloaded and loaded again gets a new key, so its old table is never reused
+	TMap<TObjectKey<UPhysicsAsset>, FHitZoneTable> Tables;
+};
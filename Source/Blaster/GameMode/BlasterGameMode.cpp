@@ -7,6 +7,15 @@
 #include "GameFramework/PlayerStart.h"
 #include "Blaster/PlayerState/BlasterPlayerState.h"
 #include "Blaster/GameState/BlasterGameState.h"
+#include "Blaster/BlasterTypes/MatchSnapshot.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "Blaster/AI/BlasterAIController.h"
+#include "Blaster/BlasterStats.h"
+#include "Blaster/BlasterMemoryReport.h"
+#include "Blaster/Assets/BlasterAssetPreloadSubsystem.h"
+#include "Engine/NetDriver.h"
+#include "EngineUtils.h"
+#include "Misc/App.h"
 
 namespace MatchState
 {
@@ -16,6 +25,7 @@ namespace MatchState
 ABlasterGameMode::ABlasterGameMode()
 {
 	bDelayedStart = true;
+	BotControllerClass = ABlasterAIController::StaticClass();
 }
 
 void ABlasterGameMode::BeginPlay()
@@ -23,39 +33,277 @@ void ABlasterGameMode::BeginPlay()
 	Super::BeginPlay();
 
 	LevelStartingTime = GetWorld()->GetTimeSeconds();
+
+	BotFillTarget = FMath::Max(BotFillTarget, UGameplayStatics::GetIntOption(OptionsString, TEXT("BotFill"), 0));
+	UpdateBotFill();
+
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (bGovernTickRate && NetDriver && IsRunningDedicatedServer())
+	{
+		// The net driver outlives the game mode across travel and RestartGame, its live rate may be one this governor set
+		MaxTickRate = NetDriver->GetClass()->GetDefaultObject<UNetDriver>()->GetNetServerMaxTickRate();
+		GovernedTickRate = NetDriver->GetNetServerMaxTickRate();
+		ApplyTickRate(GetDesiredTickRate());
+	}
+}
+
+void ABlasterGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (MaxTickRate > 0)
+	{
+		ApplyTickRate(MaxTickRate);
+		MaxTickRate = 0;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ABlasterGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	UpdateBotFill();
+}
+
+void ABlasterGameMode::Logout(AController* Exiting)
+{
+	Super::Logout(Exiting);
+
+	// Bots log out when RemoveBots destroys them, only a leaving player changes the fill
+	if (AAIController* Bot = Cast<AAIController>(Exiting))
+	{
+		Bots.Remove(Bot);
+		return;
+	}
+	UpdateBotFill();
+}
+
+void ABlasterGameMode::UpdateBotFill()
+{
+	if (BotFillTarget <= 0) return;
+
+	const int32 NumHumans = GetNumPlayers();
+	const int32 DesiredBots = FMath::Max(BotFillTarget - NumHumans, 0);
+	if (DesiredBots > Bots.Num())
+	{
+		AddBots(DesiredBots - Bots.Num());
+	}
+	else if (DesiredBots < Bots.Num())
+	{
+		RemoveBots(Bots.Num() - DesiredBots);
+	}
+}
+
+void ABlasterGameMode::AddBots(int32 NumBots)
+{
+	LLM_SCOPE_BYTAG(Blaster_Combat);
+	if (BotControllerClass == nullptr) return;
+
+	for (int32 i = 0; i < NumBots; ++i)
+	{
+		AAIController* Bot = GetWorld()->SpawnActor<AAIController>(BotControllerClass);
+		if (Bot == nullptr) continue;
+
+		if (Bot->PlayerState)
+		{
+			Bot->PlayerState->SetPlayerName(FString::Printf(TEXT("Bot%d"), Bots.Num()));
+		}
+		Bots.Add(Bot);
+		RestartPlayer(Bot);
+	}
+}
+
+void ABlasterGameMode::RemoveBots(int32 NumBots)
+{
+	for (int32 i = 0; i < NumBots && Bots.Num() > 0; ++i)
+	{
+		AAIController* Bot = Bots.Pop();
+		if (Bot == nullptr) continue;
+
+		if (APawn* BotPawn = Bot->GetPawn())
+		{
+			BotPawn->Destroy();
+		}
+		Bot->Destroy();
+	}
 }
 
 void ABlasterGameMode::Tick(float DeltaTime)
 {
+	BLASTER_SCOPE(GameModeTick);
+
 	Super::Tick(DeltaTime);
 
+	UpdateTickGovernor(DeltaTime);
+
+	CountdownTime = GetPhaseDeadline() - GetWorld()->GetTimeSeconds();
+	if (CountdownTime > 0.f) return;
+
 	if (MatchState == MatchState::WaitingToStart)
 	{
-		CountdownTime = WarmupTime - GetWorld()->GetTimeSeconds() + LevelStartingTime;
-		if (CountdownTime <= 0.f)
-		{
-			StartMatch();
-		}
+		// Nothing may load synchronously once the fighting starts
+		const UBlasterAssetPreloadSubsystem* Preload = GetWorld()->GetSubsystem<UBlasterAssetPreloadSubsystem>();
+		if (Preload && !Preload->IsPreloadComplete() && CountdownTime > -MaxPreloadWaitTime) return;
+		StartMatch();
 	}
 	else if (MatchState == MatchState::InProgress)
 	{
-		CountdownTime = WarmupTime + MatchTime - GetWorld()->GetTimeSeconds() + LevelStartingTime;
-		if (CountdownTime <= 0.f)
+		SetMatchState(MatchState::Cooldown);
+	}
+	else if (MatchState == MatchState::Cooldown)
+	{
+		RestartGame();
+	}
+}
+
+void ABlasterGameMode::UpdateTickGovernor(float DeltaTime)
+{
+	if (MaxTickRate <= 0) return;
+
+	// The engine sleeps away the rest of each frame to hold the tick rate, what is left is the work the server did
+	const float FrameBudget = 1.f / FMath::Max(GovernedTickRate, 1);
+	const float WorkTime = FMath::Max(float(FApp::GetDeltaTime() - FApp::GetIdleTime()), 0.f);
+	LoadFraction = FMath::Lerp(LoadFraction, WorkTime / FrameBudget, 0.05f);
+	CSV_CUSTOM_STAT(Blaster, ServerTickRate, GovernedTickRate, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Blaster, ServerLoadFraction, LoadFraction, ECsvCustomStatOp::Set);
+
+	GovernorCountdown -= DeltaTime;
+	if (GovernorCountdown > 0.f) return;
+	GovernorCountdown = 1.f;
+
+	const int32 DesiredTickRate = GetDesiredTickRate();
+	if (DesiredTickRate > GovernedTickRate)
+	{
+		LowerTickRateTime = 0.f;
+		ApplyTickRate(DesiredTickRate);
+	}
+	else if (DesiredTickRate < GovernedTickRate)
+	{
+		LowerTickRateTime += 1.f;
+		if (LowerTickRateTime >= TickRateHoldTime)
 		{
-			SetMatchState(MatchState::Cooldown);
+			LowerTickRateTime = 0.f;
+			ApplyTickRate(DesiredTickRate);
 		}
 	}
-	else if (MatchState == MatchState::Cooldown)
+	else
+	{
+		LowerTickRateTime = 0.f;
+	}
+	// New characters spawn with their class defaults
+	ApplyNetUpdateRates();
+}
+
+int32 ABlasterGameMode::GetDesiredTickRate() const
+{
+	if (MatchState == MatchState::WaitingToStart) return FMath::Min(WarmupTickRate, MaxTickRate);
+	if (MatchState == MatchState::Cooldown) return FMath::Min(CooldownTickRate, MaxTickRate);
+
+	const int32 Floor = FMath::Min(CombatMinTickRate, MaxTickRate);
+	const float PlayerFraction = FMath::Clamp(float(GetNumPlayers() + Bots.Num()) / FMath::Max(FullMatchPlayers, 1), 0.f, 1.f);
+	int32 DesiredTickRate = FMath::RoundToInt(FMath::Lerp(float(Floor), float(MaxTickRate), PlayerFraction));
+
+	// Between the two load thresholds the current rate is kept so the governor does not oscillate
+	if (LoadFraction > HighLoadFraction)
+	{
+		DesiredTickRate = FMath::Min(DesiredTickRate, GovernedTickRate - MinTickRateChange);
+	}
+	else if (LoadFraction > LowLoadFraction)
 	{
-		CountdownTime = CooldownTime + WarmupTime + MatchTime - GetWorld()->GetTimeSeconds() + LevelStartingTime;
-		if (CountdownTime <= 0.f)
+		DesiredTickRate = FMath::Min(DesiredTickRate, GovernedTickRate);
+	}
+
+	// Small steps are not worth a change of replication rates
+	if (FMath::Abs(DesiredTickRate - GovernedTickRate) < MinTickRateChange && DesiredTickRate != Floor && DesiredTickRate != MaxTickRate)
+	{
+		DesiredTickRate = GovernedTickRate;
+	}
+	return FMath::Clamp(DesiredTickRate, Floor, MaxTickRate);
+}
+
+void ABlasterGameMode::ApplyTickRate(int32 TickRate)
+{
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (NetDriver == nullptr || TickRate == NetDriver->GetNetServerMaxTickRate()) return;
+
+	UE_LOG(LogTemp, Log, TEXT("Tick governor: %d -> %d Hz (%s, %d players, load %.2f)"), GovernedTickRate, TickRate, *MatchState.ToString(), GetNumPlayers() + Bots.Num(), LoadFraction);
+	NetDriver->SetNetServerMaxTickRate(TickRate);
+	GovernedTickRate = TickRate;
+	ApplyNetUpdateRates();
+}
+
+void ABlasterGameMode::ApplyNetUpdateRates() const
+{
+	// Updating actors more often than the server ticks only spends time checking them
+	for (TActorIterator<ABlasterCharacter> It(GetWorld()); It; ++It)
+	{
+		const AActor* Defaults = It->GetClass()->GetDefaultObject<AActor>();
+		It->NetUpdateFrequency = FMath::Min(Defaults->NetUpdateFrequency, float(GovernedTickRate));
+		It->MinNetUpdateFrequency = FMath::Min(Defaults->MinNetUpdateFrequency, It->NetUpdateFrequency);
+	}
+}
+
+float ABlasterGameMode::GetPhaseDeadline() const
+{
+	if (MatchState == MatchState::WaitingToStart) return LevelStartingTime + WarmupTime;
+	if (MatchState == MatchState::InProgress) return LevelStartingTime + WarmupTime + MatchTime;
+	if (MatchState == MatchState::Cooldown) return LevelStartingTime + WarmupTime + MatchTime + CooldownTime;
+	return TNumericLimits<float>::Max();
+}
+
+void ABlasterGameMode::BuildMatchSnapshot(APlayerController* Requester, float ClientRequestTime, FBlasterMatchSnapshot& OutSnapshot) const
+{
+	LLM_SCOPE_BYTAG(Blaster_Replication);
+	OutSnapshot.MatchState = MatchState;
+	OutSnapshot.PhaseDeadline = GetPhaseDeadline();
+	OutSnapshot.WarmupTime = WarmupTime;
+	OutSnapshot.MatchTime = MatchTime;
+	OutSnapshot.CooldownTime = CooldownTime;
+	OutSnapshot.ClientRequestTime = ClientRequestTime;
+	OutSnapshot.ServerTime = GetWorld()->GetTimeSeconds();
+
+	AActor* ViewTarget = Requester ? Requester->GetViewTarget() : nullptr;
+	const FVector ViewLocation = ViewTarget ? ViewTarget->GetActorLocation() : FVector::ZeroVector;
+
+	if (ABlasterPlayerState* BlasterPlayerState = Requester ? Requester->GetPlayerState<ABlasterPlayerState>() : nullptr)
+	{
+		FSnapshotPlayerEntry& Entry = OutSnapshot.Requester;
+		OutSnapshot.bHasRequester = true;
+		Entry.Score = BlasterPlayerState->GetScore();
+		Entry.Defeats = BlasterPlayerState->GetDefeats();
+
+		ABlasterCharacter* BlasterCharacter = Cast<ABlasterCharacter>(Requester->GetPawn());
+		if (BlasterCharacter && BlasterCharacter->GetEquippedWeapon())
 		{
-			RestartGame();
+			Entry.EquippedWeapon = BlasterCharacter->GetEquippedWeapon();
+			Entry.Ammo = Entry.EquippedWeapon->GetAmmo();
 		}
 	}
+
+	for (TActorIterator<AWeapon> It(GetWorld()); It; ++It)
+	{
+		AWeapon* Weapon = *It;
+		if (Weapon->GetWeaponState() == EWeaponState::EWS_Equipped) continue;
+
+		FSnapshotWeaponEntry& Entry = OutSnapshot.DroppedWeapons.AddDefaulted_GetRef();
+		Entry.Weapon = Weapon;
+		Entry.Location = Weapon->GetActorLocation();
+		Entry.WeaponState = Weapon->GetWeaponState();
+		Entry.bDormant = Weapon->NetDormancy > DORM_Awake;
+	}
+
+	// Weapons left out still bring their state along when they replicate
+	if (OutSnapshot.DroppedWeapons.Num() > FBlasterMatchSnapshot::MaxDroppedWeapons)
+	{
+		OutSnapshot.DroppedWeapons.Sort([&ViewLocation](const FSnapshotWeaponEntry& A, const FSnapshotWeaponEntry& B)
+		{
+			return FVector::DistSquared(A.Location, ViewLocation) < FVector::DistSquared(B.Location, ViewLocation);
+		});
+		OutSnapshot.DroppedWeapons.SetNum(FBlasterMatchSnapshot::MaxDroppedWeapons);
+	}
 }
 
-void ABlasterGameMode::PlayerEliminated(class ABlasterCharacter* ElimmedCharacter, class ABlasterPlayerController* VictimController, ABlasterPlayerController* AttackerController)
+void ABlasterGameMode::PlayerEliminated(class ABlasterCharacter* ElimmedCharacter, AController* VictimController, AController* AttackerController)
 {
 	if (AttackerController == nullptr || AttackerController->PlayerState == nullptr) return;
 	if (VictimController == nullptr || VictimController->PlayerState == nullptr) return;
@@ -82,6 +330,7 @@ void ABlasterGameMode::PlayerEliminated(class ABlasterCharacter* ElimmedCharacte
 
 void ABlasterGameMode::RequestRespawn(ACharacter* ElimmedCharacter, AController* ElimmedController)
 {
+	LLM_SCOPE_BYTAG(Blaster_Combat);
 	if (ElimmedCharacter)
 	{
 		ElimmedCharacter->Reset();
@@ -96,10 +345,37 @@ void ABlasterGameMode::RequestRespawn(ACharacter* ElimmedCharacter, AController*
 	}
 }
 
+void ABlasterGameMode::RunMatchPhaseCycles(int32 Cycles, TArray<double>& OutCycleTimes)
+{
+	const FName PreviousState = MatchState;
+	bMatchStateSideEffects = false;
+	for (int32 i = 0; i < Cycles; ++i)
+	{
+		const double Start = FPlatformTime::Seconds();
+		SetMatchState(MatchState::InProgress);
+		SetMatchState(MatchState::Cooldown);
+		OutCycleTimes.Add((FPlatformTime::Seconds() - Start) * 1.e6);
+	}
+	bMatchStateSideEffects = true;
+	SetMatchState(PreviousState);
+}
+
 void ABlasterGameMode::OnMatchStateSet()
 {
 	Super::OnMatchStateSet();
 
+	if (bMatchStateSideEffects)
+	{
+		BlasterMemoryReport::ReportPhaseChange(GetWorld(), MatchState);
+
+		// A phase change is applied at once, the match starting must not wait out the hold time
+		if (MaxTickRate > 0)
+		{
+			LowerTickRateTime = 0.f;
+			ApplyTickRate(GetDesiredTickRate());
+		}
+	}
+
 	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
 	{
 		ABlasterPlayerController* BlasterPlayer = Cast<ABlasterPlayerController>(*It);
@@ -6,6 +6,9 @@
 #include "GameFramework/GameMode.h"
 #include "BlasterGameMode.generated.h"
 
+struct FBlasterMatchSnapshot;
+class AAIController;
+
 namespace MatchState
 {
 	extern BLASTER_API const FName Cooldown; // Match duration has been reached. Display winner and begin cooldown timer.
@@ -18,11 +21,38 @@ UCLASS()
 class BLASTER_API ABlasterGameMode : public AGameMode
 {
 	GENERATED_BODY()
+
 public:
 	ABlasterGameMode();
 	virtual void Tick(float DeltaTime) override;
-	virtual void PlayerEliminated(class ABlasterCharacter* ElimmedCharacter, class ABlasterPlayerController* VictimController, ABlasterPlayerController* AttackerController);
+	// Controllers are not necessarily player controllers, bots are eliminated and respawned the same way
+	virtual void PlayerEliminated(class ABlasterCharacter* ElimmedCharacter, AController* VictimController, AController* AttackerController);
 	virtual void RequestRespawn(ACharacter* ElimmedCharacter, AController* ElimmedController);
+	// Gathers the state a player joining mid match needs, in a single snapshot
+	void BuildMatchSnapshot(APlayerController* Requester, float ClientRequestTime, FBlasterMatchSnapshot& OutSnapshot) const;
+	float GetPhaseDeadline() const; // Server time at which the current match phase ends
+	/**
+	* Test hook for the MatchPhaseCycle benchmark. Runs the InProgress and Cooldown transitions Cycles times, adds the
+	* time of each cycle in microseconds to OutCycleTimes and returns to the state it started from. The memory report
+	* and the tick governor sit these transitions out, they would be measured instead of the phase change.
+	*/
+	void RunMatchPhaseCycles(int32 Cycles, TArray<double>& OutCycleTimes);
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	virtual void Logout(AController* Exiting) override;
+
+	/**
+	* Bots
+	*/
+	void AddBots(int32 NumBots);
+	void RemoveBots(int32 NumBots);
+	FORCEINLINE int32 GetNumBotControllers() const { return Bots.Num(); }
+
+	UPROPERTY(EditDefaultsOnly, Category = Bots)
+	TSubclassOf<AAIController> BotControllerClass;
+
+	// Bots are added or removed as players join and leave so the match always has this many participants. 0 disables filling.
+	UPROPERTY(EditDefaultsOnly, Category = Bots)
+	int32 BotFillTarget = 0;
 
 	UPROPERTY(EditDefaultsOnly)
 	float MatchTime = 120.f;
@@ -33,11 +63,72 @@ public:
 	UPROPERTY(EditDefaultsOnly)
 	float CooldownTime = 10.f;
 
+	// Longest the match start waits past warmup for weapon and FX assets to finish streaming in
+	UPROPERTY(EditDefaultsOnly)
+	float MaxPreloadWaitTime = 10.f;
+
 	float LevelStartingTime = 0.f;
 
+	/**
+	* Tick governor, dedicated servers only. The NetServerMaxTickRate configured for the net driver is the ceiling, it is restored when the game mode ends.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	bool bGovernTickRate = true;
+
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	int32 WarmupTickRate = 30;
+
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	int32 CooldownTickRate = 20;
+
+	// Hard floor while the match is in progress, load never pushes the tick rate below it
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	int32 CombatMinTickRate = 60;
+
+	// Player count at which a match in progress runs at the ceiling, fewer players scale down towards CombatMinTickRate
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	int32 FullMatchPlayers = 16;
+
+	// Fraction of the frame budget spent working above which the tick rate is lowered, and below which it may rise again
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	float HighLoadFraction = 0.85f;
+
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	float LowLoadFraction = 0.5f;
+
+	// A lower rate has to be wanted this long before it is applied, raising applies at once
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	float TickRateHoldTime = 5.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = TickGovernor)
+	int32 MinTickRateChange = 10;
+
+	FORCEINLINE int32 GetGovernedTickRate() const { return GovernedTickRate; }
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void OnMatchStateSet() override;
 private:
+	void UpdateBotFill();
+
+	void UpdateTickGovernor(float DeltaTime);
+	int32 GetDesiredTickRate() const;
+	void ApplyTickRate(int32 TickRate);
+	void ApplyNetUpdateRates() const;
+
 	float CountdownTime = 0.f;
+
+	// Off inside RunMatchPhaseCycles
+	bool bMatchStateSideEffects = true;
+
+	int32 MaxTickRate = 0;
+	int32 GovernedTickRate = 0;
+	float GovernorCountdown = 0.f;
+	float LowerTickRateTime = 0.f;
+	// Running average of the fraction of each frame's budget spent working rather than waiting for the next tick
+	float LoadFraction = 0.f;
+
+	UPROPERTY()
+	TArray<AAIController*> Bots;
 };
\ No newline at end of file
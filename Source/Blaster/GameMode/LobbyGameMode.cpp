@@ -3,18 +3,106 @@
 
 #include "LobbyGameMode.h"
 #include "GameFramework/GameStateBase.h"
+#include "Blaster/PlayerState/BlasterPlayerState.h"
+#include "Blaster/Travel/BlasterTravelSubsystem.h"
+#include "TimerManager.h"
+
+ALobbyGameMode::ALobbyGameMode()
+{
+  PlayerStateClass = ABlasterPlayerState::StaticClass();
+  bUseSeamlessTravel = true;
+}
+
+void ALobbyGameMode::BeginPlay()
+{
+  Super::BeginPlay();
+
+  if (UBlasterTravelSubsystem* Travel = GetGameInstance()->GetSubsystem<UBlasterTravelSubsystem>())
+  {
+    Travel->PreloadMap(MatchMap);
+  }
+  GetWorldTimerManager().SetTimer(ReadinessTimer, this, &ALobbyGameMode::EvaluateReadiness, 0.5f, true);
+}
 
 void ALobbyGameMode::PostLogin(APlayerController* newplayer)
 {
   Super::PostLogin(newplayer);
 
-  int32 numOfPlayers = GameState.Get()->PlayerArray.Num();
-  if (numOfPlayers == 2)
+  if (FirstPlayerTime < 0.f)
+  {
+    FirstPlayerTime = GetWorld()->GetTimeSeconds();
+  }
+  if (ABlasterPlayerState* BlasterPlayerState = newplayer->GetPlayerState<ABlasterPlayerState>())
+  {
+    BlasterPlayerState->ClientPreloadMap(MatchMap);
+  }
+  EvaluateReadiness();
+}
+
+void ALobbyGameMode::EvaluateReadiness()
+{
+  if (bTraveling || GameState == nullptr) return;
+
+  const int32 numOfPlayers = GameState->PlayerArray.Num();
+  const float Now = GetWorld()->GetTimeSeconds();
+  if (numOfPlayers == 0)
+  {
+    FirstPlayerTime = -1.f;
+    ReadyDeadline = -1.f;
+    return;
+  }
+
+  if (FullLobbyPlayers > 0 && numOfPlayers >= FullLobbyPlayers)
   {
-    if (UWorld* world = GetWorld())
+    TravelToMatch();
+    return;
+  }
+
+  if (numOfPlayers >= MinPlayers)
+  {
+    if (ReadyDeadline < 0.f)
+    {
+      ReadyDeadline = Now + ReadyUpTimeout;
+    }
+    if (AreAllPlayersReady() || Now >= ReadyDeadline)
     {
-      bUseSeamlessTravel = true;
-      world->ServerTravel(FString("/Game/Maps/BlasterMap?listen"));
+      TravelToMatch();
     }
+    return;
+  }
+  ReadyDeadline = -1.f;
+
+  if (MaxWaitTime > 0.f && FirstPlayerTime >= 0.f && Now - FirstPlayerTime >= MaxWaitTime)
+  {
+    TravelToMatch();
+  }
+}
+
+bool ALobbyGameMode::AreAllPlayersReady() const
+{
+  for (APlayerState* PlayerState : GameState->PlayerArray)
+  {
+    const ABlasterPlayerState* BlasterPlayerState = Cast<ABlasterPlayerState>(PlayerState);
+    if (BlasterPlayerState == nullptr || !BlasterPlayerState->IsLobbyReady()) return false;
+  }
+  return true;
+}
+
+void ALobbyGameMode::TravelToMatch()
+{
+  UWorld* world = GetWorld();
+  if (world == nullptr) return;
+
+  bTraveling = true;
+  GetWorldTimerManager().ClearTimer(ReadinessTimer);
+
+  FString URL = MatchMap + TEXT("?listen");
+  const int32 numOfPlayers = GameState->PlayerArray.Num();
+  if (numOfPlayers < MinPlayers)
+  {
+    URL += FString::Printf(TEXT("?BotFill=%d"), MinPlayers);
   }
+  const UBlasterTravelSubsystem* Travel = GetGameInstance()->GetSubsystem<UBlasterTravelSubsystem>();
+  UE_LOG(LogTemp, Log, TEXT("Lobby: traveling %d players to %s, map %s"), numOfPlayers, *URL, Travel && Travel->IsMapPreloaded(MatchMap) ? TEXT("preloaded") : TEXT("not preloaded yet"));
+  world->ServerTravel(URL);
 }
@@ -7,7 +7,11 @@
 #include "LobbyGameMode.generated.h"
 
 /**
- * 
+ * Waits for players, then seamlessly travels everyone to the match.
+ * Once MinPlayers are in, the lobby travels when all of them are ready or ReadyUpTimeout ran out.
+ * A player is ready once it streamed the match map in, so the travel does not wait on a slow client's load.
+ * A full lobby travels at once, a lobby that never fills travels after MaxWaitTime with bots filling up to MinPlayers.
+ * The match map is streamed in on the server and every client while they wait.
  */
 UCLASS()
 class BLASTER_API ALobbyGameMode : public AGameMode
@@ -15,5 +19,36 @@ class BLASTER_API ALobbyGameMode : public AGameMode
 	GENERATED_BODY()
 	
 public:
+	ALobbyGameMode();
 	virtual void PostLogin(APlayerController* newplayer) override;
+
+	UPROPERTY(EditDefaultsOnly, Category = Lobby)
+	FString MatchMap = TEXT("/Game/Maps/BlasterMap");
+
+	UPROPERTY(EditDefaultsOnly, Category = Lobby)
+	int32 MinPlayers = 2;
+
+	// Travels at once at this many players, 0 disables
+	UPROPERTY(EditDefaultsOnly, Category = Lobby)
+	int32 FullLobbyPlayers = 8;
+
+	UPROPERTY(EditDefaultsOnly, Category = Lobby)
+	float ReadyUpTimeout = 10.f;
+
+	// Longest a player waits in the lobby, 0 disables
+	UPROPERTY(EditDefaultsOnly, Category = Lobby)
+	float MaxWaitTime = 120.f;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	void EvaluateReadiness();
+	bool AreAllPlayersReady() const;
+	void TravelToMatch();
+
+	FTimerHandle ReadinessTimer;
+	float FirstPlayerTime = -1.f;
+	float ReadyDeadline = -1.f;
+	bool bTraveling = false;
 };
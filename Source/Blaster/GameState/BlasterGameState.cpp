@@ -5,6 +5,7 @@
 #include "BlasterGameState.h"
 #include "Net/UnrealNetwork.h"
 #include "Blaster/PlayerState/BlasterPlayerState.h"
+#include "Blaster/Cosmetics/BlasterCosmeticsSubsystem.h"
 
 void ABlasterGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
@@ -30,4 +31,12 @@ void ABlasterGameState::UpdateTopScore(class ABlasterPlayerState* ScoringPlayer)
 		TopScoringPlayers.AddUnique(ScoringPlayer);
 		TopScore = ScoringPlayer->GetScore();
 	}
-}
\ No newline at end of file
+}
+
+void ABlasterGameState::MulticastReplayCosmeticEvents_Implementation(const TArray<FCosmeticEvent>& Events)
+{
+	if (UBlasterCosmeticsSubsystem* Cosmetics = GetWorld()->GetSubsystem<UBlasterCosmeticsSubsystem>())
+	{
+		Cosmetics->PlayEvents(Events);
+	}
+}
@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameState.h"
+#include "Blaster/BlasterTypes/CosmeticEvent.h"
 #include "BlasterGameState.generated.h"
 
 /**
@@ -20,6 +21,10 @@ public:
 
 	UPROPERTY(Replicated)
 	TArray<ABlasterPlayerState*> TopScoringPlayers;
+
+	// Only sent to the replay being recorded, live clients get their cosmetic events from ClientCosmeticEvents
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastReplayCosmeticEvents(const TArray<FCosmeticEvent>& Events);
 private:
 
 	float TopScore = 0.f;
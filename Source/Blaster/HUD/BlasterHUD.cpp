@@ -6,6 +6,7 @@
 #include "CharacterOverlay.h"
 #include "Blaster/DebugHelper.h"
 #include "Announcment.h"
+#include "Blaster/BlasterStats.h"
 
 void ABlasterHUD::BeginPlay()
 {
@@ -14,6 +15,7 @@ void ABlasterHUD::BeginPlay()
 
 void ABlasterHUD::AddCharacterOverlay()
 {
+	LLM_SCOPE_BYTAG(Blaster_HUD);
 	APlayerController* PlayerController = GetOwningPlayerController();
 	if (PlayerController && CharacterOverlayClass)
 	{
@@ -24,6 +26,7 @@ void ABlasterHUD::AddCharacterOverlay()
 
 void ABlasterHUD::AddAnnouncment()
 {
+	LLM_SCOPE_BYTAG(Blaster_HUD);
 	APlayerController* PlayerController = GetOwningPlayerController();
 	if (PlayerController && AnnouncmentClass)
 	{
@@ -35,6 +38,9 @@ void ABlasterHUD::AddAnnouncment()
 
 void ABlasterHUD::DrawHUD()
 {
+	BLASTER_SCOPE(DrawHUD);
+	LLM_SCOPE_BYTAG(Blaster_HUD);
+
 	Super::DrawHUD();
 
 	FVector2D ViewportSize;
@@ -43,25 +49,19 @@ void ABlasterHUD::DrawHUD()
 		GEngine->GameViewport->GetViewportSize(ViewportSize);
 		const FVector2D ViewportCenter(ViewportSize.X / 2.f, ViewportSize.Y / 2.f);
 
-		if (HUDPackage.CrosshairsCenter)
-		{
-			DrawCrosshair(HUDPackage.CrosshairsCenter, ViewportCenter, HUDPackage.CrosshairsColor);
-		}
-		if (HUDPackage.CrosshairsLeft)
-		{
-			DrawCrosshair(HUDPackage.CrosshairsLeft, ViewportCenter, HUDPackage.CrosshairsColor);
-		}
-		if (HUDPackage.CrosshairsRight)
-		{
-			DrawCrosshair(HUDPackage.CrosshairsRight, ViewportCenter, HUDPackage.CrosshairsColor);
-		}
-		if (HUDPackage.CrosshairsTop)
-		{
-			DrawCrosshair(HUDPackage.CrosshairsTop, ViewportCenter, HUDPackage.CrosshairsColor);
-		}
-		if (HUDPackage.CrosshairsBottom)
+		UTexture2D* Crosshairs[] = {
+			HUDPackage.CrosshairsCenter,
+			HUDPackage.CrosshairsLeft,
+			HUDPackage.CrosshairsRight,
+			HUDPackage.CrosshairsTop,
+			HUDPackage.CrosshairsBottom
+		};
+		for (UTexture2D* Crosshair : Crosshairs)
 		{
-			DrawCrosshair(HUDPackage.CrosshairsBottom, ViewportCenter, HUDPackage.CrosshairsColor);
+			if (Crosshair)
+			{
+				DrawCrosshair(Crosshair, ViewportCenter, HUDPackage.CrosshairsColor);
+			}
 		}
 	}
 }
@@ -11,11 +11,12 @@ struct FHUDPackage
 {
 	GENERATED_BODY()
 public:
-	class UTexture2D* CrosshairsCenter;
-	UTexture2D* CrosshairsLeft;
-	UTexture2D* CrosshairsRight;
-	UTexture2D* CrosshairsTop;
-	UTexture2D* CrosshairsBottom;
+	// Resolved from the equipped weapon's definition when it changes, nullptr draws none
+	class UTexture2D* CrosshairsCenter = nullptr;
+	UTexture2D* CrosshairsLeft = nullptr;
+	UTexture2D* CrosshairsRight = nullptr;
+	UTexture2D* CrosshairsTop = nullptr;
+	UTexture2D* CrosshairsBottom = nullptr;
 	FLinearColor CrosshairsColor;
 };
 
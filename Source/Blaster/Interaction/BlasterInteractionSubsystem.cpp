@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterInteractionSubsystem.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "Blaster/BlasterStats.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SphereComponent.h"
+#include "EngineUtils.h"
+
+bool UBlasterInteractionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBlasterInteractionSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (GetWorld()->GetNetMode() == NM_Client) return;
+
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate >= UpdateInterval)
+	{
+		BLASTER_SCOPE(Interaction);
+
+		UpdatePickups();
+		ResolveInteractions();
+		TimeSinceUpdate = 0.f;
+	}
+}
+
+TStatId UBlasterInteractionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBlasterInteractionSubsystem, STATGROUP_Tickables);
+}
+
+FIntPoint UBlasterInteractionSubsystem::CellFor(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void UBlasterInteractionSubsystem::AddToCell(AWeapon* Weapon, const FIntPoint& Cell)
+{
+	Cells.FindOrAdd(Cell).Add(Weapon);
+}
+
+void UBlasterInteractionSubsystem::RemoveFromCell(AWeapon* Weapon, const FIntPoint& Cell)
+{
+	if (auto* CellPickups = Cells.Find(Cell))
+	{
+		CellPickups->RemoveSwap(Weapon);
+		if (CellPickups->IsEmpty())
+		{
+			Cells.Remove(Cell);
+		}
+	}
+}
+
+void UBlasterInteractionSubsystem::RegisterPickup(AWeapon* Weapon)
+{
+	if (Weapon == nullptr || Pickups.Contains(Weapon)) return;
+
+	FPickup& Pickup = Pickups.Add(Weapon);
+	Pickup.Weapon = Weapon;
+	Pickup.Location = Weapon->GetActorLocation();
+	Pickup.Radius = Weapon->GetAreaSphere() ? Weapon->GetAreaSphere()->GetScaledSphereRadius() : 0.f;
+	Pickup.Cell = CellFor(Pickup.Location);
+	AddToCell(Weapon, Pickup.Cell);
+	MaxPickupRadius = FMath::Max(MaxPickupRadius, Pickup.Radius);
+}
+
+void UBlasterInteractionSubsystem::UnregisterPickup(AWeapon* Weapon)
+{
+	FPickup Pickup;
+	if (!Pickups.RemoveAndCopyValue(Weapon, Pickup)) return;
+
+	RemoveFromCell(Weapon, Pickup.Cell);
+
+	// Nobody may pick up a weapon that was just equipped, don't wait for the next update to take it away
+	for (TActorIterator<ABlasterCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->GetOverlappingWeapon() == Weapon)
+		{
+			It->SetOverlappingWeapon(FindInteractable(*It));
+		}
+	}
+}
+
+void UBlasterInteractionSubsystem::UpdatePickups()
+{
+	for (auto It = Pickups.CreateIterator(); It; ++It)
+	{
+		FPickup& Pickup = It.Value();
+		AWeapon* Weapon = Pickup.Weapon.Get();
+		if (Weapon == nullptr)
+		{
+			RemoveFromCell(It.Key(), Pickup.Cell);
+			It.RemoveCurrent();
+			continue;
+		}
+
+		Pickup.Location = Weapon->GetActorLocation();
+		const FIntPoint Cell = CellFor(Pickup.Location);
+		if (Cell != Pickup.Cell)
+		{
+			RemoveFromCell(Weapon, Pickup.Cell);
+			AddToCell(Weapon, Cell);
+			Pickup.Cell = Cell;
+		}
+	}
+}
+
+void UBlasterInteractionSubsystem::ResolveInteractions()
+{
+	for (TActorIterator<ABlasterCharacter> It(GetWorld()); It; ++It)
+	{
+		AWeapon* Interactable = It->IsElimmed() ? nullptr : FindInteractable(*It);
+		if (It->GetOverlappingWeapon() != Interactable)
+		{
+			It->SetOverlappingWeapon(Interactable);
+		}
+	}
+}
+
+AWeapon* UBlasterInteractionSubsystem::FindInteractable(const ABlasterCharacter* BlasterCharacter) const
+{
+	if (BlasterCharacter == nullptr || Pickups.IsEmpty()) return nullptr;
+
+	const UCapsuleComponent* Capsule = BlasterCharacter->GetCapsuleComponent();
+	const FVector Center = BlasterCharacter->GetActorLocation();
+	const float CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	const float SegmentHalfHeight = Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+
+	const float Reach = MaxPickupRadius + CapsuleRadius;
+	const FIntPoint Min = CellFor(Center - FVector(Reach));
+	const FIntPoint Max = CellFor(Center + FVector(Reach));
+
+	AWeapon* Nearest = nullptr;
+	float NearestDistSquared = TNumericLimits<float>::Max();
+	for (int32 X = Min.X; X <= Max.X; ++X)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			const auto* CellPickups = Cells.Find(FIntPoint(X, Y));
+			if (CellPickups == nullptr) continue;
+
+			for (AWeapon* Candidate : *CellPickups)
+			{
+				const FPickup& Pickup = Pickups.FindChecked(Candidate);
+				if (!Pickup.Weapon.IsValid()) continue;
+
+				// Same test as a sphere overlapping the capsule, distance to the capsule's inner segment against both radii
+				const FVector OnSegment(Center.X, Center.Y, FMath::Clamp(Pickup.Location.Z, Center.Z - SegmentHalfHeight, Center.Z + SegmentHalfHeight));
+				const float DistSquared = FVector::DistSquared(Pickup.Location, OnSegment);
+				if (DistSquared > FMath::Square(Pickup.Radius + CapsuleRadius)) continue;
+
+				const bool bCloser = DistSquared < NearestDistSquared ||
+					(DistSquared == NearestDistSquared && Candidate->GetUniqueID() < Nearest->GetUniqueID());
+				if (bCloser)
+				{
+					Nearest = Candidate;
+					NearestDistSquared = DistSquared;
+				}
+			}
+		}
+	}
+	return Nearest;
+}
+
+AWeapon* UBlasterInteractionSubsystem::FindNearestPickup(const FVector& Location, float Radius) const
+{
+	if (Pickups.IsEmpty()) return nullptr;
+
+	const float RadiusSquared = FMath::Square(Radius);
+	AWeapon* Nearest = nullptr;
+	float NearestDistSquared = TNumericLimits<float>::Max();
+	auto Visit = [&](AWeapon* Candidate, const FPickup& Pickup)
+	{
+		if (!Pickup.Weapon.IsValid()) return;
+
+		const float DistSquared = FVector::DistSquared(Location, Pickup.Location);
+		if (DistSquared > RadiusSquared) return;
+
+		const bool bCloser = DistSquared < NearestDistSquared ||
+			(DistSquared == NearestDistSquared && Candidate->GetUniqueID() < Nearest->GetUniqueID());
+		if (bCloser)
+		{
+			Nearest = Candidate;
+			NearestDistSquared = DistSquared;
+		}
+	};
+
+	const FIntPoint Min = CellFor(Location - FVector(Radius));
+	const FIntPoint Max = CellFor(Location + FVector(Radius));
+	// A wide search covers more cells than there are pickups, then going through the pickups is cheaper
+	if (int64(Max.X - Min.X + 1) * int64(Max.Y - Min.Y + 1) > Pickups.Num())
+	{
+		for (const TPair<AWeapon*, FPickup>& Pair : Pickups)
+		{
+			Visit(Pair.Key, Pair.Value);
+		}
+		return Nearest;
+	}
+
+	for (int32 X = Min.X; X <= Max.X; ++X)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			if (const auto* CellPickups = Cells.Find(FIntPoint(X, Y)))
+			{
+				for (AWeapon* Candidate : *CellPickups)
+				{
+					Visit(Candidate, Pickups.FindChecked(Candidate));
+				}
+			}
+		}
+	}
+	return Nearest;
+}
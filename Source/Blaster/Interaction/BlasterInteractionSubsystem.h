@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BlasterInteractionSubsystem.generated.h"
+
+class ABlasterCharacter;
+class AWeapon;
+
+/**
+* Server side replacement for pickup overlap spheres. Pickups that are not equipped live in a uniform spatial hash,
+* and at a fixed rate every character gets the closest pickup in reach as its OverlappingWeapon.
+* Ties go to the pickup with the lower object id, so the choice between several weapons in reach is deterministic.
+* It is the one spatial index of pickups, bots look for weapons in it as well.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UBlasterInteractionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterPickup(AWeapon* Weapon);
+	void UnregisterPickup(AWeapon* Weapon);
+
+	// Closest registered pickup whose pickup radius touches the character's capsule
+	AWeapon* FindInteractable(const ABlasterCharacter* BlasterCharacter) const;
+	// Closest registered pickup within Radius of Location, as of the last update
+	AWeapon* FindNearestPickup(const FVector& Location, float Radius) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FPickup
+	{
+		TWeakObjectPtr<AWeapon> Weapon;
+		FVector Location = FVector::ZeroVector;
+		float Radius = 0.f;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+	};
+
+	FIntPoint CellFor(const FVector& Location) const;
+	void AddToCell(AWeapon* Weapon, const FIntPoint& Cell);
+	void RemoveFromCell(AWeapon* Weapon, const FIntPoint& Cell);
+	// Dropped weapons are simulated, moves the ones that rolled into another cell
+	void UpdatePickups();
+	void ResolveInteractions();
+
+	UPROPERTY(Config)
+	float UpdateInterval = 0.1f;
+
+	UPROPERTY(Config)
+	float CellSize = 500.f;
+
+	float TimeSinceUpdate = 0.f;
+
+	// Largest pickup radius registered, bounds how many cells a query has to look at
+	float MaxPickupRadius = 0.f;
+
+	// Keyed by address for identity only, Weapon tells whether the pickup is still alive
+	TMap<AWeapon*, FPickup> Pickups;
+	TMap<FIntPoint, TArray<AWeapon*, TInlineAllocator<4>>> Cells;
+};
@@ -0,0 +1,527 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterBenchmarkSubsystem.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/BlasterComponents/CombatComponent.h"
+#include "Blaster/GameMode/BlasterGameMode.h"
+#include "Blaster/PlayerController/BlasterPlayerController.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "Blaster/BlasterServerLean.h"
+#include "AIController.h"
+#include "GameFramework/PlayerStart.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectHash.h"
+
+namespace BenchmarkScenario
+{
+	const FName HUDSetterStorm(TEXT("HUDSetterStorm"));
+	const FName CharacterTick(TEXT("CharacterTick"));
+	const FName ProjectileFire(TEXT("ProjectileFire"));
+	const FName RespawnChurn(TEXT("RespawnChurn"));
+	const FName MatchPhaseCycle(TEXT("MatchPhaseCycle")); // Leaves the match in a different state, keep it last
+
+	const TArray<FName>& All()
+	{
+		static const TArray<FName> Scenarios = { HUDSetterStorm, CharacterTick, ProjectileFire, RespawnChurn, MatchPhaseCycle };
+		return Scenarios;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BlasterBenchmarkCommand(
+	TEXT("Blaster.Benchmark"),
+	TEXT("Runs the Blaster gameplay benchmarks in the current world. Blaster.Benchmark [Scenario,Scenario]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UBlasterBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UBlasterBenchmarkSubsystem>() : nullptr)
+		{
+			Benchmark->StartBenchmark(Args.IsValidIndex(0) ? Args[0] : FString(), false);
+		}
+	}));
+
+bool UBlasterBenchmarkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UBlasterBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBlasterBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void UBlasterBenchmarkSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client || !FParse::Param(FCommandLine::Get(), TEXT("BlasterBenchmark"))) return;
+
+	FString Scenarios;
+	FParse::Value(FCommandLine::Get(), TEXT("BlasterBenchmark="), Scenarios);
+	StartBenchmark(Scenarios, true);
+}
+
+void UBlasterBenchmarkSubsystem::StartBenchmark(const FString& Scenarios, bool bExitWhenDone)
+{
+	if (bRunning) return;
+
+	PendingScenarios.Reset();
+	TArray<FString> Requested;
+	Scenarios.ParseIntoArray(Requested, TEXT(","));
+	for (const FName& Scenario : BenchmarkScenario::All())
+	{
+		if (Requested.Num() == 0 || Requested.Contains(Scenario.ToString()))
+		{
+			PendingScenarios.Add(Scenario);
+		}
+	}
+
+	OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmark"), FString::Printf(TEXT("%s.json"), *FDateTime::Now().ToString()));
+	FParse::Value(FCommandLine::Get(), TEXT("BlasterBenchmarkOut="), OutputPath);
+	BaselinePath.Reset();
+	FParse::Value(FCommandLine::Get(), TEXT("BlasterBenchmarkBaseline="), BaselinePath);
+	FParse::Value(FCommandLine::Get(), TEXT("BlasterBenchmarkThreshold="), Threshold);
+
+	// A headless run should not have the match start or travel underneath it
+	ABlasterGameMode* BlasterGameMode = GetWorld()->GetAuthGameMode<ABlasterGameMode>();
+	if (bExitWhenDone && BlasterGameMode)
+	{
+		BlasterGameMode->WarmupTime = 1.e6f;
+	}
+
+	Results.Reset();
+	CurrentScenario = NAME_None;
+	bExitOnFinish = bExitWhenDone;
+	bRunning = true;
+}
+
+void UBlasterBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bRunning) return;
+
+	if (CurrentScenario.IsNone())
+	{
+		StartNextScenario();
+		return;
+	}
+
+	PhaseTime += DeltaTime;
+	if (bMeasuring)
+	{
+		FrameTimes.Add(DeltaTime * 1000.0);
+	}
+
+	const bool bDone = RunScenarioFrame(DeltaTime);
+	if (!bMeasuring && !bDone && PhaseTime >= WarmupSeconds)
+	{
+		bMeasuring = true;
+		PhaseTime = 0.f;
+		FrameTimes.Reset();
+		CallTimes.Reset();
+	}
+	else if (bDone || (bMeasuring && PhaseTime >= MeasureSeconds))
+	{
+		FinishScenario();
+	}
+}
+
+void UBlasterBenchmarkSubsystem::StartNextScenario()
+{
+	if (PendingScenarios.Num() == 0)
+	{
+		Finish();
+		return;
+	}
+
+	CurrentScenario = PendingScenarios[0];
+	PendingScenarios.RemoveAt(0);
+
+	bMeasuring = false;
+	bScenarioSkipped = false;
+	PhaseTime = 0.f;
+	FireAccumulator = 0.f;
+	NextRespawnIndex = 0;
+	FrameTimes.Reset();
+	CallTimes.Reset();
+
+	UE_LOG(LogTemp, Display, TEXT("Blaster benchmark: %s"), *CurrentScenario.ToString());
+	SetUpScenario();
+}
+
+FTransform UBlasterBenchmarkSubsystem::GetSpawnOrigin() const
+{
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		return It->GetActorTransform();
+	}
+	return FTransform::Identity;
+}
+
+ABlasterCharacter* UBlasterBenchmarkSubsystem::SpawnArmedCharacter(const FVector& Location)
+{
+	ABlasterGameMode* BlasterGameMode = GetWorld()->GetAuthGameMode<ABlasterGameMode>();
+	UClass* CharacterClass = BlasterGameMode ? BlasterGameMode->DefaultPawnClass.Get() : nullptr;
+	if (CharacterClass == nullptr || !CharacterClass->IsChildOf<ABlasterCharacter>()) return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	ABlasterCharacter* BlasterCharacter = GetWorld()->SpawnActor<ABlasterCharacter>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParams);
+	if (BlasterCharacter == nullptr) return nullptr;
+	SpawnedActors.Add(BlasterCharacter);
+
+	UClass* LoadedWeaponClass = WeaponClass.LoadSynchronous();
+	if (LoadedWeaponClass && BlasterCharacter->GetCombat())
+	{
+		AWeapon* Weapon = GetWorld()->SpawnActor<AWeapon>(LoadedWeaponClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (Weapon)
+		{
+			SpawnedActors.Add(Weapon);
+			BlasterCharacter->GetCombat()->EquipWeapon(Weapon);
+		}
+	}
+	return BlasterCharacter;
+}
+
+void UBlasterBenchmarkSubsystem::MeasureFootprint(FScenarioResult& Result) const
+{
+	int32 NumSpawnedCharacters = 0;
+	int64 NumObjects = 0;
+	int64 NumBytes = 0;
+	TArray<UObject*> Objects;
+	for (AActor* Actor : SpawnedActors)
+	{
+		if (!IsValid(Actor)) continue;
+		NumSpawnedCharacters += Actor->IsA<ABlasterCharacter>() ? 1 : 0;
+
+		Objects.Reset();
+		Objects.Add(Actor);
+		GetObjectsWithOuter(Actor, Objects, true);
+		for (UObject* Object : Objects)
+		{
+			FArchiveCountMem CountMem(Object);
+			NumBytes += Object->GetClass()->GetStructureSize() + CountMem.GetMax();
+		}
+		NumObjects += Objects.Num();
+	}
+	if (NumSpawnedCharacters == 0) return;
+
+	Result.Metrics.Add(TEXT("CharacterObjects"), double(NumObjects) / NumSpawnedCharacters);
+	Result.Metrics.Add(TEXT("CharacterKB"), double(NumBytes) / 1024.0 / NumSpawnedCharacters);
+}
+
+void UBlasterBenchmarkSubsystem::SetUpScenario()
+{
+	const FVector Origin = GetSpawnOrigin().GetLocation();
+
+	if (CurrentScenario == BenchmarkScenario::CharacterTick)
+	{
+		const int32 Columns = FMath::Max(FMath::CeilToInt(FMath::Sqrt(float(NumCharacters))), 1);
+		for (int32 i = 0; i < NumCharacters; ++i)
+		{
+			SpawnArmedCharacter(Origin + FVector((i % Columns) * 200.f, (i / Columns) * 200.f, 0.f));
+		}
+	}
+	else if (CurrentScenario == BenchmarkScenario::ProjectileFire)
+	{
+		ABlasterCharacter* Shooter = SpawnArmedCharacter(Origin);
+		if (Shooter && Shooter->GetEquippedWeapon())
+		{
+			FiringWeapons.Add(Shooter->GetEquippedWeapon());
+		}
+	}
+	else if (CurrentScenario == BenchmarkScenario::RespawnChurn)
+	{
+		ABlasterGameMode* BlasterGameMode = GetWorld()->GetAuthGameMode<ABlasterGameMode>();
+		if (BlasterGameMode == nullptr) return;
+
+		for (int32 i = 0; i < NumRespawnControllers; ++i)
+		{
+			AAIController* Controller = GetWorld()->SpawnActor<AAIController>(AAIController::StaticClass());
+			if (Controller == nullptr) continue;
+			SpawnedActors.Add(Controller);
+			RespawnControllers.Add(Controller);
+			BlasterGameMode->RestartPlayer(Controller);
+		}
+	}
+}
+
+bool UBlasterBenchmarkSubsystem::RunScenarioFrame(float DeltaTime)
+{
+	ABlasterGameMode* BlasterGameMode = GetWorld()->GetAuthGameMode<ABlasterGameMode>();
+
+	if (CurrentScenario == BenchmarkScenario::HUDSetterStorm)
+	{
+		ABlasterPlayerController* BlasterPlayerController = Cast<ABlasterPlayerController>(GetWorld()->GetFirstPlayerController());
+		if (BlasterPlayerController == nullptr || !BlasterPlayerController->IsLocalController())
+		{
+			bScenarioSkipped = true;
+			return true;
+		}
+
+		for (int32 i = 0; i < HUDSetterCallsPerFrame; ++i)
+		{
+			const double Start = FPlatformTime::Seconds();
+			BlasterPlayerController->SetHUDHealth(float(i % 100), 100.f);
+			BlasterPlayerController->SetHUDScore(float(i));
+			BlasterPlayerController->SetHUDDefeats(i);
+			BlasterPlayerController->SetHUDWeaponAmmo(i % 30);
+			BlasterPlayerController->SetHUDMatchCountdown(float(i));
+			CallTimes.Add((FPlatformTime::Seconds() - Start) * 1.e6 / 5.0);
+		}
+	}
+	else if (CurrentScenario == BenchmarkScenario::ProjectileFire)
+	{
+		if (FiringWeapons.Num() == 0)
+		{
+			bScenarioSkipped = true;
+			return true;
+		}
+
+		FireAccumulator += ProjectilesPerSecond * DeltaTime;
+		for (; FireAccumulator >= 1.f; FireAccumulator -= 1.f)
+		{
+			for (AWeapon* Weapon : FiringWeapons)
+			{
+				if (Weapon == nullptr) continue;
+				const FVector HitTarget = Weapon->GetActorLocation() + Weapon->GetActorForwardVector() * 10000.f;
+				const double Start = FPlatformTime::Seconds();
+				Weapon->Fire(HitTarget, uint16(FMath::Rand()));
+				CallTimes.Add((FPlatformTime::Seconds() - Start) * 1.e6);
+			}
+		}
+	}
+	else if (CurrentScenario == BenchmarkScenario::RespawnChurn)
+	{
+		if (BlasterGameMode == nullptr || RespawnControllers.Num() == 0)
+		{
+			bScenarioSkipped = true;
+			return true;
+		}
+
+		for (int32 i = 0; i < RespawnsPerFrame; ++i)
+		{
+			AAIController* Controller = RespawnControllers[NextRespawnIndex++ % RespawnControllers.Num()];
+			if (Controller == nullptr) continue;
+			const double Start = FPlatformTime::Seconds();
+			BlasterGameMode->RequestRespawn(Controller->GetCharacter(), Controller);
+			CallTimes.Add((FPlatformTime::Seconds() - Start) * 1.e6);
+		}
+	}
+	else if (CurrentScenario == BenchmarkScenario::MatchPhaseCycle)
+	{
+		if (BlasterGameMode == nullptr)
+		{
+			bScenarioSkipped = true;
+			return true;
+		}
+		if (!bMeasuring) return false;
+
+		// One cycle is the two transitions the match runs through after warmup, including OnMatchStateSet on every controller
+		BlasterGameMode->RunMatchPhaseCycles(MatchPhaseCycles, CallTimes);
+		return true;
+	}
+	return false;
+}
+
+void UBlasterBenchmarkSubsystem::FinishScenario()
+{
+	FScenarioResult& Result = Results.AddDefaulted_GetRef();
+	Result.Name = CurrentScenario.ToString();
+	Result.bSkipped = bScenarioSkipped;
+
+	if (!bScenarioSkipped)
+	{
+		FString CallMetric;
+		if (CurrentScenario == BenchmarkScenario::HUDSetterStorm)
+		{
+			Result.Params.Add(TEXT("CallsPerFrame"), HUDSetterCallsPerFrame * 5);
+			CallMetric = TEXT("Setter");
+		}
+		else if (CurrentScenario == BenchmarkScenario::CharacterTick)
+		{
+			Result.Params.Add(TEXT("Characters"), NumCharacters);
+			Result.Params.Add(TEXT("ServerLean"), BlasterServerLean::IsEnabled() ? 1.0 : 0.0);
+			MeasureFootprint(Result);
+		}
+		else if (CurrentScenario == BenchmarkScenario::ProjectileFire)
+		{
+			Result.Params.Add(TEXT("ProjectilesPerSecond"), ProjectilesPerSecond);
+			CallMetric = TEXT("Fire");
+		}
+		else if (CurrentScenario == BenchmarkScenario::RespawnChurn)
+		{
+			Result.Params.Add(TEXT("Controllers"), NumRespawnControllers);
+			Result.Params.Add(TEXT("RespawnsPerFrame"), RespawnsPerFrame);
+			CallMetric = TEXT("Respawn");
+		}
+		else if (CurrentScenario == BenchmarkScenario::MatchPhaseCycle)
+		{
+			Result.Params.Add(TEXT("Cycles"), MatchPhaseCycles);
+			CallMetric = TEXT("Cycle");
+		}
+
+		if (CurrentScenario != BenchmarkScenario::MatchPhaseCycle && FrameTimes.Num() > 0)
+		{
+			Result.Metrics.Add(TEXT("FrameMeanMs"), Mean(FrameTimes));
+			Result.Metrics.Add(TEXT("FrameP95Ms"), Percentile(FrameTimes, 0.95));
+		}
+		if (!CallMetric.IsEmpty() && CallTimes.Num() > 0)
+		{
+			Result.Metrics.Add(CallMetric + TEXT("MeanUs"), Mean(CallTimes));
+			Result.Metrics.Add(CallMetric + TEXT("P95Us"), Percentile(CallTimes, 0.95));
+		}
+	}
+
+	TearDownScenario();
+	CurrentScenario = NAME_None;
+}
+
+void UBlasterBenchmarkSubsystem::TearDownScenario()
+{
+	for (AAIController* Controller : RespawnControllers)
+	{
+		if (Controller && Controller->GetPawn())
+		{
+			Controller->GetPawn()->Destroy();
+		}
+	}
+	for (AActor* Actor : SpawnedActors)
+	{
+		if (IsValid(Actor))
+		{
+			Actor->Destroy();
+		}
+	}
+	SpawnedActors.Reset();
+	RespawnControllers.Reset();
+	FiringWeapons.Reset();
+}
+
+void UBlasterBenchmarkSubsystem::Finish()
+{
+	bRunning = false;
+
+	// Baseline metrics by scenario name
+	TMap<FString, TSharedPtr<FJsonObject>> BaselineMetrics;
+	if (!BaselinePath.IsEmpty())
+	{
+		FString BaselineText;
+		TSharedPtr<FJsonObject> Baseline;
+		if (FFileHelper::LoadFileToString(BaselineText, *BaselinePath) && FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline) && Baseline.IsValid())
+		{
+			const TArray<TSharedPtr<FJsonValue>>* BaselineScenarios = nullptr;
+			if (Baseline->TryGetArrayField(TEXT("Scenarios"), BaselineScenarios))
+			{
+				for (const TSharedPtr<FJsonValue>& Value : *BaselineScenarios)
+				{
+					const TSharedPtr<FJsonObject>* Scenario = nullptr;
+					const TSharedPtr<FJsonObject>* Metrics = nullptr;
+					if (Value->TryGetObject(Scenario) && (*Scenario)->TryGetObjectField(TEXT("Metrics"), Metrics))
+					{
+						BaselineMetrics.Add((*Scenario)->GetStringField(TEXT("Name")), *Metrics);
+					}
+				}
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Blaster benchmark: could not read baseline %s"), *BaselinePath);
+		}
+	}
+
+	bool bPassed = true;
+	TArray<TSharedPtr<FJsonValue>> ScenarioValues;
+	for (const FScenarioResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> Scenario = MakeShared<FJsonObject>();
+		Scenario->SetStringField(TEXT("Name"), Result.Name);
+		Scenario->SetBoolField(TEXT("Skipped"), Result.bSkipped);
+
+		TSharedRef<FJsonObject> Params = MakeShared<FJsonObject>();
+		for (const TPair<FString, double>& Param : Result.Params)
+		{
+			Params->SetNumberField(Param.Key, Param.Value);
+		}
+		Scenario->SetObjectField(TEXT("Params"), Params);
+
+		TSharedRef<FJsonObject> Metrics = MakeShared<FJsonObject>();
+		TSharedRef<FJsonObject> Changes = MakeShared<FJsonObject>();
+		TArray<TSharedPtr<FJsonValue>> Regressions;
+		const TSharedPtr<FJsonObject>* Baseline = BaselineMetrics.Find(Result.Name);
+		for (const TPair<FString, double>& Metric : Result.Metrics)
+		{
+			Metrics->SetNumberField(Metric.Key, Metric.Value);
+
+			double BaselineValue = 0.0;
+			if (Baseline && (*Baseline)->TryGetNumberField(Metric.Key, BaselineValue) && BaselineValue > 0.0)
+			{
+				const double Change = Metric.Value / BaselineValue - 1.0;
+				Changes->SetNumberField(Metric.Key, Change);
+				if (Change > Threshold)
+				{
+					Regressions.Add(MakeShared<FJsonValueString>(Metric.Key));
+					UE_LOG(LogTemp, Error, TEXT("Blaster benchmark: %s %s regressed by %.1f%% (%.3f -> %.3f)"), *Result.Name, *Metric.Key, Change * 100.0, BaselineValue, Metric.Value);
+				}
+			}
+		}
+		Scenario->SetObjectField(TEXT("Metrics"), Metrics);
+		if (Baseline)
+		{
+			Scenario->SetObjectField(TEXT("Baseline"), *Baseline);
+			Scenario->SetObjectField(TEXT("Change"), Changes);
+			Scenario->SetArrayField(TEXT("Regressions"), Regressions);
+		}
+		bPassed &= Regressions.Num() == 0;
+
+		ScenarioValues.Add(MakeShared<FJsonValueObject>(Scenario));
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("Version"), 1);
+	Root->SetStringField(TEXT("Map"), GetWorld()->GetMapName());
+	Root->SetStringField(TEXT("BuildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	Root->SetStringField(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+	Root->SetStringField(TEXT("Baseline"), BaselinePath);
+	Root->SetNumberField(TEXT("Threshold"), Threshold);
+	Root->SetBoolField(TEXT("Passed"), bPassed);
+	Root->SetArrayField(TEXT("Scenarios"), ScenarioValues);
+
+	FString Output;
+	FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&Output));
+	FFileHelper::SaveStringToFile(Output, *OutputPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+	UE_LOG(LogTemp, Display, TEXT("Blaster benchmark: %s, results in %s"), bPassed ? TEXT("passed") : TEXT("regressed"), *OutputPath);
+
+	if (bExitOnFinish)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+	}
+}
+
+double UBlasterBenchmarkSubsystem::Mean(const TArray<double>& Samples)
+{
+	if (Samples.Num() == 0) return 0.0;
+	double Sum = 0.0;
+	for (double Sample : Samples)
+	{
+		Sum += Sample;
+	}
+	return Sum / Samples.Num();
+}
+
+double UBlasterBenchmarkSubsystem::Percentile(TArray<double> Samples, double Fraction)
+{
+	if (Samples.Num() == 0) return 0.0;
+	Samples.Sort();
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Samples.Num()) - 1, 0, Samples.Num() - 1);
+	return Samples[Index];
+}
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BlasterBenchmarkSubsystem.generated.h"
+
+class ABlasterCharacter;
+class ABlasterGameMode;
+class AWeapon;
+class AAIController;
+
+/**
+* Fixed gameplay micro-benchmarks, run headless in a standalone game:
+*   -BlasterBenchmark[=Scenario,Scenario]   run all or the listed scenarios, write JSON and exit
+*   -BlasterBenchmarkOut=File               result file (default Saved/Benchmark/<timestamp>.json)
+*   -BlasterBenchmarkBaseline=File          earlier result to compare against
+*   -BlasterBenchmarkThreshold=0.1          allowed slowdown per metric before it counts as a regression
+* The process exits with 1 when any metric regressed past the threshold. Blaster.Benchmark [Scenarios] runs in place.
+* Scenarios: HUDSetterStorm, CharacterTick, ProjectileFire, RespawnChurn, MatchPhaseCycle.
+* CharacterTick also reports objects and memory per armed character, run it on a dedicated server with and without
+* -NoServerLean to see what server lean mode saves.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UBlasterBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void StartBenchmark(const FString& Scenarios, bool bExitWhenDone);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FScenarioResult
+	{
+		FString Name;
+		bool bSkipped = false;
+		TMap<FString, double> Params;
+		TMap<FString, double> Metrics; // All metrics are costs, lower is better
+	};
+
+	void StartNextScenario();
+	void SetUpScenario();
+	// Does the per frame work of the running scenario, returns true when the scenario finished early
+	bool RunScenarioFrame(float DeltaTime);
+	void FinishScenario();
+	void TearDownScenario();
+	void Finish();
+
+	ABlasterCharacter* SpawnArmedCharacter(const FVector& Location);
+	// Objects and bytes of the spawned actors and everything they own, per character
+	void MeasureFootprint(FScenarioResult& Result) const;
+	FTransform GetSpawnOrigin() const;
+
+	static double Mean(const TArray<double>& Samples);
+	static double Percentile(TArray<double> Samples, double Fraction);
+
+	UPROPERTY(Config)
+	TSoftClassPtr<AWeapon> WeaponClass;
+
+	UPROPERTY(Config)
+	float WarmupSeconds = 1.f;
+
+	UPROPERTY(Config)
+	float MeasureSeconds = 5.f;
+
+	UPROPERTY(Config)
+	int32 NumCharacters = 32;
+
+	UPROPERTY(Config)
+	float ProjectilesPerSecond = 200.f;
+
+	UPROPERTY(Config)
+	int32 NumRespawnControllers = 8;
+
+	UPROPERTY(Config)
+	int32 RespawnsPerFrame = 4;
+
+	UPROPERTY(Config)
+	int32 HUDSetterCallsPerFrame = 100;
+
+	UPROPERTY(Config)
+	int32 MatchPhaseCycles = 20;
+
+	UPROPERTY()
+	TArray<AActor*> SpawnedActors;
+
+	UPROPERTY()
+	TArray<AAIController*> RespawnControllers;
+
+	UPROPERTY()
+	TArray<AWeapon*> FiringWeapons;
+
+	FString OutputPath;
+	FString BaselinePath;
+	float Threshold = 0.1f;
+
+	TArray<FName> PendingScenarios;
+	FName CurrentScenario;
+	TArray<FScenarioResult> Results;
+
+	bool bRunning = false;
+	bool bExitOnFinish = false;
+	bool bMeasuring = false;
+	bool bScenarioSkipped = false;
+	float PhaseTime = 0.f;
+	float FireAccumulator = 0.f;
+	int32 NextRespawnIndex = 0;
+
+	// Samples of the running scenario, frame times in ms and call times in microseconds
+	TArray<double> FrameTimes;
+	TArray<double> CallTimes;
+};
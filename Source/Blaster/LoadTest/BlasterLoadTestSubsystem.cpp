@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterLoadTestSubsystem.h"
+#include "Blaster/GameMode/BlasterGameMode.h"
+#include "Blaster/NetStats/BlasterNetStatsSubsystem.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/PlayerState.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "Misc/CoreDelegates.h"
+
+bool UBlasterLoadTestSubsystem::IsLoadTestRequested()
+{
+	static const bool bRequested = FParse::Param(FCommandLine::Get(), TEXT("BlasterLoadTest"));
+	return bRequested;
+}
+
+bool UBlasterLoadTestSubsystem::ShouldAutoPlay()
+{
+	static const bool bAutoPlay = FParse::Param(FCommandLine::Get(), TEXT("BlasterAutoPlay"));
+	return bAutoPlay;
+}
+
+void UBlasterLoadTestSubsystem::NoteRpc(const UObject* WorldContextObject, FName RpcName)
+{
+	if (!IsLoadTestRequested() || WorldContextObject == nullptr) return;
+
+	UWorld* World = WorldContextObject->GetWorld();
+	if (World == nullptr || World->GetNetMode() == NM_Client) return;
+
+	if (UBlasterLoadTestSubsystem* LoadTest = World->GetSubsystem<UBlasterLoadTestSubsystem>())
+	{
+		++LoadTest->RpcCounts.FindOrAdd(RpcName);
+	}
+}
+
+bool UBlasterLoadTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return IsLoadTestRequested() && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UBlasterLoadTestSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBlasterLoadTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FParse::Value(FCommandLine::Get(), TEXT("BlasterLoadTestWindow="), WindowLength);
+	FParse::Value(FCommandLine::Get(), TEXT("BlasterLoadTestDuration="), Duration);
+	WindowLength = FMath::Max(WindowLength, 0.1f);
+
+	OutputDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LoadTest"), FDateTime::Now().ToString());
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &ThisClass::OnWorldTickStart);
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ThisClass::OnPostActorTick);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddUObject(this, &ThisClass::OnEndFrame);
+	PostTickFlushHandle = GetWorld()->OnPostTickFlush().AddUObject(this, &ThisClass::OnPostTickFlush);
+}
+
+void UBlasterLoadTestSubsystem::Deinitialize()
+{
+	FlushWindow();
+
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	if (UWorld* World = GetWorld())
+	{
+		World->OnPostTickFlush().Remove(PostTickFlushHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+void UBlasterLoadTestSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client) return;
+
+	WriteHeaders();
+
+	int32 NumBots = 0;
+	FParse::Value(FCommandLine::Get(), TEXT("BlasterBots="), NumBots);
+	SpawnBots(NumBots);
+}
+
+void UBlasterLoadTestSubsystem::SpawnBots(int32 NumBots)
+{
+	UWorld* World = GetWorld();
+	ABlasterGameMode* BlasterGameMode = World ? World->GetAuthGameMode<ABlasterGameMode>() : nullptr;
+	if (BlasterGameMode == nullptr) return;
+
+	// Server side bots are the regular combat bots, so the load matches a real match with bots
+	BlasterGameMode->AddBots(NumBots);
+	NumBotsSpawned = BlasterGameMode->GetNumBotControllers();
+}
+
+void UBlasterLoadTestSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (GetWorld()->GetNetMode() == NM_Client) return;
+
+	FrameTimes.Add(DeltaTime * 1000.f);
+
+	WindowRunningTime += DeltaTime;
+	TotalRunningTime += DeltaTime;
+	if (WindowRunningTime >= WindowLength)
+	{
+		FlushWindow();
+		WindowRunningTime = 0.f;
+	}
+
+	if (Duration > 0.f && TotalRunningTime >= Duration)
+	{
+		FlushWindow();
+		Duration = 0.f;
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+TStatId UBlasterLoadTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBlasterLoadTestSubsystem, STATGROUP_Tickables);
+}
+
+void UBlasterLoadTestSubsystem::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		FrameWorkStart = FPlatformTime::Seconds();
+	}
+}
+
+void UBlasterLoadTestSubsystem::OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		ReplicationStart = FPlatformTime::Seconds();
+	}
+}
+
+void UBlasterLoadTestSubsystem::OnPostTickFlush()
+{
+	if (ReplicationStart > 0.0)
+	{
+		ReplicationTimes.Add((FPlatformTime::Seconds() - ReplicationStart) * 1000.0);
+		ReplicationStart = 0.0;
+	}
+}
+
+void UBlasterLoadTestSubsystem::OnEndFrame()
+{
+	if (FrameWorkStart > 0.0)
+	{
+		FrameWorkTimes.Add((FPlatformTime::Seconds() - FrameWorkStart) * 1000.0);
+		FrameWorkStart = 0.0;
+	}
+}
+
+float UBlasterLoadTestSubsystem::Percentile(TArray<float>& Samples, float Fraction)
+{
+	if (Samples.Num() == 0) return 0.f;
+	Samples.Sort();
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Samples.Num()) - 1, 0, Samples.Num() - 1);
+	return Samples[Index];
+}
+
+void UBlasterLoadTestSubsystem::WriteHeaders()
+{
+	AppendToFile(TEXT("frames.csv"), TEXT("Time,Players,Bots,Frames,FrameP50Ms,FrameP95Ms,FrameP99Ms,FrameMaxMs,WorkP50Ms,WorkP99Ms,ReplicationP50Ms,ReplicationP99Ms\n"));
+	AppendToFile(TEXT("connections.csv"), TEXT("Time,Connection,Player,InBytesPerSec,OutBytesPerSec,PingMs\n"));
+	AppendToFile(TEXT("rpcs.csv"), TEXT("Time,Rpc,Calls\n"));
+}
+
+void UBlasterLoadTestSubsystem::FlushWindow()
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr || World->GetNetMode() == NM_Client || FrameTimes.Num() == 0) return;
+
+	const float Now = World->GetTimeSeconds();
+	const int32 NumPlayers = World->GetNumPlayerControllers();
+
+	const float FrameMax = FMath::Max(FrameTimes);
+	AppendToFile(TEXT("frames.csv"), FString::Printf(TEXT("%.2f,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"),
+		Now,
+		NumPlayers,
+		NumBotsSpawned,
+		FrameTimes.Num(),
+		Percentile(FrameTimes, 0.5f),
+		Percentile(FrameTimes, 0.95f),
+		Percentile(FrameTimes, 0.99f),
+		FrameMax,
+		Percentile(FrameWorkTimes, 0.5f),
+		Percentile(FrameWorkTimes, 0.99f),
+		Percentile(ReplicationTimes, 0.5f),
+		Percentile(ReplicationTimes, 0.99f)
+	));
+
+	if (UNetDriver* NetDriver = World->GetNetDriver())
+	{
+		FString ConnectionLines;
+		for (UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			if (Connection == nullptr) continue;
+			APlayerController* PlayerController = Connection->PlayerController;
+			APlayerState* PlayerState = PlayerController ? PlayerController->PlayerState : nullptr;
+			ConnectionLines += FString::Printf(TEXT("%.2f,%s,%s,%d,%d,%.1f\n"),
+				Now,
+				*Connection->LowLevelGetRemoteAddress(true),
+				PlayerState ? *PlayerState->GetPlayerName() : TEXT(""),
+				Connection->InBytesPerSecond,
+				Connection->OutBytesPerSecond,
+				PlayerState ? PlayerState->GetPingInMilliseconds() : 0.f
+			);
+		}
+		AppendToFile(TEXT("connections.csv"), ConnectionLines);
+	}
+
+	FString RpcLines;
+	for (const TPair<FName, int32>& Rpc : RpcCounts)
+	{
+		RpcLines += FString::Printf(TEXT("%.2f,%s,%d\n"), Now, *Rpc.Key.ToString(), Rpc.Value);
+	}
+	AppendToFile(TEXT("rpcs.csv"), RpcLines);
+
+	// Byte counts per RPC, property and class over the net stats rolling window, rewritten every window
+	if (UBlasterNetStatsSubsystem* NetStats = World->GetSubsystem<UBlasterNetStatsSubsystem>())
+	{
+		NetStats->WriteCsv(FPaths::Combine(OutputDirectory, TEXT("netstats.csv")));
+	}
+
+	FrameTimes.Reset();
+	FrameWorkTimes.Reset();
+	ReplicationTimes.Reset();
+	RpcCounts.Reset();
+}
+
+void UBlasterLoadTestSubsystem::AppendToFile(const FString& FileName, const FString& Text) const
+{
+	if (Text.IsEmpty()) return;
+	FFileHelper::SaveStringToFile(Text, *FPaths::Combine(OutputDirectory, FileName), FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append);
+}
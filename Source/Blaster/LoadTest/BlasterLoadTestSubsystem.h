@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BlasterLoadTestSubsystem.generated.h"
+
+// Counts an RPC in the running load test, call from the RPC body on the server or from the call site of a client RPC
+#define BLASTER_COUNT_RPC(RpcName) \
+	{ \
+		static const FName RpcFName(TEXT(#RpcName)); \
+		UBlasterLoadTestSubsystem::NoteRpc(this, RpcFName); \
+	}
+
+/**
+* Server side load test recorder. Enabled with -BlasterLoadTest on the command line:
+*   -BlasterBots=N                 spawn N server side bots driving ABlasterCharacter's input paths
+*   -BlasterLoadTestWindow=Seconds length of one sampling window (default 1)
+*   -BlasterLoadTestDuration=Secs  exit once the test ran this long (default 0, run until closed)
+* Headless clients launched with -BlasterAutoPlay drive their own character the same way.
+* Results are written as CSV to Saved/LoadTest/<timestamp>/, including UBlasterNetStatsSubsystem's netstats.csv.
+*/
+UCLASS()
+class BLASTER_API UBlasterLoadTestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static bool IsLoadTestRequested();
+	static bool ShouldAutoPlay();
+	static void NoteRpc(const UObject* WorldContextObject, FName RpcName);
+
+protected:
+	bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void SpawnBots(int32 NumBots);
+	void FlushWindow();
+	void WriteHeaders();
+	void AppendToFile(const FString& FileName, const FString& Text) const;
+
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnPostTickFlush();
+	void OnEndFrame();
+
+	static float Percentile(TArray<float>& Samples, float Fraction);
+
+	FString OutputDirectory;
+	float WindowLength = 1.f;
+	float Duration = 0.f;
+	float WindowRunningTime = 0.f;
+	float TotalRunningTime = 0.f;
+	int32 NumBotsSpawned = 0;
+
+	double FrameWorkStart = 0.0;
+	double ReplicationStart = 0.0;
+
+	// Samples of the current window, in milliseconds
+	TArray<float> FrameTimes;
+	TArray<float> FrameWorkTimes;
+	TArray<float> ReplicationTimes;
+
+	TMap<FName, int32> RpcCounts;
+
+	FDelegateHandle WorldTickStartHandle;
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostTickFlushHandle;
+	FDelegateHandle EndFrameHandle;
+};
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LoadTestBotComponent.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "InputActionValue.h"
+#include "GameFramework/Controller.h"
+
+ULoadTestBotComponent::ULoadTestBotComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+void ULoadTestBotComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	RandomStream.Initialize(GetTypeHash(GetOwner()->GetName()));
+	ThinkCountdown = RandomStream.FRandRange(0.f, ThinkInterval);
+}
+
+ABlasterCharacter* ULoadTestBotComponent::GetBlasterCharacter() const
+{
+	AController* Controller = Cast<AController>(GetOwner());
+	return Controller ? Cast<ABlasterCharacter>(Controller->GetPawn()) : nullptr;
+}
+
+void ULoadTestBotComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	ABlasterCharacter* BlasterCharacter = GetBlasterCharacter();
+	if (BlasterCharacter == nullptr || BlasterCharacter->IsElimmed())
+	{
+		bFiring = false;
+		return;
+	}
+
+	ThinkCountdown -= DeltaTime;
+	if (ThinkCountdown <= 0.f)
+	{
+		Think(BlasterCharacter);
+		ThinkCountdown = ThinkInterval;
+	}
+
+	BlasterCharacter->Move_Input(FInputActionValue(MoveInput));
+
+	const FVector2D LookDelta = LookInput * LookRate * DeltaTime;
+	AController* Controller = BlasterCharacter->GetController();
+	if (Controller && Controller->IsLocalPlayerController())
+	{
+		BlasterCharacter->Look_Input(FInputActionValue(LookDelta));
+	}
+	else if (Controller)
+	{
+		// Controller yaw/pitch input only reaches player controllers, rotate the control rotation directly instead
+		FRotator ControlRotation = Controller->GetControlRotation();
+		ControlRotation.Yaw += LookDelta.X;
+		ControlRotation.Pitch = FMath::ClampAngle(ControlRotation.Pitch - LookDelta.Y, -60.f, 60.f);
+		Controller->SetControlRotation(ControlRotation);
+	}
+}
+
+void ULoadTestBotComponent::Think(ABlasterCharacter* BlasterCharacter)
+{
+	// Pick up whatever we are standing on
+	if (!BlasterCharacter->IsWeaponEquipped() && BlasterCharacter->GetOverlappingWeapon())
+	{
+		BlasterCharacter->Equip_Input(FInputActionValue());
+	}
+
+	MoveInput = RandomStream.FRand() < 0.2f ? FVector2D::ZeroVector : FVector2D(RandomStream.FRandRange(-1.f, 1.f), RandomStream.FRandRange(-1.f, 1.f));
+	LookInput = FVector2D(RandomStream.FRandRange(-1.f, 1.f), RandomStream.FRandRange(-0.2f, 0.2f));
+
+	if (RandomStream.FRand() < 0.05f)
+	{
+		BlasterCharacter->Jump();
+	}
+
+	AWeapon* EquippedWeapon = BlasterCharacter->GetEquippedWeapon();
+	if (EquippedWeapon == nullptr) return;
+
+	if (RandomStream.FRand() < 0.1f)
+	{
+		bAiming = !bAiming;
+		bAiming ? BlasterCharacter->Aim_Input() : BlasterCharacter->UnAim_Input();
+	}
+
+	if (EquippedWeapon->IsEmpty() && BlasterCharacter->GetCombatState() != ECombatState::ECS_Reloading)
+	{
+		BlasterCharacter->Reload_Input();
+	}
+	else if (RandomStream.FRand() < 0.4f)
+	{
+		bFiring = !bFiring;
+		bFiring ? BlasterCharacter->StartFire_Input() : BlasterCharacter->EndFire_Input();
+	}
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "LoadTestBotComponent.generated.h"
+
+class ABlasterCharacter;
+
+/**
+* Attached to a controller, drives the possessed ABlasterCharacter through the same input functions a player uses.
+* Behaviour is random on purpose, it only has to generate realistic traffic and CPU load.
+*/
+UCLASS(ClassGroup = (Custom))
+class BLASTER_API ULoadTestBotComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULoadTestBotComponent();
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	ABlasterCharacter* GetBlasterCharacter() const;
+	void Think(ABlasterCharacter* BlasterCharacter);
+
+	FRandomStream RandomStream;
+
+	// Seconds until the next decision
+	float ThinkCountdown = 0.f;
+
+	UPROPERTY(EditAnywhere, Category = "Load Test")
+	float ThinkInterval = 0.5f;
+
+	UPROPERTY(EditAnywhere, Category = "Load Test")
+	float LookRate = 45.f;
+
+	FVector2D MoveInput = FVector2D::ZeroVector;
+	FVector2D LookInput = FVector2D::ZeroVector;
+	bool bFiring = false;
+	bool bAiming = false;
+};
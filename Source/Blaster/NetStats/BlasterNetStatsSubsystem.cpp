@@ -0,0 +1,498 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterNetStatsSubsystem.h"
+#include "Blaster/LoadTest/BlasterLoadTestSubsystem.h"
+#include "Blaster/BlasterStats.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetworkObjectList.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "Net/UnrealNetwork.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarBlasterNetStats(
+	TEXT("Blaster.NetStats"),
+	0,
+	TEXT("Counts replicated bytes per RPC, property, actor class and connection (see Blaster.NetStats.Dump)."));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice BlasterNetStatsDumpCommand(
+	TEXT("Blaster.NetStats.Dump"),
+	TEXT("Logs bytes/s and calls/s over the rolling window. Blaster.NetStats.Dump [rpc|property|class|connection|all] [Rows]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UBlasterNetStatsSubsystem* NetStats = World ? World->GetSubsystem<UBlasterNetStatsSubsystem>() : nullptr;
+		if (NetStats == nullptr) return;
+		NetStats->Dump(Args.IsValidIndex(0) ? Args[0] : TEXT("all"), Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 20, Ar);
+	}));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice BlasterNetStatsCsvCommand(
+	TEXT("Blaster.NetStats.Csv"),
+	TEXT("Writes the rolling window to CSV. Blaster.NetStats.Csv [File]"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UBlasterNetStatsSubsystem* NetStats = World ? World->GetSubsystem<UBlasterNetStatsSubsystem>() : nullptr;
+		if (NetStats == nullptr) return;
+		const FString FilePath = Args.IsValidIndex(0) ? Args[0] : FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("NetStats"), FString::Printf(TEXT("NetStats-%s.csv"), *FDateTime::Now().ToString()));
+		if (NetStats->WriteCsv(FilePath))
+		{
+			Ar.Logf(TEXT("Wrote %s"), *FilePath);
+		}
+	}));
+
+bool UBlasterNetStatsPackageMap::SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID)
+{
+	// Stands in for the NetGUID, which is written as a packed int as well
+	uint32 Id = Obj ? Obj->GetUniqueID() : 0;
+	Ar.SerializeIntPacked(Id);
+	return true;
+}
+
+bool UBlasterNetStatsSubsystem::IsEnabled()
+{
+	static const bool bRequested = FParse::Param(FCommandLine::Get(), TEXT("BlasterNetStats")) || UBlasterLoadTestSubsystem::IsLoadTestRequested();
+	return bRequested || CVarBlasterNetStats.GetValueOnGameThread() > 0;
+}
+
+bool UBlasterNetStatsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBlasterNetStatsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	EstimatePackageMap = NewObject<UBlasterNetStatsPackageMap>(this);
+	WindowLength = FMath::Max(WindowLength, 0.1f);
+	Windows.SetNum(FMath::Max(NumWindows, 1));
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ThisClass::OnPostActorTick);
+}
+
+void UBlasterNetStatsSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+#if !UE_BUILD_SHIPPING
+	UNetDriver* NetDriver = BoundNetDriver.Get();
+	if (NetDriver && NetDriver->SendRPCDel.IsBoundToObject(this))
+	{
+		NetDriver->SendRPCDel.Unbind();
+	}
+#endif
+
+	Super::Deinitialize();
+}
+
+TStatId UBlasterNetStatsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBlasterNetStatsSubsystem, STATGROUP_Tickables);
+}
+
+void UBlasterNetStatsSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!IsEnabled()) return;
+
+	BindNetDriver();
+
+	WindowRunningTime += DeltaTime;
+	if (WindowRunningTime >= WindowLength)
+	{
+		RollWindow();
+	}
+}
+
+void UBlasterNetStatsSubsystem::BindNetDriver()
+{
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (NetDriver == nullptr || NetDriver == BoundNetDriver.Get()) return;
+
+#if !UE_BUILD_SHIPPING
+	// The delegate is single cast, leave it alone if something else already uses it
+	if (!NetDriver->SendRPCDel.IsBound())
+	{
+		NetDriver->SendRPCDel.BindUObject(this, &ThisClass::OnSendRpc);
+	}
+#endif
+	BoundNetDriver = NetDriver;
+}
+
+const TArray<UBlasterNetStatsSubsystem::FTrackedProperty>& UBlasterNetStatsSubsystem::GetTrackedProperties(UClass* Class)
+{
+	if (const TArray<FTrackedProperty>* Found = ClassProperties.Find(Class))
+	{
+		return *Found;
+	}
+
+	TArray<FTrackedProperty>& Tracked = ClassProperties.Add(Class);
+	Class->SetUpRuntimeReplicationData();
+
+	TArray<FLifetimeProperty> LifetimeProps;
+	Class->GetDefaultObject()->GetLifetimeReplicatedProps(LifetimeProps);
+	for (const FLifetimeProperty& LifetimeProp : LifetimeProps)
+	{
+		if (LifetimeProp.Condition == COND_Never || !Class->ClassReps.IsValidIndex(LifetimeProp.RepIndex)) continue;
+
+		const FRepRecord& Record = Class->ClassReps[LifetimeProp.RepIndex];
+		FTrackedProperty& Entry = Tracked.AddDefaulted_GetRef();
+		Entry.Property = Record.Property;
+		Entry.ArrayIndex = Record.Index;
+		Entry.Condition = LifetimeProp.Condition;
+		Entry.Name = FName(FString::Printf(TEXT("%s.%s"), *Record.Property->GetOwnerClass()->GetName(), *Record.Property->GetName()));
+	}
+	return Tracked;
+}
+
+void UBlasterNetStatsSubsystem::OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld() || !IsEnabled()) return;
+
+	UNetDriver* NetDriver = InWorld->GetNetDriver();
+	if (NetDriver == nullptr || !NetDriver->IsServer() || NetDriver->ClientConnections.Num() == 0) return;
+
+	// Same due check the net driver runs when it builds its consider list right after this
+	const double Now = InWorld->GetTimeSeconds();
+	for (const TSharedPtr<FNetworkObjectInfo>& ObjectInfo : NetDriver->GetNetworkObjectList().GetActiveObjects())
+	{
+		AActor* Actor = ObjectInfo->Actor;
+		if (Actor == nullptr || ObjectInfo->NextUpdateTime > Now) continue;
+		AccountActor(Actor, NetDriver);
+	}
+}
+
+void UBlasterNetStatsSubsystem::AccountActor(AActor* Actor, UNetDriver* NetDriver)
+{
+	BLASTER_SCOPE(NetStats);
+	LLM_SCOPE_BYTAG(Blaster_Replication);
+
+	const FName ClassName = Actor->GetClass()->GetFName();
+	AccountObject(Actor, Actor, ClassName, NetDriver);
+	Actor->ForEachComponent(false, [&](UActorComponent* Component)
+	{
+		if (Component->GetIsReplicated())
+		{
+			AccountObject(Component, Actor, ClassName, NetDriver);
+		}
+	});
+}
+
+void UBlasterNetStatsSubsystem::AccountObject(UObject* Object, AActor* Actor, FName ClassName, UNetDriver* NetDriver)
+{
+	const TArray<FTrackedProperty>& Tracked = GetTrackedProperties(Object->GetClass());
+	if (Tracked.Num() == 0) return;
+
+	TArray<uint32>& Shadow = Shadows.FindOrAdd(TObjectKey<UObject>(Object));
+	const bool bInitial = Shadow.Num() == 0;
+	if (bInitial)
+	{
+		Shadow.SetNumZeroed(Tracked.Num());
+	}
+
+	TArray<UNetConnection*, TInlineAllocator<32>> Receivers;
+	for (int32 i = 0; i < Tracked.Num(); ++i)
+	{
+		const FTrackedProperty& Entry = Tracked[i];
+		uint32 Hash = 0;
+		const int64 Bits = SerializeForEstimate(Entry.Property, Entry.Property->ContainerPtrToValuePtr<void>(Object, Entry.ArrayIndex), Hash);
+		if (!bInitial && Hash == Shadow[i]) continue;
+
+		Shadow[i] = Hash;
+		if (Entry.Condition == COND_InitialOnly && !bInitial) continue;
+
+		GetReceivingConnections(Actor, Entry.Condition, NetDriver, Receivers);
+		for (UNetConnection* Connection : Receivers)
+		{
+			Add(EBlasterNetStatKind::Property, Entry.Name, ClassName, Connection, Bits);
+		}
+	}
+}
+
+void UBlasterNetStatsSubsystem::GetReceivingConnections(AActor* Actor, ELifetimeCondition Condition, UNetDriver* NetDriver, TArray<UNetConnection*, TInlineAllocator<32>>& OutConnections) const
+{
+	OutConnections.Reset();
+	if (Condition == COND_ReplayOnly) return;
+
+	const UNetConnection* OwnerConnection = Actor->GetNetConnection();
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (Connection == nullptr || Connection->FindActorChannelRef(Actor) == nullptr) continue;
+
+		const bool bIsOwner = Connection == OwnerConnection;
+		switch (Condition)
+		{
+		case COND_OwnerOnly:
+		case COND_AutonomousOnly:
+		case COND_ReplayOrOwner:
+			if (!bIsOwner) continue;
+			break;
+		case COND_SkipOwner:
+		case COND_SimulatedOnly:
+		case COND_SimulatedOnlyNoReplay:
+		case COND_SimulatedOrPhysics:
+		case COND_SimulatedOrPhysicsNoReplay:
+			if (bIsOwner) continue;
+			break;
+		default:
+			break;
+		}
+		OutConnections.Add(Connection);
+	}
+}
+
+int64 UBlasterNetStatsSubsystem::SerializeForEstimate(const FProperty* Property, const void* Data, uint32& OutHash) const
+{
+	FNetBitWriter Writer(EstimatePackageMap, 256);
+	WriteForEstimate(Writer, Property, Data);
+	OutHash = FCrc::MemCrc32(Writer.GetData(), Writer.GetNumBytes());
+	return Writer.GetNumBits();
+}
+
+void UBlasterNetStatsSubsystem::WriteForEstimate(FNetBitWriter& Writer, const FProperty* Property, const void* Data) const
+{
+	// Structs without a native NetSerialize and arrays are replicated field by field, NetSerializeItem does not handle them
+	if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+	{
+		if (!(StructProperty->Struct->StructFlags & STRUCT_NetSerializeNative))
+		{
+			for (TFieldIterator<FProperty> It(StructProperty->Struct); It; ++It)
+			{
+				if (It->PropertyFlags & CPF_RepSkip) continue;
+				for (int32 i = 0; i < It->ArrayDim; ++i)
+				{
+					WriteForEstimate(Writer, *It, It->ContainerPtrToValuePtr<void>(Data, i));
+				}
+			}
+			return;
+		}
+	}
+	else if (const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property))
+	{
+		FScriptArrayHelper ArrayHelper(ArrayProperty, Data);
+		uint32 Num = ArrayHelper.Num();
+		Writer.SerializeIntPacked(Num);
+		for (int32 i = 0; i < ArrayHelper.Num(); ++i)
+		{
+			WriteForEstimate(Writer, ArrayProperty->Inner, ArrayHelper.GetRawPtr(i));
+		}
+		return;
+	}
+
+	Property->NetSerializeItem(Writer, EstimatePackageMap, const_cast<void*>(Data));
+}
+
+#if !UE_BUILD_SHIPPING
+void UBlasterNetStatsSubsystem::OnSendRpc(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject, bool& bBlockSendRpc)
+{
+	BLASTER_SCOPE(NetStats);
+	LLM_SCOPE_BYTAG(Blaster_Replication);
+
+	UNetDriver* NetDriver = BoundNetDriver.Get();
+	if (!IsEnabled() || NetDriver == nullptr || Actor == nullptr || Function == nullptr) return;
+
+	const FName* RpcName = RpcNames.Find(Function);
+	if (RpcName == nullptr)
+	{
+		RpcName = &RpcNames.Add(Function, FName(FString::Printf(TEXT("%s.%s"), *Function->GetOwnerClass()->GetName(), *Function->GetName())));
+	}
+
+	FNetBitWriter Writer(EstimatePackageMap, 256);
+	if (Parameters)
+	{
+		for (TFieldIterator<FProperty> It(Function); It && (It->PropertyFlags & (CPF_Parm | CPF_ReturnParm)) == CPF_Parm; ++It)
+		{
+			for (int32 i = 0; i < It->ArrayDim; ++i)
+			{
+				WriteForEstimate(Writer, *It, It->ContainerPtrToValuePtr<void>(Parameters, i));
+			}
+		}
+	}
+
+	const FName ClassName = Actor->GetClass()->GetFName();
+	if (Function->FunctionFlags & FUNC_NetMulticast)
+	{
+		if (!NetDriver->IsServer()) return;
+
+		TArray<UNetConnection*, TInlineAllocator<32>> Receivers;
+		GetReceivingConnections(Actor, COND_None, NetDriver, Receivers);
+		for (UNetConnection* Connection : Receivers)
+		{
+			Add(EBlasterNetStatKind::Rpc, *RpcName, ClassName, Connection, Writer.GetNumBits());
+		}
+	}
+	else
+	{
+		Add(EBlasterNetStatKind::Rpc, *RpcName, ClassName, Actor->GetNetConnection(), Writer.GetNumBits());
+	}
+}
+#endif
+
+void UBlasterNetStatsSubsystem::Add(EBlasterNetStatKind Kind, FName Name, FName ClassName, UNetConnection* Connection, int64 Bits)
+{
+	if (Connection == nullptr) return;
+
+	FBlasterNetStatKey Key;
+	Key.Kind = Kind;
+	Key.Name = Name;
+	Key.ClassName = ClassName;
+	Key.Connection = GetConnectionLabel(Connection);
+
+	FBlasterNetStatCounter& Counter = Windows[CurrentWindow].FindOrAdd(Key);
+	++Counter.Calls;
+	Counter.Bits += Bits;
+}
+
+FName UBlasterNetStatsSubsystem::GetConnectionLabel(UNetConnection* Connection)
+{
+	const TObjectKey<UNetConnection> ConnectionKey(Connection);
+	if (const FName* Found = ConnectionLabels.Find(ConnectionKey))
+	{
+		return *Found;
+	}
+
+	FString Label = Connection->LowLevelGetRemoteAddress(true);
+	APlayerController* PlayerController = Connection->PlayerController;
+	if (PlayerController && PlayerController->PlayerState)
+	{
+		Label = FString::Printf(TEXT("%s (%s)"), *PlayerController->PlayerState->GetPlayerName(), *Label);
+	}
+	return ConnectionLabels.Add(ConnectionKey, FName(Label));
+}
+
+void UBlasterNetStatsSubsystem::RollWindow()
+{
+#if COUNTERSTRACE_ENABLED
+	TMap<FName, int64> BitsByName;
+	for (const TPair<FBlasterNetStatKey, FBlasterNetStatCounter>& Stat : Windows[CurrentWindow])
+	{
+		BitsByName.FindOrAdd(Stat.Key.Name) += Stat.Value.Bits;
+	}
+	for (const TPair<FName, int64>& Stat : BitsByName)
+	{
+		TUniquePtr<FCountersTrace::FCounterInt>& Counter = TraceCounters.FindOrAdd(Stat.Key);
+		if (!Counter)
+		{
+			Counter = MakeUnique<FCountersTrace::FCounterInt>(*FString::Printf(TEXT("Blaster/Net/%s"), *Stat.Key.ToString()), TraceCounterDisplayHint_Memory);
+		}
+	}
+	for (const TPair<FName, TUniquePtr<FCountersTrace::FCounterInt>>& Counter : TraceCounters)
+	{
+		const int64* Bits = BitsByName.Find(Counter.Key);
+		Counter.Value->Set(Bits ? int64(*Bits / 8 / WindowRunningTime) : 0);
+	}
+#endif
+
+	CurrentWindow = (CurrentWindow + 1) % Windows.Num();
+	Windows[CurrentWindow].Reset();
+	NumFilledWindows = FMath::Min(NumFilledWindows + 1, Windows.Num());
+	WindowRunningTime = 0.f;
+
+	// Player names arrive after the connection, and stale objects should not keep their shadows around
+	ConnectionLabels.Reset();
+	for (auto It = Shadows.CreateIterator(); It; ++It)
+	{
+		if (It.Key().ResolveObjectPtr() == nullptr)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+float UBlasterNetStatsSubsystem::GetCoveredSeconds() const
+{
+	// Once all windows were used the current one has replaced the oldest
+	return FMath::Min(NumFilledWindows, Windows.Num() - 1) * WindowLength + WindowRunningTime;
+}
+
+void UBlasterNetStatsSubsystem::Aggregate(TMap<FBlasterNetStatKey, FBlasterNetStatCounter>& OutTotals) const
+{
+	for (const TMap<FBlasterNetStatKey, FBlasterNetStatCounter>& Window : Windows)
+	{
+		for (const TPair<FBlasterNetStatKey, FBlasterNetStatCounter>& Stat : Window)
+		{
+			FBlasterNetStatCounter& Total = OutTotals.FindOrAdd(Stat.Key);
+			Total.Calls += Stat.Value.Calls;
+			Total.Bits += Stat.Value.Bits;
+		}
+	}
+}
+
+void UBlasterNetStatsSubsystem::Dump(const FString& GroupBy, int32 NumRows, FOutputDevice& Ar) const
+{
+	TMap<FBlasterNetStatKey, FBlasterNetStatCounter> Totals;
+	Aggregate(Totals);
+
+	TMap<FString, FBlasterNetStatCounter> Groups;
+	for (const TPair<FBlasterNetStatKey, FBlasterNetStatCounter>& Stat : Totals)
+	{
+		const FBlasterNetStatKey& Key = Stat.Key;
+		FString GroupName;
+		if (GroupBy == TEXT("rpc"))
+		{
+			if (Key.Kind != EBlasterNetStatKind::Rpc) continue;
+			GroupName = Key.Name.ToString();
+		}
+		else if (GroupBy == TEXT("property"))
+		{
+			if (Key.Kind != EBlasterNetStatKind::Property) continue;
+			GroupName = Key.Name.ToString();
+		}
+		else if (GroupBy == TEXT("class"))
+		{
+			GroupName = Key.ClassName.ToString();
+		}
+		else if (GroupBy == TEXT("connection"))
+		{
+			GroupName = Key.Connection.ToString();
+		}
+		else
+		{
+			GroupName = FString::Printf(TEXT("%s %s on %s -> %s"), Key.Kind == EBlasterNetStatKind::Rpc ? TEXT("RPC") : TEXT("Property"), *Key.Name.ToString(), *Key.ClassName.ToString(), *Key.Connection.ToString());
+		}
+
+		FBlasterNetStatCounter& Group = Groups.FindOrAdd(GroupName);
+		Group.Calls += Stat.Value.Calls;
+		Group.Bits += Stat.Value.Bits;
+	}
+	Groups.ValueSort([](const FBlasterNetStatCounter& A, const FBlasterNetStatCounter& B) { return A.Bits > B.Bits; });
+
+	const float Seconds = FMath::Max(GetCoveredSeconds(), KINDA_SMALL_NUMBER);
+	Ar.Logf(TEXT("Blaster net stats over the last %.1fs, by %s"), Seconds, *GroupBy);
+	Ar.Logf(TEXT("%12s %10s  %s"), TEXT("Bytes/s"), TEXT("Calls/s"), TEXT("Name"));
+
+	int32 Row = 0;
+	for (const TPair<FString, FBlasterNetStatCounter>& Group : Groups)
+	{
+		if (NumRows > 0 && Row++ >= NumRows) break;
+		Ar.Logf(TEXT("%12.1f %10.1f  %s"), Group.Value.Bits / 8.f / Seconds, Group.Value.Calls / Seconds, *Group.Key);
+	}
+}
+
+bool UBlasterNetStatsSubsystem::WriteCsv(const FString& FilePath) const
+{
+	TMap<FBlasterNetStatKey, FBlasterNetStatCounter> Totals;
+	Aggregate(Totals);
+
+	const float Seconds = FMath::Max(GetCoveredSeconds(), KINDA_SMALL_NUMBER);
+	FString Csv = TEXT("Kind,Name,Class,Connection,Calls,Bytes,CallsPerSec,BytesPerSec\n");
+	for (const TPair<FBlasterNetStatKey, FBlasterNetStatCounter>& Stat : Totals)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%s,%s,%lld,%lld,%.2f,%.2f\n"),
+			Stat.Key.Kind == EBlasterNetStatKind::Rpc ? TEXT("Rpc") : TEXT("Property"),
+			*Stat.Key.Name.ToString(),
+			*Stat.Key.ClassName.ToString(),
+			*Stat.Key.Connection.ToString(),
+			Stat.Value.Calls,
+			(Stat.Value.Bits + 7) / 8,
+			Stat.Value.Calls / Seconds,
+			Stat.Value.Bits / 8.f / Seconds
+		);
+	}
+	return FFileHelper::SaveStringToFile(Csv, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
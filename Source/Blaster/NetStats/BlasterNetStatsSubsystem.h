@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/CoreNet.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "BlasterNetStatsSubsystem.generated.h"
+
+class UNetConnection;
+class UNetDriver;
+struct FOutParmRec;
+struct FFrame;
+
+enum class EBlasterNetStatKind : uint8
+{
+	Rpc,
+	Property
+};
+
+struct FBlasterNetStatKey
+{
+	EBlasterNetStatKind Kind = EBlasterNetStatKind::Rpc;
+	FName Name; // Owner.Function or Owner.Property
+	FName ClassName; // Class of the replicating actor
+	FName Connection;
+
+	bool operator==(const FBlasterNetStatKey& Other) const
+	{
+		return Kind == Other.Kind && Name == Other.Name && ClassName == Other.ClassName && Connection == Other.Connection;
+	}
+
+	friend uint32 GetTypeHash(const FBlasterNetStatKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.Name), GetTypeHash(Key.ClassName)), HashCombine(GetTypeHash(Key.Connection), uint32(Key.Kind)));
+	}
+};
+
+struct FBlasterNetStatCounter
+{
+	int64 Calls = 0;
+	int64 Bits = 0;
+};
+
+/**
+* Package map used only to size object references, writes a packed id instead of touching a connection's real NetGUID state
+*/
+UCLASS(Transient)
+class BLASTER_API UBlasterNetStatsPackageMap : public UPackageMap
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID = nullptr) override;
+};
+
+/**
+* Counts replicated payload per RPC, per replicated property and per actor class, per connection, over a rolling window.
+* Enabled with the Blaster.NetStats console variable, -BlasterNetStats, or automatically during a load test.
+*   Blaster.NetStats.Dump [rpc|property|class|connection|all] [Rows]  log bytes/s and calls/s over the window
+*   Blaster.NetStats.Csv [File]                                      write the window to CSV (default Saved/NetStats/)
+* Totals per RPC and property are also published as Unreal Insights counters under Blaster/Net/.
+*
+* Sizes are the serialized payload of parameters and changed properties, bunch headers and acks are not included.
+* RPCs are measured where they are sent, properties on the server when an actor is due for a net update.
+* RPCs are not counted in Shipping builds.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UBlasterNetStatsSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static bool IsEnabled();
+
+	void Dump(const FString& GroupBy, int32 NumRows, FOutputDevice& Ar) const;
+	bool WriteCsv(const FString& FilePath) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FTrackedProperty
+	{
+		FProperty* Property = nullptr;
+		int32 ArrayIndex = 0;
+		ELifetimeCondition Condition = COND_None;
+		FName Name;
+	};
+
+	const TArray<FTrackedProperty>& GetTrackedProperties(UClass* Class);
+	void BindNetDriver();
+	void OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+#if !UE_BUILD_SHIPPING
+	// UNetDriver only offers SendRPCDel outside Shipping
+	void OnSendRpc(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject, bool& bBlockSendRpc);
+#endif
+
+	void AccountActor(AActor* Actor, UNetDriver* NetDriver);
+	void AccountObject(UObject* Object, AActor* Actor, FName ClassName, UNetDriver* NetDriver);
+	void GetReceivingConnections(AActor* Actor, ELifetimeCondition Condition, UNetDriver* NetDriver, TArray<UNetConnection*, TInlineAllocator<32>>& OutConnections) const;
+	// Returns the serialized size in bits, OutHash identifies the value for change detection
+	int64 SerializeForEstimate(const FProperty* Property, const void* Data, uint32& OutHash) const;
+	void WriteForEstimate(FNetBitWriter& Writer, const FProperty* Property, const void* Data) const;
+
+	void Add(EBlasterNetStatKind Kind, FName Name, FName ClassName, UNetConnection* Connection, int64 Bits);
+	FName GetConnectionLabel(UNetConnection* Connection);
+	void RollWindow();
+	void Aggregate(TMap<FBlasterNetStatKey, FBlasterNetStatCounter>& OutTotals) const;
+	float GetCoveredSeconds() const;
+
+	UPROPERTY(Config)
+	float WindowLength = 1.f;
+
+	// Number of windows kept, the rolling window is WindowLength * NumWindows seconds long
+	UPROPERTY(Config)
+	int32 NumWindows = 10;
+
+	UPROPERTY()
+	UBlasterNetStatsPackageMap* EstimatePackageMap = nullptr;
+
+	TWeakObjectPtr<UNetDriver> BoundNetDriver;
+	FDelegateHandle PostActorTickHandle;
+
+	TArray<TMap<FBlasterNetStatKey, FBlasterNetStatCounter>> Windows;
+	int32 CurrentWindow = 0;
+	int32 NumFilledWindows = 0;
+	float WindowRunningTime = 0.f;
+
+	TMap<UClass*, TArray<FTrackedProperty>> ClassProperties;
+	TMap<UFunction*, FName> RpcNames;
+	TMap<TObjectKey<UNetConnection>, FName> ConnectionLabels;
+
+	// Hash of each tracked property's serialized value at the object's last net update
+	TMap<TObjectKey<UObject>, TArray<uint32>> Shadows;
+
+#if COUNTERSTRACE_ENABLED
+	TMap<FName, TUniquePtr<FCountersTrace::FCounterInt>> TraceCounters;
+#endif
+};
@@ -14,13 +14,23 @@
 #include "Blaster/HUD/Announcment.h"
 #include "Kismet/GameplayStatics.h"
 #include "Blaster/GameState/BlasterGameState.h"
+#include "Blaster/Weapon/Weapon.h"
+#include "Blaster/LoadTest/BlasterLoadTestSubsystem.h"
+#include "Blaster/LoadTest/LoadTestBotComponent.h"
+#include "Blaster/Cosmetics/BlasterCosmeticsSubsystem.h"
+#include "Blaster/BlasterStats.h"
 
 void ABlasterPlayerController::BeginPlay()
 {
 	Super::BeginPlay();
 
 	BlasterHUD = Cast<ABlasterHUD>(GetHUD());
-	ServerCheckMatchState();
+
+	if (IsLocalController() && UBlasterLoadTestSubsystem::ShouldAutoPlay())
+	{
+		ULoadTestBotComponent* BotComponent = NewObject<ULoadTestBotComponent>(this);
+		BotComponent->RegisterComponent();
+	}
 }
 
 void ABlasterPlayerController::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
@@ -49,37 +59,68 @@ void ABlasterPlayerController::Tick(float DeltaTime)
 	PollInit();
 }
 
-void ABlasterPlayerController::ServerCheckMatchState_Implementation()
+void ABlasterPlayerController::ServerCheckMatchState_Implementation(float TimeOfClientRequest)
 {
+	BLASTER_COUNT_RPC(ServerCheckMatchState);
 	ABlasterGameMode* GameMode = Cast<ABlasterGameMode>(UGameplayStatics::GetGameMode(this));
 	if (GameMode)
 	{
-		WarmupTime = GameMode->WarmupTime;
-		MatchTime = GameMode->MatchTime;
-		CooldownTime = GameMode->CooldownTime;
-		LevelStartingTime = GameMode->LevelStartingTime;
-		MatchState = GameMode->GetMatchState();
-		ClientJoinMidgame(MatchState, WarmupTime, MatchTime, CooldownTime, LevelStartingTime);
+		FBlasterMatchSnapshot Snapshot;
+		GameMode->BuildMatchSnapshot(this, TimeOfClientRequest, Snapshot);
+		MatchState = Snapshot.MatchState;
+		BLASTER_COUNT_RPC(ClientJoinMidgame);
+		ClientJoinMidgame(Snapshot);
 	}
 }
 
-void ABlasterPlayerController::ClientJoinMidgame_Implementation(FName StateOfMatch, float Warmup, float Match, float Cooldown, float StartingTime)
+void ABlasterPlayerController::ClientJoinMidgame_Implementation(const FBlasterMatchSnapshot& Snapshot)
 {
-	WarmupTime = Warmup;
-	MatchTime = Match;
-	CooldownTime = Cooldown;
-	LevelStartingTime = StartingTime;
-	MatchState = StateOfMatch;
-	OnMatchStateSet(MatchState);
+	if (!HasAuthority())
+	{
+		const float RoundTripTime = GetWorld()->GetTimeSeconds() - Snapshot.ClientRequestTime;
+		const float CurrentServerTime = Snapshot.ServerTime + (0.5f * RoundTripTime);
+		ClientServerDelta = CurrentServerTime - GetWorld()->GetTimeSeconds();
+		TimeSyncRunningTime = 0.f;
+	}
+
+	WarmupTime = Snapshot.WarmupTime;
+	MatchTime = Snapshot.MatchTime;
+	CooldownTime = Snapshot.CooldownTime;
+	LevelStartingTime = Snapshot.GetLevelStartingTime();
+	OnMatchStateSet(Snapshot.MatchState);
+
+	BlasterHUD = BlasterHUD == nullptr ? Cast<ABlasterHUD>(GetHUD()) : BlasterHUD;
 	if (BlasterHUD && MatchState == MatchState::WaitingToStart)
 	{
 		BlasterHUD->AddAnnouncment();
 	}
+
+	if (Snapshot.bHasRequester)
+	{
+		const FSnapshotPlayerEntry& Entry = Snapshot.Requester;
+		SetHUDScore(Entry.Score);
+		SetHUDDefeats(Entry.Defeats);
+		if (Entry.EquippedWeapon)
+		{
+			SetHUDWeaponAmmo(Entry.Ammo);
+		}
+	}
+
+	for (const FSnapshotWeaponEntry& Entry : Snapshot.DroppedWeapons)
+	{
+		// Weapons that have not replicated yet will arrive with up to date state on their own
+		if (Entry.Weapon)
+		{
+			Entry.Weapon->ApplySnapshotState(Entry.WeaponState, Entry.Location, Entry.bDormant);
+		}
+	}
 }
 
 
 void ABlasterPlayerController::SetHUDMatchCountdown(float CountdownTime)
 {
+	BLASTER_SCOPE(HUDUpdate);
+
 	BlasterHUD = BlasterHUD == nullptr ? Cast<ABlasterHUD>(GetHUD()) : BlasterHUD;
 	bool bHUDValid = BlasterHUD &&
 		BlasterHUD->CharacterOverlay &&
@@ -134,6 +175,8 @@ void ABlasterPlayerController::CheckTimeSync(float DeltaTime)
 
 void ABlasterPlayerController::SetHUDHealth(float Health, float MaxHealth)
 {
+	BLASTER_SCOPE(HUDUpdate);
+
 	BlasterHUD = BlasterHUD == nullptr ? Cast<ABlasterHUD>(GetHUD()) : BlasterHUD;
 
 	bool bHUDValid = BlasterHUD &&
@@ -157,6 +200,8 @@ void ABlasterPlayerController::SetHUDHealth(float Health, float MaxHealth)
 
 void ABlasterPlayerController::SetHUDAnnouncmentCountdown(float CountdownTime)
 {
+	BLASTER_SCOPE(HUDUpdate);
+
 	BlasterHUD = BlasterHUD == nullptr ? Cast<ABlasterHUD>(GetHUD()) : BlasterHUD;
 	bool bHUDValid = BlasterHUD &&
 		BlasterHUD->Announcment &&
@@ -180,6 +225,8 @@ void ABlasterPlayerController::SetHUDAnnouncmentCountdown(float CountdownTime)
 
 void ABlasterPlayerController::SetHUDScore(float Score)
 {
+	BLASTER_SCOPE(HUDUpdate);
+
 	BlasterHUD = BlasterHUD == nullptr ? Cast<ABlasterHUD>(GetHUD()) : BlasterHUD;
 	bool bHUDValid = BlasterHUD &&
 		BlasterHUD->CharacterOverlay &&
@@ -198,6 +245,8 @@ void ABlasterPlayerController::SetHUDScore(float Score)
 
 void ABlasterPlayerController::SetHUDDefeats(int32 Defeats)
 {
+	BLASTER_SCOPE(HUDUpdate);
+
 	BlasterHUD = BlasterHUD == nullptr ? Cast<ABlasterHUD>(GetHUD()) : BlasterHUD;
 	bool bHUDValid = BlasterHUD &&
 		BlasterHUD->CharacterOverlay &&
@@ -216,6 +265,8 @@ void ABlasterPlayerController::SetHUDDefeats(int32 Defeats)
 
 void ABlasterPlayerController::SetHUDWeaponAmmo(int32 Ammo)
 {
+	BLASTER_SCOPE(HUDUpdate);
+
 	BlasterHUD = BlasterHUD == nullptr ? Cast<ABlasterHUD>(GetHUD()) : BlasterHUD;
 	bool bHUDValid = BlasterHUD &&
 		BlasterHUD->CharacterOverlay &&
@@ -225,11 +276,18 @@ void ABlasterPlayerController::SetHUDWeaponAmmo(int32 Ammo)
 		FString AmmoText = FString::Printf(TEXT("%d"), Ammo);
 		BlasterHUD->CharacterOverlay->WeaponAmmoAmount->SetText(FText::FromString(AmmoText));
 	}
+	else
+	{
+		bInitializeWeaponAmmo = true;
+		HUDWeaponAmmo = Ammo;
+	}
 }
 
 void ABlasterPlayerController::ServerRequestServerTime_Implementation(float TimeOfClientRequest)
 {
+	BLASTER_COUNT_RPC(ServerRequestServerTime);
 	float ServerTimeOfReceipt = GetWorld()->GetTimeSeconds();
+	BLASTER_COUNT_RPC(ClientReportServerTime);
 	ClientReportServerTime(TimeOfClientRequest, ServerTimeOfReceipt);
 }
 
@@ -240,6 +298,14 @@ void ABlasterPlayerController::ClientReportServerTime_Implementation(float TimeO
 	ClientServerDelta = CurrentServerTime - GetWorld()->GetTimeSeconds();
 }
 
+void ABlasterPlayerController::ClientCosmeticEvents_Implementation(const TArray<FCosmeticEvent>& Events)
+{
+	if (UBlasterCosmeticsSubsystem* Cosmetics = GetWorld()->GetSubsystem<UBlasterCosmeticsSubsystem>())
+	{
+		Cosmetics->PlayEvents(Events);
+	}
+}
+
 float ABlasterPlayerController::GetServerTime()
 {
 	if (HasAuthority()) return GetWorld()->GetTimeSeconds();
@@ -251,7 +317,7 @@ void ABlasterPlayerController::ReceivedPlayer()
 	Super::ReceivedPlayer();
 	if (IsLocalController())
 	{
-		ServerRequestServerTime(GetWorld()->GetTimeSeconds());
+		ServerCheckMatchState(GetWorld()->GetTimeSeconds());
 	}
 }
 
@@ -267,6 +333,11 @@ void ABlasterPlayerController::PollInit()
 				SetHUDHealth(HUDHealth, HUDMaxHealth);
 				SetHUDScore(HUDScore);
 				SetHUDDefeats(HUDDefeats);
+				if (bInitializeWeaponAmmo)
+				{
+					SetHUDWeaponAmmo(HUDWeaponAmmo);
+					bInitializeWeaponAmmo = false;
+				}
 			}
 		}
 	}
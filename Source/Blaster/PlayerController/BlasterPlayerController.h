@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "Blaster/BlasterTypes/MatchSnapshot.h"
+#include "Blaster/BlasterTypes/CosmeticEvent.h"
 #include "BlasterPlayerController.generated.h"
 
 /**
@@ -22,8 +24,12 @@ public:
 	void SetHUDWeaponAmmo(int32 Ammo);
 	void SetHUDMatchCountdown(float CountdownTime);
 	virtual float GetServerTime(); // Synced with server world clock
-	virtual void ReceivedPlayer() override; // Sync with server clock as soon as possible
+	virtual void ReceivedPlayer() override; // Request the match snapshot, which also syncs the clock, as soon as possible
 	void OnMatchStateSet(FName State);
+
+	// Fire and hit reacts this player could notice, see UBlasterCosmeticsSubsystem
+	UFUNCTION(Client, Unreliable)
+	void ClientCosmeticEvents(const TArray<FCosmeticEvent>& Events);
 protected:
 	virtual void BeginPlay() override;
 	virtual void OnPossess(APawn* InPawn) override;
@@ -52,10 +58,11 @@ protected:
 	void CheckTimeSync(float DeltaTime);
 
 	UFUNCTION(Server, Reliable)
-	void ServerCheckMatchState();
+	void ServerCheckMatchState(float TimeOfClientRequest);
 
+	// Answers ServerCheckMatchState with everything needed to bring the HUD up to date in one step
 	UFUNCTION(Client, Reliable)
-	void ClientJoinMidgame(FName StateOfMatch, float Warmup, float Match, float Cooldown, float StartingTime);
+	void ClientJoinMidgame(const FBlasterMatchSnapshot& Snapshot);
 	void HandleCooldown();
 private:
 	UPROPERTY()
@@ -81,4 +88,6 @@ private:
 	float HUDMaxHealth;
 	float HUDScore;
 	int32 HUDDefeats;
+	int32 HUDWeaponAmmo = 0;
+	bool bInitializeWeaponAmmo = false;
 };
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "BlasterPlayerState.h"
 #include "Blaster/Character/BlasterCharacter.h"
 #include "Blaster/PlayerController/BlasterPlayerController.h"
+#include "Blaster/Travel/BlasterTravelSubsystem.h"
 #include "Net/UnrealNetwork.h"
 
 void ABlasterPlayerState::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >& OutLifetimeProps) const
@@ -14,6 +15,44 @@ void ABlasterPlayerState::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
 	DOREPLIFETIME(ABlasterPlayerState, Defeats);
+	// Lobby only, server replays record matches
+	DOREPLIFETIME_CONDITION(ABlasterPlayerState, bLobbyReady, COND_SkipReplay);
+}
+
+void ABlasterPlayerState::ServerSetLobbyReady_Implementation(bool bReady)
+{
+	bLobbyReady = bReady;
+}
+
+void ABlasterPlayerState::ClientPreloadMap_Implementation(const FString& MapPath)
+{
+	UBlasterTravelSubsystem* Travel = GetGameInstance() ? GetGameInstance()->GetSubsystem<UBlasterTravelSubsystem>() : nullptr;
+	if (Travel == nullptr)
+	{
+		ServerSetLobbyReady(true);
+		return;
+	}
+
+	PreloadingMap = Travel->PreloadMap(MapPath);
+	if (PreloadingMap.IsNone() || Travel->IsMapPreloaded(MapPath))
+	{
+		ServerSetLobbyReady(true);
+		return;
+	}
+	Travel->OnMapPreloaded.AddUObject(this, &ABlasterPlayerState::OnMapPreloaded);
+}
+
+void ABlasterPlayerState::OnMapPreloaded(FName PackageName, bool bSuccess)
+{
+	if (PackageName != PreloadingMap) return;
+
+	// A failed preload has nothing left to wait for, the travel loads the map as it would have without preloading
+	PreloadingMap = NAME_None;
+	if (UBlasterTravelSubsystem* Travel = GetGameInstance() ? GetGameInstance()->GetSubsystem<UBlasterTravelSubsystem>() : nullptr)
+	{
+		Travel->OnMapPreloaded.RemoveAll(this);
+	}
+	ServerSetLobbyReady(true);
 }
 
 void ABlasterPlayerState::AddToScore(float ScoreAmount)
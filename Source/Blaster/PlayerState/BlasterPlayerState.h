@@ -26,7 +26,24 @@ public:
 
 	void AddToScore(float ScoreAmount);
 	void AddToDefeats(int32 DefeatsAmount);
+	FORCEINLINE int32 GetDefeats() const { return Defeats; }
+
+	/**
+	* Lobby
+	*/
+	// A player is ready once the match map finished streaming in, or could not be
+	UFUNCTION(Server, Reliable)
+	void ServerSetLobbyReady(bool bReady);
+
+	// Streams the match map in while the player waits in the lobby and reports ready when it is done
+	UFUNCTION(Client, Reliable)
+	void ClientPreloadMap(const FString& MapPath);
+
+	FORCEINLINE bool IsLobbyReady() const { return bLobbyReady; }
 private:
+	void OnMapPreloaded(FName PackageName, bool bSuccess);
+
+
 	UPROPERTY()
 	class ABlasterCharacter* Character;
 	UPROPERTY()
@@ -34,4 +51,9 @@ private:
 
 	UPROPERTY(ReplicatedUsing = OnRep_Defeats)
 	int32 Defeats;
+
+	UPROPERTY(Replicated)
+	bool bLobbyReady = false;
+
+	FName PreloadingMap;
 };
\ No newline at end of file
@@ -0,0 +1,283 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterReplayRecorder.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Compression.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Paths.h"
+#include "Tasks/Task.h"
+#include "Blaster/BlasterStats.h"
+
+static TAutoConsoleVariable<bool> CVarBlasterReplayRecord(
+	TEXT("Blaster.Replay.Record"),
+	false,
+	TEXT("Records server replays of the configured maps, takes effect at the next match."));
+
+namespace
+{
+	// Compressed segment: magic, then blocks of up to BlockSize raw bytes, each prefixed with its raw and compressed size
+	constexpr uint32 CompressedMagic = 0x42525A31; // BRZ1
+	constexpr int32 BlockSize = 4 * 1024 * 1024;
+
+	void SetConsoleVariable(const TCHAR* Name, float Value)
+	{
+		if (IConsoleVariable* Variable = IConsoleManager::Get().FindConsoleVariable(Name))
+		{
+			Variable->Set(Value, ECVF_SetByCode);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Replay: %s does not exist in this engine, its setting is ignored"), Name);
+		}
+	}
+
+	// Writes Target through a temporary file so a partial file is never mistaken for a finished one
+	bool TransformFile(const FString& SourcePath, const FString& TargetPath, TFunctionRef<bool(FArchive&, FArchive&)> Transform)
+	{
+		const FString TempPath = TargetPath + TEXT(".tmp");
+		bool bSuccess = false;
+		{
+			TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*SourcePath));
+			TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempPath));
+			if (Reader && Writer)
+			{
+				bSuccess = Transform(*Reader, *Writer) && !Reader->IsError();
+				bSuccess = Writer->Close() && bSuccess;
+			}
+		}
+		if (!bSuccess || !IFileManager::Get().Move(*TargetPath, *TempPath))
+		{
+			IFileManager::Get().Delete(*TempPath);
+			return false;
+		}
+		return true;
+	}
+
+	bool CompressBlocks(FArchive& Reader, FArchive& Writer)
+	{
+		uint32 Magic = CompressedMagic;
+		Writer << Magic;
+
+		TArray<uint8> Raw;
+		TArray<uint8> Compressed;
+		while (Reader.Tell() < Reader.TotalSize())
+		{
+			int32 RawSize = int32(FMath::Min<int64>(BlockSize, Reader.TotalSize() - Reader.Tell()));
+			Raw.SetNumUninitialized(RawSize);
+			Reader.Serialize(Raw.GetData(), RawSize);
+
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Oodle, RawSize);
+			Compressed.SetNumUninitialized(CompressedSize);
+			if (!FCompression::CompressMemory(NAME_Oodle, Compressed.GetData(), CompressedSize, Raw.GetData(), RawSize)) return false;
+
+			Writer << RawSize << CompressedSize;
+			Writer.Serialize(Compressed.GetData(), CompressedSize);
+		}
+		return !Writer.IsError();
+	}
+
+	bool DecompressBlocks(FArchive& Reader, FArchive& Writer)
+	{
+		uint32 Magic = 0;
+		Reader << Magic;
+		if (Magic != CompressedMagic) return false;
+
+		TArray<uint8> Raw;
+		TArray<uint8> Compressed;
+		while (Reader.Tell() < Reader.TotalSize())
+		{
+			int32 RawSize = 0;
+			int32 CompressedSize = 0;
+			Reader << RawSize << CompressedSize;
+			if (RawSize <= 0 || RawSize > BlockSize || CompressedSize <= 0 || Reader.IsError()) return false;
+
+			Compressed.SetNumUninitialized(CompressedSize);
+			Reader.Serialize(Compressed.GetData(), CompressedSize);
+			Raw.SetNumUninitialized(RawSize);
+			if (!FCompression::UncompressMemory(NAME_Oodle, Raw.GetData(), RawSize, Compressed.GetData(), CompressedSize)) return false;
+			Writer.Serialize(Raw.GetData(), RawSize);
+		}
+		return !Writer.IsError();
+	}
+}
+
+void UBlasterReplayRecorder::Deinitialize()
+{
+	for (FSegment& Segment : Segments)
+	{
+		if (Segment.Compression.IsValid())
+		{
+			Segment.Compression.Wait();
+		}
+	}
+	Segments.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UBlasterReplayRecorder::ShouldRecord(const UWorld& World) const
+{
+	if (World.IsPlayingReplay() || World.GetNetMode() == NM_Client || World.GetNetMode() == NM_Standalone) return false;
+	if (!CVarBlasterReplayRecord.GetValueOnGameThread() && !FParse::Param(FCommandLine::Get(), TEXT("BlasterRecordReplay"))) return false;
+	return RecordMaps.Contains(UWorld::RemovePIEPrefix(World.GetMapName()));
+}
+
+FString UBlasterReplayRecorder::GetReplayDirectory() const
+{
+	return FPaths::IsRelative(ReplayDirectory) ? FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir(), ReplayDirectory) : ReplayDirectory;
+}
+
+FString UBlasterReplayRecorder::GetReplayFilePath(const FString& ReplayName) const
+{
+	return FPaths::Combine(GetReplayDirectory(), ReplayName + TEXT(".replay"));
+}
+
+FString UBlasterReplayRecorder::GetCompressedFilePath(const FString& ReplayName) const
+{
+	return GetReplayFilePath(ReplayName) + TEXT(".oz");
+}
+
+void UBlasterReplayRecorder::StartSegment(UWorld& World)
+{
+	if (bRecording) return;
+
+	LLM_SCOPE_BYTAG(Blaster_Replication);
+
+	UGameInstance* GameInstance = GetGameInstance();
+	SetConsoleVariable(TEXT("demo.RecordHz"), RecordHz);
+	SetConsoleVariable(TEXT("demo.CheckpointUploadDelay"), CheckpointInterval);
+	SetConsoleVariable(TEXT("demo.CheckpointSaveMaxMSPerFrame"), CheckpointSaveMaxMSPerFrame);
+	SetConsoleVariable(TEXT("localReplay.ChunkUploadDelayInSeconds"), StreamFlushInterval);
+
+	// One name for the server process, the segments of every match in it count against the same budget
+	if (RecordingBaseName.IsEmpty())
+	{
+		RecordingBaseName = FString::Printf(TEXT("Blaster-%s"), *FDateTime::Now().ToString());
+	}
+	const FString ReplayName = FString::Printf(TEXT("%s-%s-%d"), *RecordingBaseName, *UWorld::RemovePIEPrefix(World.GetMapName()), SegmentIndex++);
+
+	// The local file streamer takes absolute paths as they are, relative names would go to Saved/Demos
+	IFileManager::Get().MakeDirectory(*GetReplayDirectory(), true);
+	GameInstance->StartRecordingReplay(GetReplayFilePath(ReplayName), ReplayName, { FString::Printf(TEXT("ReplayStreamerOverride=%s"), *ReplayStreamer) });
+
+	bRecording = World.GetDemoNetDriver() != nullptr;
+	if (!bRecording)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay: could not start recording %s"), *ReplayName);
+		return;
+	}
+
+	FSegment& Segment = Segments.AddDefaulted_GetRef();
+	Segment.Name = ReplayName;
+	TimeSinceBudgetCheck = 0.f;
+	UE_LOG(LogTemp, Log, TEXT("Replay: recording %s"), *GetReplayFilePath(ReplayName));
+}
+
+void UBlasterReplayRecorder::StopSegment(UWorld& World)
+{
+	if (!bRecording) return;
+	bRecording = false;
+
+	GetGameInstance()->StopRecordingReplay();
+	if (Segments.Num() > 0)
+	{
+		Segments.Last().bClosed = true;
+		Segments.Last().ClosedTime = FPlatformTime::Seconds();
+	}
+}
+
+void UBlasterReplayRecorder::Update(UWorld& World, float DeltaTime)
+{
+	if (Segments.Num() == 0) return;
+
+	TimeSinceBudgetCheck += DeltaTime;
+	if (TimeSinceBudgetCheck < 1.f) return;
+	TimeSinceBudgetCheck = 0.f;
+
+	UpdateSegments();
+
+	// Checkpoints are full snapshots of the world, so splitting keeps every segment playable on its own
+	if (bRecording && Segments.Num() > 0 && Segments.Last().Bytes > int64(MaxSegmentMegabytes) * 1024 * 1024)
+	{
+		StopSegment(World);
+		StartSegment(World);
+	}
+	EnforceBudget();
+}
+
+void UBlasterReplayRecorder::UpdateSegments()
+{
+	const double Now = FPlatformTime::Seconds();
+	for (FSegment& Segment : Segments)
+	{
+		if (Segment.Compression.IsValid() && Segment.Compression.IsCompleted())
+		{
+			const int64 CompressedBytes = Segment.Compression.GetResult();
+			Segment.Compression = {};
+			Segment.bCompressed = CompressedBytes >= 0;
+			if (!Segment.bCompressed)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Replay: could not compress %s, it stays uncompressed"), *Segment.Name);
+			}
+		}
+		if (Segment.Compression.IsValid()) continue;
+
+		if (Segment.bClosed && !Segment.bCompressionStarted && bCompressSegments && Now - Segment.ClosedTime >= CompressDelay)
+		{
+			Segment.bCompressionStarted = true;
+			const FString SourcePath = GetReplayFilePath(Segment.Name);
+			const FString TargetPath = GetCompressedFilePath(Segment.Name);
+			Segment.Compression = UE::Tasks::Launch(UE_SOURCE_LOCATION, [SourcePath, TargetPath]() -> int64
+			{
+				if (!TransformFile(SourcePath, TargetPath, &CompressBlocks)) return -1;
+				IFileManager::Get().Delete(*SourcePath);
+				return IFileManager::Get().FileSize(*TargetPath);
+			}, UE::Tasks::ETaskPriority::BackgroundLow);
+			continue;
+		}
+
+		const int64 Bytes = IFileManager::Get().FileSize(Segment.bCompressed ? *GetCompressedFilePath(Segment.Name) : *GetReplayFilePath(Segment.Name));
+		Segment.Bytes = FMath::Max<int64>(Bytes, 0);
+	}
+}
+
+void UBlasterReplayRecorder::EnforceBudget()
+{
+	int64 TotalBytes = 0;
+	for (const FSegment& Segment : Segments)
+	{
+		TotalBytes += Segment.Bytes;
+	}
+
+	const int64 MaxTotalBytes = int64(MaxTotalMegabytes) * 1024 * 1024;
+	while (Segments.Num() > 1 && (Segments.Num() > FMath::Max(MaxSegments, 1) || TotalBytes > MaxTotalBytes))
+	{
+		// A segment being written or compressed is deleted once that is done
+		FSegment& Oldest = Segments[0];
+		if (!Oldest.bClosed || Oldest.Compression.IsValid()) break;
+
+		IFileManager::Get().Delete(*GetReplayFilePath(Oldest.Name));
+		IFileManager::Get().Delete(*GetCompressedFilePath(Oldest.Name));
+		UE_LOG(LogTemp, Log, TEXT("Replay: deleted %s, over the budget"), *Oldest.Name);
+		TotalBytes -= Oldest.Bytes;
+		Segments.RemoveAt(0);
+	}
+}
+
+FString UBlasterReplayRecorder::PrepareForPlayback(const FString& ReplayName) const
+{
+	const FString ReplayPath = GetReplayFilePath(ReplayName);
+	const FString CompressedPath = GetCompressedFilePath(ReplayName);
+	if (!IFileManager::Get().FileExists(*ReplayPath) && IFileManager::Get().FileExists(*CompressedPath))
+	{
+		if (!TransformFile(CompressedPath, ReplayPath, &DecompressBlocks))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Replay: could not decompress %s"), *CompressedPath);
+		}
+	}
+	return ReplayPath;
+}
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tasks/Task.h"
+#include "BlasterReplayRecorder.generated.h"
+
+/**
+* Server replay recording across the whole server process, so the budget holds over RestartGame and travel.
+* Every match world records one or more segments into ReplayDirectory, a segment is closed when it grows past
+* MaxSegmentMegabytes or its world ends. Closed segments are compressed in the background to <Name>.replay.oz.
+* The oldest segments are deleted while there are more than MaxSegments or together they take more than MaxTotalMegabytes.
+* The local file streamer holds at most StreamFlushInterval seconds of a recording in memory before writing it out.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UBlasterReplayRecorder : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	bool ShouldRecord(const UWorld& World) const;
+	void StartSegment(UWorld& World);
+	void StopSegment(UWorld& World);
+	// Compresses closed segments, splits the recording and enforces the budget, call every frame
+	void Update(UWorld& World, float DeltaTime);
+
+	FORCEINLINE bool IsRecording() const { return bRecording; }
+
+	// Replay file of Name in ReplayDirectory, decompressed first when only the compressed segment is on disk
+	FString PrepareForPlayback(const FString& ReplayName) const;
+
+private:
+	struct FSegment
+	{
+		FString Name;
+		double ClosedTime = 0.0;
+		int64 Bytes = 0;
+		bool bClosed = false;
+		bool bCompressionStarted = false;
+		bool bCompressed = false;
+		// Size of the compressed file, negative when compression failed and the segment stays uncompressed
+		UE::Tasks::TTask<int64> Compression;
+	};
+
+	FString GetReplayDirectory() const;
+	FString GetReplayFilePath(const FString& ReplayName) const;
+	FString GetCompressedFilePath(const FString& ReplayName) const;
+	void UpdateSegments();
+	void EnforceBudget();
+
+	UPROPERTY(Config)
+	TArray<FString> RecordMaps = { TEXT("BlasterMap") };
+
+	UPROPERTY(Config)
+	FString ReplayStreamer = TEXT("LocalFileNetworkReplayStreaming");
+
+	// Relative to the project's Saved directory, or absolute
+	UPROPERTY(Config)
+	FString ReplayDirectory = TEXT("Demos");
+
+	// Frames per second written to the replay, the live game replicates characters much more often
+	UPROPERTY(Config)
+	float RecordHz = 10.f;
+
+	UPROPERTY(Config)
+	float CheckpointInterval = 60.f;
+
+	// Checkpoint serialization is spread over frames so it does not spike server frame time
+	UPROPERTY(Config)
+	float CheckpointSaveMaxMSPerFrame = 2.f;
+
+	// Longest the streamer buffers recorded data in memory before it is written to disk
+	UPROPERTY(Config)
+	float StreamFlushInterval = 5.f;
+
+	UPROPERTY(Config)
+	int32 MaxSegmentMegabytes = 64;
+
+	UPROPERTY(Config)
+	int32 MaxSegments = 20;
+
+	UPROPERTY(Config)
+	int32 MaxTotalMegabytes = 512;
+
+	UPROPERTY(Config)
+	bool bCompressSegments = true;
+
+	// The streamer finishes writing a segment after recording stopped, compression waits this long
+	UPROPERTY(Config)
+	float CompressDelay = 10.f;
+
+	bool bRecording = false;
+	FString RecordingBaseName;
+	int32 SegmentIndex = 0;
+	TArray<FSegment> Segments;
+	float TimeSinceBudgetCheck = 0.f;
+};
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterReplaySubsystem.h"
+#include "BlasterReplayRecorder.h"
+#include "Engine/DemoNetDriver.h"
+#include "Engine/GameInstance.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace BlasterReplay
+{
+	// Playback starts from the first world of the process only, the replay world itself must not start it again
+	bool bPlaybackStarted = false;
+}
+
+bool UBlasterReplaySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UBlasterReplaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBlasterReplaySubsystem, STATGROUP_Tickables);
+}
+
+void UBlasterReplaySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.IsPlayingReplay())
+	{
+		// Replays watched in game are left alone, only the headless playback is profiled
+		bProfilingPlayback = BlasterReplay::bPlaybackStarted;
+		PlaybackFrameTimes.Reset();
+		return;
+	}
+
+	FString PlayReplayName;
+	if (!BlasterReplay::bPlaybackStarted && FParse::Value(FCommandLine::Get(), TEXT("BlasterPlayReplay="), PlayReplayName))
+	{
+		BlasterReplay::bPlaybackStarted = true;
+		UBlasterReplayRecorder* Recorder = GetRecorder();
+		if (Recorder == nullptr || !InWorld.GetGameInstance()->PlayReplay(Recorder->PrepareForPlayback(PlayReplayName)))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Replay: could not play %s"), *PlayReplayName);
+			FPlatformMisc::RequestExitWithStatus(false, 1);
+		}
+		return;
+	}
+
+	UBlasterReplayRecorder* Recorder = GetRecorder();
+	if (Recorder && Recorder->ShouldRecord(InWorld))
+	{
+		Recorder->StartSegment(InWorld);
+	}
+}
+
+UBlasterReplayRecorder* UBlasterReplaySubsystem::GetRecorder() const
+{
+	UGameInstance* GameInstance = GetWorld()->GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<UBlasterReplayRecorder>() : nullptr;
+}
+
+void UBlasterReplaySubsystem::Deinitialize()
+{
+	// Closes this world's segment, the recorder keeps the ones before it
+	UBlasterReplayRecorder* Recorder = GetRecorder();
+	if (Recorder && Recorder->IsRecording())
+	{
+		Recorder->StopSegment(*GetWorld());
+	}
+
+	Super::Deinitialize();
+}
+
+void UBlasterReplaySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Also between recordings, closed segments still need compressing and the budget still applies
+	if (UBlasterReplayRecorder* Recorder = GetRecorder())
+	{
+		Recorder->Update(*GetWorld(), DeltaTime);
+	}
+
+	if (bProfilingPlayback)
+	{
+		UDemoNetDriver* DemoNetDriver = GetWorld()->GetDemoNetDriver();
+		if (DemoNetDriver == nullptr) return;
+
+		PlaybackFrameTimes.Add(DeltaTime * 1000.f);
+		if (DemoNetDriver->GetDemoTotalTime() > 0.f && DemoNetDriver->GetDemoCurrentTime() >= DemoNetDriver->GetDemoTotalTime())
+		{
+			FinishPlayback();
+		}
+	}
+}
+
+void UBlasterReplaySubsystem::FinishPlayback()
+{
+	bProfilingPlayback = false;
+
+	FString ReplayName;
+	FParse::Value(FCommandLine::Get(), TEXT("BlasterPlayReplay="), ReplayName);
+
+	TArray<float> Sorted = PlaybackFrameTimes;
+	Sorted.Sort();
+	auto Percentile = [&Sorted](float Fraction)
+	{
+		return Sorted.Num() > 0 ? Sorted[FMath::Clamp(FMath::FloorToInt(Fraction * Sorted.Num()), 0, Sorted.Num() - 1)] : 0.f;
+	};
+
+	const FString Csv = FString::Printf(TEXT("Replay,Frames,FrameMsP50,FrameMsP95,FrameMsP99,FrameMsMax\n%s,%d,%.3f,%.3f,%.3f,%.3f\n"),
+		*ReplayName, Sorted.Num(), Percentile(0.5f), Percentile(0.95f), Percentile(0.99f), Sorted.Num() > 0 ? Sorted.Last() : 0.f);
+	const FString FilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ReplayProfile"), ReplayName + TEXT(".csv"));
+	FFileHelper::SaveStringToFile(Csv, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+	UE_LOG(LogTemp, Log, TEXT("Replay: playback profile written to %s"), *FilePath);
+
+	FPlatformMisc::RequestExit(false);
+}
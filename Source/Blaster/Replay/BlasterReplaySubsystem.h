@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BlasterReplaySubsystem.generated.h"
+
+/**
+* Opt-in server replay recording and headless playback.
+* Recording, on a server running one of the recorder's RecordMaps, with -BlasterRecordReplay or Blaster.Replay.Record 1:
+*   Every match world records through UBlasterReplayRecorder, which keeps the budget for the whole server process.
+* Playback, in a headless client with -BlasterPlayReplay=<Name>, Name being a segment in the recorder's ReplayDirectory:
+*   Plays the replay once, writes frame time percentiles to Saved/ReplayProfile/<Name>.csv and exits.
+*   Combine with -trace=cpu,counters,Blaster or -csvprofile to re-profile the match offline.
+*/
+UCLASS()
+class BLASTER_API UBlasterReplaySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	class UBlasterReplayRecorder* GetRecorder() const;
+	void FinishPlayback();
+
+	bool bProfilingPlayback = false;
+	TArray<float> PlaybackFrameTimes;
+};
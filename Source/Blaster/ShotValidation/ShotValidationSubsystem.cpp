@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShotValidationSubsystem.h"
+#include "Blaster/Character/BlasterCharacter.h"
+#include "Blaster/Weapon/Projectile.h"
+#include "Blaster/Damage/BlasterDamageSubsystem.h"
+#include "Blaster/BlasterStats.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Async/ParallelFor.h"
+
+static TAutoConsoleVariable<bool> CVarBlasterShotValidation(
+	TEXT("Blaster.ShotValidation"),
+	true,
+	TEXT("Validates projectile hits on the server before applying damage."));
+
+bool UShotValidationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShotValidationSubsystem::Deinitialize()
+{
+	Requests.Reset();
+
+	Super::Deinitialize();
+}
+
+void UShotValidationSubsystem::QueueProjectileHit(AProjectile* Projectile, AActor* Target, const FHitResult& Hit)
+{
+	if (Projectile == nullptr || Target == nullptr) return;
+
+	LLM_SCOPE_BYTAG(Blaster_Combat);
+
+	APawn* ShooterPawn = Cast<APawn>(Projectile->GetOwner());
+	AController* Shooter = ShooterPawn ? ShooterPawn->GetController() : nullptr;
+	if (Shooter == nullptr) return;
+
+	FShotValidationRequest& Request = Requests.AddDefaulted_GetRef();
+	Request.Shooter = Shooter;
+	Request.ShooterPawn = ShooterPawn;
+	Request.DamageCauser = Projectile;
+	Request.Target = Target;
+	Request.FireTime = Projectile->CreationTime;
+	Request.HitTime = GetWorld()->GetTimeSeconds();
+	Request.Origin = Projectile->GetTrajectoryOrigin();
+	Request.Direction = Projectile->GetTrajectoryDirection();
+	Request.ImpactPoint = Hit.ImpactPoint;
+	Request.Damage = Projectile->GetDamageAt(Hit.ImpactPoint);
+	Request.Hit = Hit;
+	if (const UProjectileMovementComponent* Movement = Projectile->GetProjectileMovementComponent())
+	{
+		Request.MaxSpeed = Movement->GetMaxSpeed() > 0.f ? Movement->GetMaxSpeed() : Movement->InitialSpeed;
+	}
+
+	FShotTargetSnapshot& Snapshot = Request.TargetSnapshot;
+	Snapshot.Location = Target->GetActorLocation();
+	if (ACharacter* TargetCharacter = Cast<ACharacter>(Target))
+	{
+		TargetCharacter->GetCapsuleComponent()->GetScaledCapsuleSize(Snapshot.Radius, Snapshot.HalfHeight);
+	}
+	else
+	{
+		FVector Extent;
+		Target->GetActorBounds(true, Snapshot.Location, Extent);
+		Snapshot.Radius = FVector2D(Extent).Size();
+		Snapshot.HalfHeight = Extent.Z;
+	}
+	const ABlasterCharacter* TargetBlasterCharacter = Cast<ABlasterCharacter>(Target);
+	Snapshot.bAlive = TargetBlasterCharacter == nullptr || !TargetBlasterCharacter->IsElimmed();
+}
+
+void UShotValidationSubsystem::ProcessRequests()
+{
+	if (Requests.Num() == 0) return;
+
+	BLASTER_SCOPE(ShotValidation);
+	LLM_SCOPE_BYTAG(Blaster_Combat);
+
+	TArray<FShotValidationRequest> Batch = MoveTemp(Requests);
+	Requests.Reset();
+
+	Results.SetNumUninitialized(Batch.Num());
+	if (CVarBlasterShotValidation.GetValueOnGameThread())
+	{
+		// Workers only read their own request and write their own result slot
+		ParallelFor(Batch.Num(), [this, &Batch](int32 Index)
+		{
+			Results[Index] = Validate(Batch[Index]);
+		}, Batch.Num() < MinParallelRequests ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+	}
+	else
+	{
+		for (EShotValidationResult& Result : Results)
+		{
+			Result = EShotValidationResult::Valid;
+		}
+	}
+
+	UBlasterDamageSubsystem* DamageSubsystem = GetWorld()->GetSubsystem<UBlasterDamageSubsystem>();
+	for (int32 Index = 0; Index < Batch.Num(); ++Index)
+	{
+		const FShotValidationRequest& Request = Batch[Index];
+		AActor* Target = Request.Target.Get();
+		AController* Shooter = Request.Shooter.Get();
+		if (Results[Index] != EShotValidationResult::Valid || Target == nullptr || Shooter == nullptr)
+		{
+			UE_LOG(LogTemp, Verbose, TEXT("Shot validation: rejected hit on %s (%d)"), *GetNameSafe(Target), int32(Results[Index]));
+			continue;
+		}
+		// The projectile destroyed itself on impact, it is still the damage causer
+		if (DamageSubsystem)
+		{
+			DamageSubsystem->QueuePointDamage(Target, Request.Damage, Request.Hit, Request.Direction, Shooter, Request.DamageCauser.Get(true));
+		}
+		else
+		{
+			UGameplayStatics::ApplyPointDamage(Target, Request.Damage, Request.Direction, Request.Hit, Shooter, Request.DamageCauser.Get(true), UDamageType::StaticClass());
+		}
+	}
+}
+
+EShotValidationResult UShotValidationSubsystem::Validate(const FShotValidationRequest& Request) const
+{
+	const FShotTargetSnapshot& Snapshot = Request.TargetSnapshot;
+	if (Snapshot.Radius <= 0.f) return EShotValidationResult::TargetNotDamageable;
+	if (!Snapshot.bAlive) return EShotValidationResult::TargetDead;
+	if (Request.Target == Request.ShooterPawn) return EShotValidationResult::SelfHit;
+
+	// Distance from the impact to the target's capsule
+	const FVector ToImpact = Request.ImpactPoint - Snapshot.Location;
+	const float AxisDistance = FMath::Max(FMath::Abs(ToImpact.Z) - (Snapshot.HalfHeight - Snapshot.Radius), 0.f);
+	const float CapsuleDistance = FVector2D(FVector2D(ToImpact).Size(), AxisDistance).Size() - Snapshot.Radius;
+	if (CapsuleDistance > CapsuleTolerance) return EShotValidationResult::OutsideTarget;
+
+	const FVector Travel = Request.ImpactPoint - Request.Origin;
+	if (Request.MaxSpeed > 0.f)
+	{
+		const float MaxTravel = Request.MaxSpeed * FMath::Max(Request.HitTime - Request.FireTime, 0.f) + RangeTolerance;
+		if (Travel.SizeSquared() > FMath::Square(MaxTravel)) return EShotValidationResult::TooFar;
+	}
+
+	// Point blank hits have no meaningful direction
+	if (Travel.SizeSquared() > FMath::Square(RangeTolerance))
+	{
+		const float CosAngle = FVector::DotProduct(Travel.GetSafeNormal(), Request.Direction);
+		if (CosAngle < FMath::Cos(FMath::DegreesToRadians(MaxDirectionErrorDegrees))) return EShotValidationResult::OffDirection;
+	}
+	return EShotValidationResult::Valid;
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/HitResult.h"
+#include "ShotValidationSubsystem.generated.h"
+
+class AProjectile;
+
+/**
+* State of a hit target captured on the game thread when the hit is reported, read only for the workers
+*/
+struct FShotTargetSnapshot
+{
+	FVector Location = FVector::ZeroVector;
+	float Radius = 0.f;
+	float HalfHeight = 0.f;
+	bool bAlive = false;
+};
+
+struct FShotValidationRequest
+{
+	TWeakObjectPtr<AController> Shooter;
+	TWeakObjectPtr<AActor> ShooterPawn;
+	TWeakObjectPtr<AActor> DamageCauser;
+	TWeakObjectPtr<AActor> Target;
+	float FireTime = 0.f;
+	float HitTime = 0.f;
+	FVector Origin = FVector::ZeroVector;
+	FVector Direction = FVector::ForwardVector;
+	FVector ImpactPoint = FVector::ZeroVector;
+	float MaxSpeed = 0.f;
+	float Damage = 0.f;
+	// Carries the body that was hit, its hit zone is resolved when the damage is queued
+	FHitResult Hit;
+	FShotTargetSnapshot TargetSnapshot;
+};
+
+enum class EShotValidationResult : uint8
+{
+	Valid,
+	TargetNotDamageable,
+	TargetDead,
+	SelfHit,
+	OutsideTarget,
+	TooFar,
+	OffDirection
+};
+
+/**
+* Server side hit validation for projectile damage.
+* Hits are queued on the game thread with a snapshot of the target, validated in parallel on worker threads after
+* all actors ticked, and the damage of valid hits is queued back on the game thread in the order the hits happened.
+* UBlasterDamageSubsystem runs the validation right before it resolves the frame's damage.
+* Blaster.ShotValidation 0 applies every queued hit unchecked.
+*/
+UCLASS(Config = Game)
+class BLASTER_API UShotValidationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void QueueProjectileHit(AProjectile* Projectile, AActor* Target, const FHitResult& Hit);
+	// Validates everything queued so far and hands the damage of valid hits to UBlasterDamageSubsystem
+	void ProcessRequests();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	EShotValidationResult Validate(const FShotValidationRequest& Request) const;
+
+	// Distance the impact may lie outside the target's capsule, covers movement between the hit and the snapshot
+	UPROPERTY(Config)
+	float CapsuleTolerance = 50.f;
+
+	UPROPERTY(Config)
+	float RangeTolerance = 200.f;
+
+	// Largest angle between the fired direction and origin to impact, projectiles drop and are blocked by nothing else
+	UPROPERTY(Config)
+	float MaxDirectionErrorDegrees = 15.f;
+
+	// Below this many requests validation stays on the game thread, dispatching would cost more than it saves
+	UPROPERTY(Config)
+	int32 MinParallelRequests = 16;
+
+	TArray<FShotValidationRequest> Requests;
+	TArray<EShotValidationResult> Results;
+};
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BlasterTravelSubsystem.h"
+#include "Blaster/BlasterStats.h"
+#include "Misc/PackageName.h"
+
+void UBlasterTravelSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UBlasterTravelSubsystem::OnPostLoadMap);
+}
+
+void UBlasterTravelSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	PreloadedPackage = nullptr;
+
+	Super::Deinitialize();
+}
+
+FName UBlasterTravelSubsystem::PreloadMap(const FString& MapPath)
+{
+	// Travel URLs carry options, only the package is loaded
+	FString PackagePath;
+	MapPath.Split(TEXT("?"), &PackagePath, nullptr);
+	PackagePath = PackagePath.IsEmpty() ? MapPath : PackagePath;
+
+	const FName PackageName(*FPackageName::ObjectPathToPackageName(PackagePath));
+	if (PackageName == PreloadingPackageName) return PackageName;
+	if (!FPackageName::DoesPackageExist(PackageName.ToString())) return NAME_None;
+
+	LLM_SCOPE_BYTAG(Blaster);
+	PreloadingPackageName = PackageName;
+	PreloadedPackage = nullptr;
+	PreloadStartTime = FPlatformTime::Seconds();
+	LoadPackageAsync(PackageName.ToString(), FLoadPackageAsyncDelegate::CreateUObject(this, &UBlasterTravelSubsystem::OnMapPackageLoaded));
+	return PackageName;
+}
+
+bool UBlasterTravelSubsystem::IsMapPreloaded(const FString& MapPath) const
+{
+	return PreloadedPackage && MapPath.StartsWith(PreloadedPackage->GetName());
+}
+
+void UBlasterTravelSubsystem::OnMapPackageLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result)
+{
+	if (PackageName != PreloadingPackageName) return;
+
+	if (Result != EAsyncLoadingResult::Succeeded || Package == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Travel: could not preload %s"), *PackageName.ToString());
+		PreloadingPackageName = NAME_None;
+		OnMapPreloaded.Broadcast(PackageName, false);
+		return;
+	}
+	PreloadedPackage = Package;
+	UE_LOG(LogTemp, Log, TEXT("Travel: preloaded %s in %.2fs"), *PackageName.ToString(), FPlatformTime::Seconds() - PreloadStartTime);
+	OnMapPreloaded.Broadcast(PackageName, true);
+}
+
+void UBlasterTravelSubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	if (LoadedWorld && LoadedWorld->GetPackage()->GetFName() == PreloadingPackageName)
+	{
+		PreloadedPackage = nullptr;
+		PreloadingPackageName = NAME_None;
+	}
+}
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "UObject/UObjectGlobals.h"
+#include "BlasterTravelSubsystem.generated.h"
+
+/**
+* Streams the next map's package in the background so the travel to it finds it in memory.
+* The package is held until the map has been loaded as a world, then the world keeps it alive.
+*/
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnMapPreloaded, FName /* PackageName */, bool /* bSuccess */);
+
+UCLASS()
+class BLASTER_API UBlasterTravelSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Package being preloaded for MapPath, None when the map does not exist
+	FName PreloadMap(const FString& MapPath);
+	bool IsMapPreloaded(const FString& MapPath) const;
+
+	FOnMapPreloaded OnMapPreloaded;
+
+private:
+	void OnMapPackageLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result);
+	void OnPostLoadMap(UWorld* LoadedWorld);
+
+	UPROPERTY()
+	UPackage* PreloadedPackage = nullptr;
+
+	FName PreloadingPackageName;
+	double PreloadStartTime = 0.0;
+	FDelegateHandle PostLoadMapHandle;
+};
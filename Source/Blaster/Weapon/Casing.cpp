@@ -3,6 +3,7 @@
 
 
 #include "Casing.h"
+#include "Blaster/BlasterStats.h"
 
 // Sets default values
 ACasing::ACasing()
@@ -21,10 +22,21 @@ ACasing::ACasing()
 
 void ACasing::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Blaster_Effects);
+
 	Super::BeginPlay();
 
 	CasingMesh->OnComponentHit.AddDynamic(this, &ACasing::OnHit);
 	CasingMesh->AddImpulse(GetActorForwardVector() * ShellEjectionImpulse);
+
+	BlasterStats::ChangeLiveCasings(1);
+}
+
+void ACasing::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	BlasterStats::ChangeLiveCasings(-1);
 }
 
 void ACasing::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
@@ -10,6 +10,12 @@
 #include "Particles/ParticleSystem.h"
 #include "Blaster/Character/BlasterCharacter.h"
 #include "Blaster/Blaster.h"
+#include "Blaster/BlasterStats.h"
+#include "Blaster/BlasterServerLean.h"
+#include "Blaster/Assets/BlasterAssetPreloadSubsystem.h"
+#include "WeaponDefinition.h"
+#include "Blaster/Ballistics/BallisticsSubsystem.h"
+#include "Blaster/LoadTest/BlasterLoadTestSubsystem.h"
 
 AProjectile::AProjectile()
 {
@@ -32,12 +38,21 @@ AProjectile::AProjectile()
 
 void AProjectile::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Blaster_Projectiles);
+
 	Super::BeginPlay();
 
-	if (Tracer)
+	SpawnLocation = GetActorLocation();
+	SpawnDirection = GetActorForwardVector();
+	TrajectoryOrigin = SpawnLocation;
+	TrajectoryDirection = SpawnDirection;
+
+	UParticleSystem* TracerSystem = BlasterServerLean::IsEnabled() ? nullptr : BlasterAssets::Get(Tracer);
+	if (TracerSystem)
 	{
+		LLM_SCOPE_BYTAG(Blaster_Effects);
 		TracerComponent = UGameplayStatics::SpawnEmitterAttached(
-			Tracer,
+			TracerSystem,
 			CollisionBox,
 			FName(),
 			GetActorLocation(),
@@ -48,17 +63,38 @@ void AProjectile::BeginPlay()
 
 	if (HasAuthority())
 	{
-		CollisionBox->OnComponentHit.AddDynamic(this, &AProjectile::OnHit);
+		UBallisticsSubsystem* Ballistics = bUseBallistics ? GetWorld()->GetSubsystem<UBallisticsSubsystem>() : nullptr;
+		if (Ballistics)
+		{
+			ProjectileMovementComponent->SetComponentTickEnabled(false);
+			Ballistics->AddProjectile(this);
+		}
+		else
+		{
+			CollisionBox->OnComponentHit.AddDynamic(this, &AProjectile::OnHit);
+		}
 	}
+
+	BlasterStats::ChangeLiveProjectiles(1);
+}
+
+void AProjectile::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	BlasterStats::ChangeLiveProjectiles(-1);
 }
 
 void AProjectile::Destroyed()
 {
+	LLM_SCOPE_BYTAG(Blaster_Effects);
+
 	Super::Destroyed();
 
-	if (ImpactParticles)
+	UParticleSystem* ImpactSystem = BlasterServerLean::IsEnabled() ? nullptr : BlasterAssets::Get(ImpactParticles);
+	if (ImpactSystem)
 	{
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ImpactParticles, GetActorTransform());
+		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ImpactSystem, GetActorTransform());
 	}
 }
 
@@ -72,3 +108,38 @@ void AProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimi
 {
 	Destroy();
 }
+
+void AProjectile::Redirect(const FVector& Location, const FVector& Velocity, float SpeedScale)
+{
+	DamageScale *= SpeedScale;
+	TrajectoryOrigin = Location;
+	TrajectoryDirection = Velocity.GetSafeNormal();
+	SetActorLocationAndRotation(Location, Velocity.Rotation());
+	MulticastRedirect(Location, Velocity);
+}
+
+void AProjectile::MulticastRedirect_Implementation(FVector_NetQuantize Location, FVector_NetQuantize Velocity)
+{
+	BLASTER_COUNT_RPC(MulticastRedirect);
+	if (HasAuthority()) return;
+
+	SetActorLocationAndRotation(Location, Velocity.Rotation(), false, nullptr, ETeleportType::TeleportPhysics);
+	// The movement component lets go of the box once it stopped at a surface the server let the bullet through
+	if (ProjectileMovementComponent->UpdatedComponent == nullptr)
+	{
+		ProjectileMovementComponent->SetUpdatedComponent(CollisionBox);
+	}
+	ProjectileMovementComponent->Velocity = Velocity;
+	ProjectileMovementComponent->UpdateComponentVelocity();
+}
+
+void AProjectile::Impact(const FHitResult& Hit)
+{
+	OnHit(CollisionBox, Hit.GetActor(), Hit.GetComponent(), FVector::ZeroVector, Hit);
+}
+
+float AProjectile::GetDamageAt(const FVector& ImpactPoint) const
+{
+	const float BaseDamage = Damage * DamageScale;
+	return WeaponDefinition ? BaseDamage * WeaponDefinition->GetDamageMultiplier(FVector::Dist(SpawnLocation, ImpactPoint)) : BaseDamage;
+}
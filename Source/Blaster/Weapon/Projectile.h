@@ -19,11 +19,20 @@ public:
 
 protected:
 	void BeginPlay() override;
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	UFUNCTION()
 	virtual void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
 private:
+	// Clients restart their projectile movement on the new path
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastRedirect(FVector_NetQuantize Location, FVector_NetQuantize Velocity);
+
+	// Server flight through UBallisticsSubsystem with penetration and ricochets, otherwise the movement component stops at the first hit
+	UPROPERTY(EditAnywhere)
+	bool bUseBallistics = true;
+
 
 	UPROPERTY(EditAnywhere)
 	class UBoxComponent* CollisionBox;
@@ -32,14 +41,41 @@ private:
 	class UProjectileMovementComponent* ProjectileMovementComponent;
 
 	UPROPERTY(EditAnywhere)
-	class UParticleSystem* Tracer;
+	TSoftObjectPtr<class UParticleSystem> Tracer;
 	UPROPERTY()
 	class UParticleSystemComponent* TracerComponent;
 
 	UPROPERTY(EditAnywhere)
-	UParticleSystem* ImpactParticles;
+	TSoftObjectPtr<UParticleSystem> ImpactParticles;
+
+	FVector SpawnLocation;
+	FVector SpawnDirection;
+
+	// Start of the current leg, moves with every penetration or ricochet
+	FVector TrajectoryOrigin;
+	FVector TrajectoryDirection;
+
+	// Share of the damage left after penetrations and ricochets slowed the bullet down
+	float DamageScale = 1.f;
+
+	UPROPERTY()
+	const UWeaponDefinition* WeaponDefinition = nullptr;
 
 public:
+	FORCEINLINE const FVector& GetSpawnLocation() const { return SpawnLocation; }
+	FORCEINLINE const FVector& GetSpawnDirection() const { return SpawnDirection; }
+	FORCEINLINE const FVector& GetTrajectoryOrigin() const { return TrajectoryOrigin; }
+	FORCEINLINE const FVector& GetTrajectoryDirection() const { return TrajectoryDirection; }
+	FORCEINLINE UProjectileMovementComponent* GetProjectileMovementComponent() const { return ProjectileMovementComponent; }
+	FORCEINLINE void SetWeaponDefinition(const class UWeaponDefinition* Definition) { WeaponDefinition = Definition; }
+	// Damage after the falloff of the weapon that fired it
+	float GetDamageAt(const FVector& ImpactPoint) const;
+
+	// Server, the bullet goes on from Location after it lost all but SpeedScale of its speed
+	void Redirect(const FVector& Location, const FVector& Velocity, float SpeedScale);
+	// Server, the bullet stops at Hit
+	void Impact(const FHitResult& Hit);
+
 	UPROPERTY(EditAnywhere)
 	float Damage = 20.f;
 };
\ No newline at end of file
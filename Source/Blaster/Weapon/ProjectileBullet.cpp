@@ -4,18 +4,31 @@
 #include "ProjectileBullet.h"
 #include "Kismet/GameplayStatics.h"
 #include "GameFramework/Character.h"
+#include "Blaster/ShotValidation/ShotValidationSubsystem.h"
+#include "Blaster/Damage/BlasterDamageSubsystem.h"
 
 void AProjectileBullet::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
 	ACharacter* OwnerCharacter = Cast<ACharacter>(GetOwner());
-	if (OwnerCharacter)
+	if (OwnerCharacter && OtherActor && OtherActor->CanBeDamaged())
 	{
 		AController* OwnerController = OwnerCharacter->Controller;
 		if (OwnerController)
 		{
-			UGameplayStatics::ApplyDamage(OtherActor, Damage, OwnerController, this, UDamageType::StaticClass());
+			if (UShotValidationSubsystem* ShotValidation = GetWorld()->GetSubsystem<UShotValidationSubsystem>())
+			{
+				ShotValidation->QueueProjectileHit(this, OtherActor, Hit);
+			}
+			else if (UBlasterDamageSubsystem* DamageSubsystem = GetWorld()->GetSubsystem<UBlasterDamageSubsystem>())
+			{
+				DamageSubsystem->QueuePointDamage(OtherActor, GetDamageAt(Hit.ImpactPoint), Hit, GetTrajectoryDirection(), OwnerController, this);
+			}
+			else
+			{
+				UGameplayStatics::ApplyPointDamage(OtherActor, GetDamageAt(Hit.ImpactPoint), GetTrajectoryDirection(), Hit, OwnerController, this, UDamageType::StaticClass());
+			}
 		}
 	}
 
 	Super::OnHit(HitComp, OtherActor, OtherComp, NormalImpulse, Hit);
-}
\ No newline at end of file
+}
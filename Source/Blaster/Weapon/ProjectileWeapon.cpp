@@ -4,10 +4,15 @@
 #include "Engine/SkeletalMeshSocket.h"
 #include "Projectile.h"
 #include "../DebugHelper.h"
+#include "Blaster/BlasterStats.h"
+#include "Blaster/Assets/BlasterAssetPreloadSubsystem.h"
 
-void AProjectileWeapon::Fire(const FVector& HitTarget)
+void AProjectileWeapon::Fire(const FVector& HitTarget, uint16 FireSeed)
 {
-	Super::Fire(HitTarget);
+	BLASTER_SCOPE(WeaponFire);
+	LLM_SCOPE_BYTAG(Blaster_Projectiles);
+
+	Super::Fire(HitTarget, FireSeed);
 
 	if (!HasAuthority()) return;
 
@@ -19,7 +24,8 @@ void AProjectileWeapon::Fire(const FVector& HitTarget)
 		// From muzzle flash socket to hit location from TraceUnderCrosshairs
 		FVector ToTarget = HitTarget - SocketTransform.GetLocation();
 		FRotator TargetRotation = ToTarget.Rotation();
-		if (ProjectileClass && InstigatorPawn)
+		UClass* Projectile = BlasterAssets::Get(ProjectileClass);
+		if (Projectile && InstigatorPawn)
 		{
 			FActorSpawnParameters SpawnParams;
 			SpawnParams.Owner = GetOwner();
@@ -27,12 +33,16 @@ void AProjectileWeapon::Fire(const FVector& HitTarget)
 			UWorld* World = GetWorld();
 			if (World)
 			{
-				World->SpawnActor<AProjectile>(
-					ProjectileClass,
+				AProjectile* SpawnedProjectile = World->SpawnActor<AProjectile>(
+					Projectile,
 					SocketTransform.GetLocation(),
 					TargetRotation,
 					SpawnParams
 				);
+				if (SpawnedProjectile)
+				{
+					SpawnedProjectile->SetWeaponDefinition(GetDefinition());
+				}
 			}
 		}
 	}
@@ -13,9 +13,9 @@ class BLASTER_API AProjectileWeapon : public AWeapon
 	GENERATED_BODY()
 
 public:
-	void Fire(const FVector& HitTarget) override;
+	void Fire(const FVector& HitTarget, uint16 FireSeed) override;
 
 private:
 	UPROPERTY(EditAnywhere)
-	TSubclassOf<class AProjectile> ProjectileClass;
+	TSoftClassPtr<class AProjectile> ProjectileClass;
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShotgunWeapon.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystem.h"
+#include "Blaster/BlasterStats.h"
+#include "Blaster/BlasterServerLean.h"
+#include "Blaster/Assets/BlasterAssetPreloadSubsystem.h"
+#include "Blaster/Damage/BlasterDamageSubsystem.h"
+
+void AShotgunWeapon::Fire(const FVector& HitTarget, uint16 FireSeed)
+{
+	BLASTER_SCOPE(WeaponFire);
+	LLM_SCOPE_BYTAG(Blaster_Combat);
+
+	Super::Fire(HitTarget, FireSeed);
+
+	const USkeletalMeshSocket* MuzzleFlashSocket = GetWeaponMesh()->GetSocketByName(FName("MuzzleFlash"));
+	UWorld* World = GetWorld();
+	if (MuzzleFlashSocket == nullptr || World == nullptr) return;
+
+	const FVector Start = MuzzleFlashSocket->GetSocketTransform(GetWeaponMesh()).GetLocation();
+	TArray<FVector, TInlineAllocator<16>> Directions;
+	GetPelletDirections(HitTarget - Start, FireSeed, Directions);
+
+	const UWeaponDefinition* WeaponDefinition = GetDefinition();
+	if (WeaponDefinition == nullptr) return;
+	UParticleSystem* ImpactSystem = BlasterServerLean::IsEnabled() ? nullptr : BlasterAssets::Get(ImpactParticles);
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(BlasterShotgun), false, this);
+	Params.AddIgnoredActor(GetOwner());
+
+	APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	AController* OwnerController = OwnerPawn ? OwnerPawn->GetController() : nullptr;
+	UBlasterDamageSubsystem* DamageSubsystem = World->GetSubsystem<UBlasterDamageSubsystem>();
+	for (const FVector& Direction : Directions)
+	{
+		FHitResult Hit;
+		if (!World->LineTraceSingleByChannel(Hit, Start, Start + Direction * WeaponDefinition->PelletRange, ECollisionChannel::ECC_Visibility, Params)) continue;
+
+		// Every pellet is scaled by the zone it hit, the damage subsystem still applies one sum per victim
+		AActor* Victim = Hit.GetActor();
+		if (HasAuthority() && Victim && Victim->CanBeDamaged())
+		{
+			const float Damage = WeaponDefinition->PelletDamage * WeaponDefinition->GetDamageMultiplier(Hit.Distance);
+			if (DamageSubsystem)
+			{
+				DamageSubsystem->QueuePointDamage(Victim, Damage, Hit, Direction, OwnerController, this);
+			}
+			else
+			{
+				UGameplayStatics::ApplyPointDamage(Victim, Damage, Direction, Hit, OwnerController, this, UDamageType::StaticClass());
+			}
+		}
+		if (ImpactSystem)
+		{
+			UGameplayStatics::SpawnEmitterAtLocation(World, ImpactSystem, Hit.ImpactPoint, Hit.ImpactNormal.Rotation());
+		}
+	}
+}
+
+void AShotgunWeapon::GetPelletDirections(const FVector& Aim, uint16 FireSeed, TArray<FVector, TInlineAllocator<16>>& OutDirections) const
+{
+	OutDirections.Reset();
+	const UWeaponDefinition* WeaponDefinition = GetDefinition();
+	if (WeaponDefinition == nullptr) return;
+
+	const FVector AimDirection = Aim.GetSafeNormal();
+	const float HalfAngle = FMath::DegreesToRadians(WeaponDefinition->PelletSpread);
+
+	FRandomStream Stream(FireSeed);
+	OutDirections.Reset(WeaponDefinition->NumPellets);
+	for (int32 Pellet = 0; Pellet < WeaponDefinition->NumPellets; ++Pellet)
+	{
+		OutDirections.Add(Stream.VRandCone(AimDirection, HalfAngle));
+	}
+}
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Weapon.h"
+#include "ShotgunWeapon.generated.h"
+
+/**
+* Hitscan multi pellet weapon. The server picks a seed and its fire event carries it, the server and the clients playing
+* the event generate the same pellet directions from it, so a blast costs what a single rifle shot costs and spawns no
+* projectile actors. The shooter plays its own blast at once with a seed of its own, which only affects what it sees.
+* The server resolves all pellets in one pass and deals damage once per victim, clients only trace for impact effects.
+*/
+UCLASS()
+class BLASTER_API AShotgunWeapon : public AWeapon
+{
+	GENERATED_BODY()
+
+public:
+	void Fire(const FVector& HitTarget, uint16 FireSeed) override;
+
+	// Pellet directions spread around Aim, the same for the same seed on every machine
+	void GetPelletDirections(const FVector& Aim, uint16 FireSeed, TArray<FVector, TInlineAllocator<16>>& OutDirections) const;
+
+private:
+	UPROPERTY(EditAnywhere)
+	TSoftObjectPtr<class UParticleSystem> ImpactParticles;
+};
@@ -11,8 +11,25 @@
 #include "Casing.h"
 #include "Engine/SkeletalMeshSocket.h"
 #include "Blaster/PlayerController/BlasterPlayerController.h"
+#include "TimerManager.h"
+#include "Blaster/Assets/BlasterAssetPreloadSubsystem.h"
+#include "Blaster/BlasterStats.h"
+#include "Blaster/BlasterServerLean.h"
+#include "WeaponDefinition.h"
+#include "Blaster/LoadTest/BlasterLoadTestSubsystem.h"
+#include "Blaster/Interaction/BlasterInteractionSubsystem.h"
 
-AWeapon::AWeapon()
+namespace
+{
+  // Nobody sees the pickup widget on a dedicated server
+  const FObjectInitializer& WithoutPickupWidget(const FObjectInitializer& ObjectInitializer)
+  {
+    return BlasterServerLean::IsEnabled() ? ObjectInitializer.DoNotCreateDefaultSubobject(TEXT("PickupWidget")) : ObjectInitializer;
+  }
+}
+
+AWeapon::AWeapon(const FObjectInitializer& ObjectInitializer)
+  : Super(WithoutPickupWidget(ObjectInitializer))
 {
   PrimaryActorTick.bCanEverTick = false;
   bReplicates = true;
@@ -28,27 +45,77 @@ AWeapon::AWeapon()
   AreaSphere = CreateDefaultSubobject<USphereComponent>(TEXT("AreaSphere"));
   AreaSphere->SetupAttachment(RootComponent);
   AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+  // Only sizes the pickup radius, UBlasterInteractionSubsystem resolves who is in reach
   AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-  if (HasAuthority())
+
+  if (BlasterServerLean::IsEnabled())
   {
-    AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-    AreaSphere->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap);
+    // Weapon bones are only looked at, sockets fall back to the reference pose
+    WeaponMesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
   }
 
-  PickupWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("PickupWidget"));
-  PickupWidget->SetupAttachment(RootComponent);
+  PickupWidget = CreateOptionalDefaultSubobject<UWidgetComponent>(TEXT("PickupWidget"));
+  if (PickupWidget)
+  {
+    PickupWidget->SetupAttachment(RootComponent);
+  }
+}
+
+void AWeapon::PostLoad()
+{
+  Super::PostLoad();
+
+  MigrateDeprecatedProperties();
+}
+
+void AWeapon::MigrateDeprecatedProperties()
+{
+  const bool bHasDeprecatedData = MagCapacity_DEPRECATED > 0 || !CrosshairsCenter_DEPRECATED.IsNull() || !FireAnimation_DEPRECATED.IsNull() || CasingClass_DEPRECATED != nullptr;
+  if (Definition || !bHasDeprecatedData) return;
+
+  // Instances share the definition their archetype migrated to, like weapons of one kind share an asset
+  const AWeapon* Archetype = Cast<AWeapon>(GetArchetype());
+  if (Archetype && Archetype != this && Archetype->Definition && Archetype->Definition->HasAnyFlags(RF_Transient))
+  {
+    Definition = Archetype->Definition;
+    return;
+  }
+
+  UWeaponDefinition* Migrated = NewObject<UWeaponDefinition>(this, NAME_None, RF_Transient);
+  Migrated->FireDelay = FireDelay_DEPRECATED;
+  Migrated->bAutomatic = bAutomatic_DEPRECATED;
+  Migrated->MagCapacity = MagCapacity_DEPRECATED;
+  Migrated->CrosshairsCenter = CrosshairsCenter_DEPRECATED;
+  Migrated->CrosshairsLeft = CrosshairsLeft_DEPRECATED;
+  Migrated->CrosshairsRight = CrosshairsRight_DEPRECATED;
+  Migrated->CrosshairsTop = CrosshairsTop_DEPRECATED;
+  Migrated->CrosshairsBottom = CrosshairsBottom_DEPRECATED;
+  Migrated->FireAnimation = FireAnimation_DEPRECATED;
+  Migrated->CasingClass = CasingClass_DEPRECATED.Get();
+  Definition = Migrated;
+
+  // Migrated definitions have WeaponId 0, clients keep the one their own copy of the weapon migrated to
+  UE_LOG(LogTemp, Warning, TEXT("%s: migrated weapon properties into a transient definition, give it a WeaponDefinition asset"), *GetPathName());
 }
 
 void AWeapon::BeginPlay()
 {
+  LLM_SCOPE_BYTAG(Blaster_Weapons);
+
   Super::BeginPlay();
 
+  if (Definition == nullptr)
+  {
+    UE_LOG(LogTemp, Error, TEXT("%s has no weapon definition and cannot fire"), *GetName());
+  }
+
   if (HasAuthority())
   {
-    AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-    AreaSphere->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap);
-    AreaSphere->OnComponentBeginOverlap.AddDynamic(this, &AWeapon::OnSphereOverlap);
-    AreaSphere->OnComponentEndOverlap.AddDynamic(this, &AWeapon::OnSphereEndOverlap);
+    WeaponId = Definition ? Definition->WeaponId : 0;
+    if (WeaponState != EWeaponState::EWS_Equipped)
+    {
+      SetPickupRegistered(true);
+    }
   }
   if (PickupWidget)
   {
@@ -56,12 +123,36 @@ void AWeapon::BeginPlay()
   }
 }
 
+void AWeapon::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+  SetPickupRegistered(false);
+
+  Super::EndPlay(EndPlayReason);
+}
+
+void AWeapon::SetPickupRegistered(bool bRegistered)
+{
+  if (!HasAuthority()) return;
+
+  if (UBlasterInteractionSubsystem* Interaction = GetWorld()->GetSubsystem<UBlasterInteractionSubsystem>())
+  {
+    if (bRegistered)
+    {
+      Interaction->RegisterPickup(this);
+    }
+    else
+    {
+      Interaction->UnregisterPickup(this);
+    }
+  }
+}
+
 void AWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
   Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
   DOREPLIFETIME(AWeapon, WeaponState);
-  DOREPLIFETIME(AWeapon, Ammo);
+  DOREPLIFETIME(AWeapon, WeaponId);
 }
 
 void AWeapon::ShowPickupWidget(bool bShowWidget)
@@ -74,22 +165,24 @@ void AWeapon::ShowPickupWidget(bool bShowWidget)
 
 void AWeapon::SetWeaponState(EWeaponState state)
 {
+  if (HasAuthority() && state != EWeaponState::EWS_Dropped)
+  {
+    GetWorldTimerManager().ClearTimer(DormancyTimer);
+    SetNetDormancy(DORM_Awake);
+  }
   WeaponState = state;
 
   switch (WeaponState)
   {
   case EWeaponState::EWS_Equipped:
     ShowPickupWidget(false);
-    AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    SetPickupRegistered(false);
     WeaponMesh->SetSimulatePhysics(false);
     WeaponMesh->SetEnableGravity(false);
     WeaponMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
     break;
   case EWeaponState::EWS_Dropped:
-    if (HasAuthority())
-    {
-      AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-    }
+    SetPickupRegistered(true);
     WeaponMesh->SetSimulatePhysics(true);
     WeaponMesh->SetEnableGravity(true);
     WeaponMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
@@ -97,22 +190,6 @@ void AWeapon::SetWeaponState(EWeaponState state)
   }
 }
 
-void AWeapon::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
-{
-  if (ABlasterCharacter* BlasterCharacter = Cast<ABlasterCharacter>(OtherActor))
-  {
-    BlasterCharacter->SetOverlappingWeapon(this);
-  }
-}
-
-void AWeapon::OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
-{
-  if (ABlasterCharacter* BlasterCharacter = Cast<ABlasterCharacter>(OtherActor))
-  {
-    BlasterCharacter->SetOverlappingWeapon(nullptr);
-  }
-}
-
 void AWeapon::OnRep_WeaponState()
 {
   switch (WeaponState)
@@ -131,13 +208,46 @@ void AWeapon::OnRep_WeaponState()
   }
 }
 
-void AWeapon::Fire(const FVector& HitTarget)
+void AWeapon::SetDefinition(UWeaponDefinition* NewDefinition)
+{
+  if (!HasAuthority()) return;
+
+  Definition = NewDefinition;
+  WeaponId = Definition ? Definition->WeaponId : 0;
+  Ammo = FMath::Min(Ammo, GetMagCapacity());
+  SetHUDAmmo();
+}
+
+void AWeapon::OnRep_WeaponId()
 {
-  if (FireAnimation)
+  // Weapons placed with the right definition already have it, only a changed one has to be looked up
+  if (Definition && Definition->WeaponId == WeaponId) return;
+
+  Definition = UWeaponDefinition::FindById(WeaponId);
+  if (Definition == nullptr && WeaponId != 0)
   {
-    WeaponMesh->PlayAnimation(FireAnimation, false);
+    UE_LOG(LogTemp, Warning, TEXT("%s: no weapon definition with id %d is loaded, add it to the arsenal"), *GetName(), WeaponId);
   }
-  if (CasingClass)
+}
+
+int32 AWeapon::GetMagCapacity() const
+{
+  return Definition ? Definition->MagCapacity : 0;
+}
+
+void AWeapon::Fire(const FVector& HitTarget, uint16 FireSeed)
+{
+  LLM_SCOPE_BYTAG(Blaster_Effects);
+
+  const UWeaponDefinition* WeaponDefinition = GetDefinition();
+  const bool bCosmetics = WeaponDefinition && !BlasterServerLean::IsEnabled();
+  UAnimationAsset* Animation = bCosmetics ? BlasterAssets::Get(WeaponDefinition->FireAnimation) : nullptr;
+  if (Animation)
+  {
+    WeaponMesh->PlayAnimation(Animation, false);
+  }
+  UClass* Casing = bCosmetics ? BlasterAssets::Get(WeaponDefinition->CasingClass) : nullptr;
+  if (Casing)
   {
     const USkeletalMeshSocket* AmmoEjectSocket = WeaponMesh->GetSocketByName(FName("AmmoEject"));
     if (AmmoEjectSocket)
@@ -147,15 +257,20 @@ void AWeapon::Fire(const FVector& HitTarget)
       UWorld* World = GetWorld();
       if (World)
       {
+        LLM_SCOPE_BYTAG(Blaster_Effects);
         World->SpawnActor<ACasing>(
-          CasingClass,
+          Casing,
           SocketTransform.GetLocation(),
           SocketTransform.GetRotation().Rotator()
         );
       }
     }
   }
-  SpendRound();
+  // The owning client already spent the round in PredictShot, other clients do not track ammo
+  if (HasAuthority())
+  {
+    SpendRound();
+  }
 }
 
 void AWeapon::Dropped()
@@ -166,6 +281,43 @@ void AWeapon::Dropped()
   SetOwner(nullptr);
   BlasterOwnerCharacter = nullptr;
   BlasterOwnerController = nullptr;
+
+  if (HasAuthority())
+  {
+    GetWorldTimerManager().SetTimer(
+      DormancyTimer,
+      this,
+      &AWeapon::DormancyTimerFinished,
+      DroppedDormancyDelay
+    );
+  }
+}
+
+void AWeapon::DormancyTimerFinished()
+{
+  if (WeaponState == EWeaponState::EWS_Dropped)
+  {
+    SetNetDormancy(DORM_DormantAll);
+  }
+}
+
+void AWeapon::ApplySnapshotState(EWeaponState State, const FVector& Location, bool bDormant)
+{
+  if (HasAuthority()) return;
+
+  if (WeaponState != State)
+  {
+    WeaponState = State;
+    OnRep_WeaponState();
+  }
+  if (WeaponState == EWeaponState::EWS_Dropped)
+  {
+    SetActorLocation(Location, false, nullptr, ETeleportType::TeleportPhysics);
+    if (bDormant)
+    {
+      WeaponMesh->PutRigidBodyToSleep();
+    }
+  }
 }
 
 void AWeapon::SetHUDAmmo()
@@ -183,13 +335,90 @@ void AWeapon::SetHUDAmmo()
 
 void AWeapon::SpendRound()
 {
-  Ammo = FMath::Clamp(Ammo - 1, 0, MagCapacity);
+  Ammo = FMath::Clamp(Ammo - 1, 0, GetMagCapacity());
   SetHUDAmmo();
 }
 
-void AWeapon::OnRep_Ammo()
+namespace
 {
-  BlasterOwnerCharacter = BlasterOwnerCharacter == nullptr ? Cast<ABlasterCharacter>(GetOwner()) : BlasterOwnerCharacter;
+  // Shot numbers wrap around, a is newer when it is less than half the range ahead of b
+  bool IsNewerShot(uint16 a, uint16 b)
+  {
+    return int16(a - b) > 0;
+  }
+}
+
+uint16 AWeapon::PredictShot()
+{
+  const uint16 Sequence = NextShotSequence++;
+  PendingShots.Add(Sequence);
+  ApplyPredictedAmmo();
+  return Sequence;
+}
+
+void AWeapon::ConfirmShot(uint16 Sequence)
+{
+  LastShotSequence = Sequence;
+  if (HasRemoteOwner())
+  {
+    BLASTER_COUNT_RPC(ClientAckShot);
+    ClientAckShot(Sequence);
+  }
+}
+
+void AWeapon::RejectShot(uint16 Sequence)
+{
+  LastShotSequence = Sequence;
+  SyncAmmoToOwner();
+}
+
+void AWeapon::SyncAmmoToOwner()
+{
+  if (HasAuthority() && HasRemoteOwner())
+  {
+    BLASTER_COUNT_RPC(ClientSyncAmmo);
+    ClientSyncAmmo(Ammo, LastShotSequence);
+  }
+}
+
+bool AWeapon::HasRemoteOwner() const
+{
+  const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+  return OwnerPawn && !OwnerPawn->IsLocallyControlled();
+}
+
+void AWeapon::ClientAckShot_Implementation(uint16 Sequence)
+{
+  // Acknowledgements are cumulative, every pending shot up to Sequence was fired and spent a round.
+  // An older acknowledgement arriving late matches nothing.
+  const int32 NumAcked = PendingShots.RemoveAll([Sequence](uint16 Shot) { return !IsNewerShot(Shot, Sequence); });
+  ConfirmedAmmo = FMath::Max(ConfirmedAmmo - NumAcked, 0);
+  ApplyPredictedAmmo();
+}
+
+void AWeapon::ClientSyncAmmo_Implementation(int32 ServerAmmo, uint16 Sequence)
+{
+  PendingShots.RemoveAll([Sequence](uint16 Shot) { return !IsNewerShot(Shot, Sequence); });
+  if (PendingShots.Num() == 0)
+  {
+    // A new owner continues the numbering where the server is
+    NextShotSequence = Sequence + 1;
+  }
+  ConfirmedAmmo = ServerAmmo;
+  ApplyPredictedAmmo();
+}
+
+void AWeapon::PredictRefill()
+{
+  // Shots still pending were fired before the reload, they come out of the old magazine
+  PendingShots.Reset();
+  ConfirmedAmmo = GetMagCapacity();
+  ApplyPredictedAmmo();
+}
+
+void AWeapon::ApplyPredictedAmmo()
+{
+  Ammo = FMath::Clamp(ConfirmedAmmo - PendingShots.Num(), 0, GetMagCapacity());
   SetHUDAmmo();
 }
 
@@ -216,4 +445,5 @@ void AWeapon::SetAmmo(float ammo)
 {
   Ammo = ammo;
   SetHUDAmmo();
+  SyncAmmoToOwner();
 }
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "WeaponDefinition.h"
 #include "Weapon.generated.h"
 
 class USphereComponent;
@@ -24,81 +25,109 @@ class BLASTER_API AWeapon : public AActor
 	GENERATED_BODY()
 	
 public:	
-	AWeapon();
+	AWeapon(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	virtual void OnRep_Owner() override;
 	void SetHUDAmmo();
 	void ShowPickupWidget(bool bShowWidget);
-	virtual void Fire(const FVector& HitTarget);
+	virtual void Fire(const FVector& HitTarget, uint16 FireSeed);
 
 	void SetWeaponState(EWeaponState state);
+	FORCEINLINE EWeaponState GetWeaponState() const { return WeaponState; }
+	// Client side, brings a weapon we may have never seen move in line with a late join snapshot.
+	// A dormant weapon has settled on the server and gets no more updates, it is put to rest where the snapshot says
+	void ApplySnapshotState(EWeaponState State, const FVector& Location, bool bDormant);
 	FORCEINLINE USphereComponent* GetAreaSphere() { return AreaSphere; }
 	FORCEINLINE USkeletalMeshComponent* GetWeaponMesh() const { return WeaponMesh; }
 	bool IsEmpty();
-  FORCEINLINE float GetMagCapacity() const { return MagCapacity; }
+	// Null for a weapon set up without a definition, it cannot fire
+	FORCEINLINE const UWeaponDefinition* GetDefinition() const { return Definition; }
+	// Server only, clients follow through the replicated WeaponId
+	void SetDefinition(UWeaponDefinition* NewDefinition);
+	int32 GetMagCapacity() const;
 	void SetAmmo(float ammo);
 	FORCEINLINE int32 GetAmmo() const { return Ammo; }
 
+	/**
+	* Ammo prediction. The owning client spends rounds ahead of the server, numbering each shot. The server acknowledges
+	* shot numbers instead of replicating Ammo, the client drops acknowledged shots and replays the rest on top of the
+	* last confirmed count. Reloads, refused shots and new owners get the full count.
+	*/
+
+	// Owning client, spends a round now and returns the number the server acknowledges it with
+	uint16 PredictShot();
+	// Server, the owner's shot was fired or refused
+	void ConfirmShot(uint16 Sequence);
+	void RejectShot(uint16 Sequence);
+	// Server, sends the full count to a remote owner
+	void SyncAmmoToOwner();
+	// Owning client, refills the magazine at the end of a predicted reload
+	void PredictRefill();
+
 	void Dropped();
 protected:
+	virtual void PostLoad() override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	UFUNCTION()
-	virtual void OnSphereOverlap(
-		UPrimitiveComponent* OverlappedComponent,
-		AActor* OtherActor,
-		UPrimitiveComponent* OtherComp,
-		int32 OtherBodyIndex,
-		bool bFromSweep,
-		const FHitResult& SweepResult
-	);
+	// Server, weapons that are not equipped can be picked up
+	void SetPickupRegistered(bool bRegistered);
 
 	UFUNCTION()
-	void OnSphereEndOverlap(
-		UPrimitiveComponent* OverlappedComponent,
-		AActor* OtherActor,
-		UPrimitiveComponent* OtherComp,
-		int32 OtherBodyIndex
-	);
+	void OnRep_WeaponState();
 
 	UFUNCTION()
-	void OnRep_WeaponState();
+	void OnRep_WeaponId();
+
+	// Dropped weapons stop replicating once they had time to settle
+	void DormancyTimerFinished();
+
+protected:
+	UPROPERTY(VisibleAnywhere, Category = "Weapon Properties")
+	USkeletalMeshComponent* WeaponMesh;
+
+	// Fire rate, magazine, crosshairs and effects, shared with every weapon of this kind
+	UPROPERTY(EditAnywhere, Category = "Weapon Properties")
+	UWeaponDefinition* Definition = nullptr;
+
+	UPROPERTY(ReplicatedUsing = OnRep_WeaponId)
+	uint8 WeaponId = 0;
 
-public:
 	/**
-	* Textures for the weapon crosshairs
+	* Stats and assets weapons were set up with before definitions, redirected from their old names in DefaultEngine.ini.
+	* PostLoad moves them into a transient definition for weapons that have none, until they get a definition asset.
 	*/
+	void MigrateDeprecatedProperties();
 
-	UPROPERTY(EditAnywhere, Category = Crosshairs)
-	class UTexture2D* CrosshairsCenter;
+	UPROPERTY()
+	TSoftObjectPtr<class UTexture2D> CrosshairsCenter_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, Category = Crosshairs)
-	UTexture2D* CrosshairsLeft;
+	UPROPERTY()
+	TSoftObjectPtr<UTexture2D> CrosshairsLeft_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, Category = Crosshairs)
-	UTexture2D* CrosshairsRight;
+	UPROPERTY()
+	TSoftObjectPtr<UTexture2D> CrosshairsRight_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, Category = Crosshairs)
-	UTexture2D* CrosshairsTop;
+	UPROPERTY()
+	TSoftObjectPtr<UTexture2D> CrosshairsTop_DEPRECATED;
 
-	UPROPERTY(EditAnywhere, Category = Crosshairs)
-	UTexture2D* CrosshairsBottom;
+	UPROPERTY()
+	TSoftObjectPtr<UTexture2D> CrosshairsBottom_DEPRECATED;
 
-	/**
-* Automatic fire
-*/
-	UPROPERTY(EditAnywhere, Category = Combat)
-	float FireDelay = .15f;
+	UPROPERTY()
+	float FireDelay_DEPRECATED = .15f;
 
-	UPROPERTY(EditAnywhere, Category = Combat)
-	bool bAutomatic = true;
+	UPROPERTY()
+	bool bAutomatic_DEPRECATED = true;
 
-protected:
-	UPROPERTY(VisibleAnywhere, Category = "Weapon Properties")
-	USkeletalMeshComponent* WeaponMesh;
+	UPROPERTY()
+	int32 MagCapacity_DEPRECATED = 0;
 
-	UPROPERTY(EditAnywhere, Category = "Weapon Properties")
-	class UAnimationAsset* FireAnimation;
+	UPROPERTY()
+	TSoftObjectPtr<class UAnimationAsset> FireAnimation_DEPRECATED;
+
+	UPROPERTY()
+	TSubclassOf<class ACasing> CasingClass_DEPRECATED;
 
 	UPROPERTY(VisibleAnywhere, Category = "Weapon Properties")
 	USphereComponent* AreaSphere;
@@ -106,22 +135,35 @@ protected:
 	UPROPERTY(ReplicatedUsing = OnRep_WeaponState, VisibleAnywhere, Category = "Weapon Properties")
 	EWeaponState WeaponState;
 
-	UPROPERTY(EditAnywhere)
-	TSubclassOf<class ACasing> CasingClass;
-
 	UPROPERTY(VisibleAnywhere, Category = "Weapon Properties")
 	class UWidgetComponent* PickupWidget = nullptr;
 
-	UPROPERTY(EditAnywhere, ReplicatedUsing = OnRep_Ammo)
+	UPROPERTY(EditAnywhere)
 	int32 Ammo;
 
-	UFUNCTION()
-	void OnRep_Ammo();
-
 	void SpendRound();
 
-	UPROPERTY(EditAnywhere)
-	int32 MagCapacity;
+	UFUNCTION(Client, Unreliable)
+	void ClientAckShot(uint16 Sequence);
+
+	UFUNCTION(Client, Reliable)
+	void ClientSyncAmmo(int32 ServerAmmo, uint16 Sequence);
+
+	void ApplyPredictedAmmo();
+	bool HasRemoteOwner() const;
+
+	// Owning client: Ammo is ConfirmedAmmo minus the shots the server has not acknowledged yet
+	int32 ConfirmedAmmo = 0;
+	TArray<uint16> PendingShots;
+	uint16 NextShotSequence = 1;
+
+	// Server: last shot of the current owner that was fired or refused
+	uint16 LastShotSequence = 0;
+
+	FTimerHandle DormancyTimer;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Properties")
+	float DroppedDormancyDelay = 5.f;
 
 	UPROPERTY()
 	class ABlasterCharacter* BlasterOwnerCharacter;
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponDefinition.h"
+
+namespace
+{
+	TMap<uint8, TWeakObjectPtr<UWeaponDefinition>> DefinitionsById;
+
+	// Bounds the table for curves with keys very far out
+	constexpr int32 MaxFalloffSamples = 256;
+}
+
+FPrimaryAssetId UWeaponDefinition::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(TEXT("WeaponDefinition"), GetFName());
+}
+
+void UWeaponDefinition::PostLoad()
+{
+	Super::PostLoad();
+
+	BuildDerivedData();
+	Register();
+}
+
+void UWeaponDefinition::BeginDestroy()
+{
+	if (WeaponId != 0 && DefinitionsById.FindRef(WeaponId) == this)
+	{
+		DefinitionsById.Remove(WeaponId);
+	}
+
+	Super::BeginDestroy();
+}
+
+#if WITH_EDITOR
+void UWeaponDefinition::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Weapons read through their pointer, an edit shows up on every weapon of this kind right away
+	BuildDerivedData();
+	Register();
+}
+#endif
+
+UWeaponDefinition* UWeaponDefinition::FindById(uint8 Id)
+{
+	return Id != 0 ? DefinitionsById.FindRef(Id).Get() : nullptr;
+}
+
+void UWeaponDefinition::Register()
+{
+	if (WeaponId == 0 || HasAnyFlags(RF_ClassDefaultObject)) return;
+
+	for (auto It = DefinitionsById.CreateIterator(); It; ++It)
+	{
+		if (It.Value() == this && It.Key() != WeaponId)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const UWeaponDefinition* Existing = DefinitionsById.FindRef(WeaponId).Get();
+	if (Existing && Existing != this)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon definitions %s and %s share WeaponId %d"), *Existing->GetName(), *GetName(), WeaponId);
+		return;
+	}
+	DefinitionsById.Add(WeaponId, this);
+}
+
+void UWeaponDefinition::BuildDerivedData()
+{
+	FalloffTable.Reset();
+
+	const FRichCurve* Curve = DamageFalloff.GetRichCurveConst();
+	if (Curve == nullptr || Curve->GetNumKeys() == 0) return;
+
+	float MinDistance, MaxDistance;
+	Curve->GetTimeRange(MinDistance, MaxDistance);
+	const int32 NumSamples = FMath::Clamp(FMath::CeilToInt(MaxDistance / FalloffSampleDistance) + 1, 1, MaxFalloffSamples);
+	FalloffTable.SetNumUninitialized(NumSamples);
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		FalloffTable[Index] = Curve->Eval(Index * FalloffSampleDistance);
+	}
+}
+
+float UWeaponDefinition::GetDamageMultiplier(float Distance) const
+{
+	if (FalloffTable.Num() == 0) return 1.f;
+
+	const float Sample = FMath::Max(Distance, 0.f) / FalloffSampleDistance;
+	const int32 Index = FMath::FloorToInt(Sample);
+	if (Index >= FalloffTable.Num() - 1) return FalloffTable.Last();
+
+	return FMath::Lerp(FalloffTable[Index], FalloffTable[Index + 1], Sample - Index);
+}
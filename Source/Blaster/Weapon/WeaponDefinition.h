@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Curves/CurveFloat.h"
+#include "WeaponDefinition.generated.h"
+
+class UTexture2D;
+class UAnimationAsset;
+class ACasing;
+
+/**
+* Stats and assets shared by every weapon of a kind, as primary asset WeaponDefinition. Weapons point at one and only
+* replicate its WeaponId, FindById resolves it. Treated as immutable at runtime, derived tables are rebuilt on load
+* and whenever the asset is edited, so balance changes need no code or blueprint changes.
+*/
+UCLASS()
+class BLASTER_API UWeaponDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+	virtual void PostLoad() override;
+	virtual void BeginDestroy() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Loaded definition with this id, nullptr when none is loaded
+	static UWeaponDefinition* FindById(uint8 Id);
+
+	// Damage multiplier for a hit this many cm from the muzzle
+	float GetDamageMultiplier(float Distance) const;
+
+	// Unique per definition, 0 is reserved for none
+	UPROPERTY(EditDefaultsOnly, Category = Identity)
+	uint8 WeaponId = 0;
+
+	/**
+	* Automatic fire
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	float FireDelay = .15f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	bool bAutomatic = true;
+
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	int32 MagCapacity = 30;
+
+	// Damage multiplier over distance in cm, no keys means no falloff
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	FRuntimeFloatCurve DamageFalloff;
+
+	// Distance between the baked samples of DamageFalloff
+	UPROPERTY(EditDefaultsOnly, Category = Combat, meta = (ClampMin = "10"))
+	float FalloffSampleDistance = 100.f;
+
+	/**
+	* Pellets of hitscan multi pellet weapons
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = Pellets, meta = (ClampMin = "1"))
+	int32 NumPellets = 1;
+
+	// Half angle of the spread cone in degrees
+	UPROPERTY(EditDefaultsOnly, Category = Pellets)
+	float PelletSpread = 6.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Pellets)
+	float PelletRange = 5000.f;
+
+	// Damage of one pellet before falloff
+	UPROPERTY(EditDefaultsOnly, Category = Pellets)
+	float PelletDamage = 10.f;
+
+	/**
+	* Textures for the weapon crosshairs
+	*/
+
+	UPROPERTY(EditDefaultsOnly, Category = Crosshairs)
+	TSoftObjectPtr<UTexture2D> CrosshairsCenter;
+
+	UPROPERTY(EditDefaultsOnly, Category = Crosshairs)
+	TSoftObjectPtr<UTexture2D> CrosshairsLeft;
+
+	UPROPERTY(EditDefaultsOnly, Category = Crosshairs)
+	TSoftObjectPtr<UTexture2D> CrosshairsRight;
+
+	UPROPERTY(EditDefaultsOnly, Category = Crosshairs)
+	TSoftObjectPtr<UTexture2D> CrosshairsTop;
+
+	UPROPERTY(EditDefaultsOnly, Category = Crosshairs)
+	TSoftObjectPtr<UTexture2D> CrosshairsBottom;
+
+	UPROPERTY(EditDefaultsOnly, Category = Effects)
+	TSoftObjectPtr<UAnimationAsset> FireAnimation;
+
+	UPROPERTY(EditDefaultsOnly, Category = Effects)
+	TSoftClassPtr<ACasing> CasingClass;
+
+private:
+	void BuildDerivedData();
+	void Register();
+
+	// DamageFalloff sampled every FalloffSampleDistance, empty without falloff
+	TArray<float> FalloffTable;
+};